@@ -1,4 +1,8 @@
-%VK_SDK_PATH%\Bin32\glslangValidator.exe -V %~dp0shader.vert
-%VK_SDK_PATH%\Bin32\glslangValidator.exe -V %~dp0shader.frag
+%VK_SDK_PATH%\Bin32\glslangValidator.exe -V %~dp0shader.vert -o %~dp0vert.spv
+%VK_SDK_PATH%\Bin32\glslangValidator.exe -V %~dp0shader.frag -o %~dp0frag.spv
+%VK_SDK_PATH%\Bin32\glslangValidator.exe -V %~dp0shader_bindless.frag -o %~dp0frag_bindless.spv
+%VK_SDK_PATH%\Bin32\glslangValidator.exe -V %~dp0mipgen.comp -o %~dp0mipgen.spv
 COPY "%~dp0vert.spv" "%~dp0..\..\..\x64\Debug\content\shader\vert.spv"
-COPY "%~dp0frag.spv" "%~dp0..\..\..\x64\Debug\content\shader\frag.spv"
\ No newline at end of file
+COPY "%~dp0frag.spv" "%~dp0..\..\..\x64\Debug\content\shader\frag.spv"
+COPY "%~dp0frag_bindless.spv" "%~dp0..\..\..\x64\Debug\content\shader\frag_bindless.spv"
+COPY "%~dp0mipgen.spv" "%~dp0..\..\..\x64\Debug\content\shader\mipgen.spv"
\ No newline at end of file
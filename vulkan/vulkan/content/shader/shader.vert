@@ -1,14 +1,21 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(binding = 0) uniform UniformBufferObject {
-	mat4 model;
+// Shared by every draw of the frame
+layout(set = 0, binding = 0) uniform FrameUniforms {
 	mat4 view;
 	mat4 proj;
-} ubo;
+} frame;
+// Per draw, matches PushConstantObject
+layout(push_constant) uniform DrawConstants {
+	mat4 model;
+	uint materialIndex;
+	uint textureIndex;
+} draw;
 layout(location = 0) in vec2 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
 
 out gl_PerVertex {
     vec4 gl_Position;
@@ -16,6 +23,7 @@ out gl_PerVertex {
 
 void main() 
 {
-    gl_Position = vec4(inPosition, 0.0, 1.0);
+    gl_Position = frame.proj * frame.view * draw.model * vec4(inPosition, 0.0, 1.0);
     fragColor = inColor;
+    fragTexCoord = inPosition + vec2(0.5);
 }
\ No newline at end of file
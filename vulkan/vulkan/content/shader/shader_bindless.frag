@@ -0,0 +1,42 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+// Specialization constants, declared in ShaderOptions (VulkanApplication.cpp)
+layout(constant_id = 0) const bool VERTEX_COLOR = true;
+layout(constant_id = 1) const bool GRAYSCALE = false;
+
+// Matches MaterialBufferObject
+struct Material {
+	vec4 tint;
+};
+// Bindless table, indexed by the draw's material index
+layout(set = 1, binding = 0) readonly buffer MaterialBuffer {
+	Material material;
+} materials[];
+layout(set = 1, binding = 1) uniform sampler2D textures[];
+
+layout(push_constant) uniform DrawConstants {
+	mat4 model;
+	uint materialIndex;
+	uint textureIndex;
+} draw;
+
+void main() {
+	vec3 color = VERTEX_COLOR ? fragColor : vec3(1.0);
+	if (GRAYSCALE)
+	{
+		color = vec3(dot(color, vec3(0.299, 0.587, 0.114)));
+	}
+	outColor = vec4(color, 1.0) * materials[nonuniformEXT(draw.materialIndex)].material.tint;
+	// ~0u is InvalidBindlessIndex, the draw has no texture
+	if (draw.textureIndex != 0xFFFFFFFFu)
+	{
+		outColor *= texture(textures[nonuniformEXT(draw.textureIndex)], fragTexCoord);
+	}
+}
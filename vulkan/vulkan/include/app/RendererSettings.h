@@ -0,0 +1,161 @@
+//-----------------------------------------------------------------------------
+#ifndef _RENDERERSETTINGS_H_
+#define _RENDERERSETTINGS_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#pragma endregion
+//-----------------------------------------------------------------------------
+// Startup options of the renderer. Requested features the device can't do
+// are turned off at init with a message, never a failure.
+struct RendererSettings
+{
+	// Materials index one big descriptor array through push constants instead
+	// of binding a set per draw. Needs VK_EXT_descriptor_indexing or Vulkan 1.2.
+	bool Bindless = false;
+	// NAME=VALUE pairs from --shader-option, see ShaderOptions
+	std::vector<std::pair<std::string, uint32_t>> ShaderOptions;
+	// Recompile content/shader sources when they are saved and swap the
+	// pipelines in without a restart
+	bool ShaderHotReload = false;
+	// KTX2 files (BCn, prebuilt mips) streamed under TextureBudgetMB of device memory
+	// RGBA8 KTX2 files without mips get them from a compute pass at load
+	std::vector<std::string> Textures;
+	uint32_t TextureBudgetMB = 256;
+	// --import-texture IN OUT: RGBA8 KTX2 in, mipped BCn KTX2 out, before anything loads
+	std::vector<std::pair<std::string, std::string>> TextureImports;
+	// bc1 (RGB, 4 bpp) or bc7 (RGBA, 8 bpp)
+	std::string TextureEncoding = "bc7";
+	// Frames the CPU may record ahead of the GPU, 1 to 4. Each one owns its
+	// command buffer, uniforms and descriptors, whatever the swap chain holds.
+	uint32_t FramesInFlight = 2;
+	// Swap chain images to ask for, 0 keeps the surface minimum plus one
+	uint32_t SwapChainImages = 0;
+	// Wait for the GPU and the next image before polling input rather than
+	// after, the frame is then recorded from the freshest input
+	bool LowLatency = false;
+	// lowest-latency, power-saving or fifo-relaxed, see render::PresentProfile
+	std::string PresentProfile = "lowest-latency";
+	// Frames per second, 0 is uncapped (power-saving defaults to 30)
+	float FrameCap = 0.0f;
+	// Print the memory heaps every N frames, 0 never
+	uint32_t MemoryReportInterval = 0;
+	// Sync frames with a timeline semaphore when the device has them, fences
+	// and binary semaphores otherwise (--binary-sync forces those)
+	bool TimelineSemaphores = true;
+	// GPU to run on, by enumeration index or part of its name; empty picks
+	// the best scoring one (see render::DeviceSelector)
+	std::string Device;
+	// Time every GPU at startup to score them, cached in content/device_cache.txt
+	bool DeviceBenchmark = false;
+	// Read frame CaptureFrame back (0 never), write it to CapturePath (.png
+	// or .ppm) and close. With a GoldenImage (PPM) the capture is compared
+	// to it and the exit code fails past GoldenTolerance, the mean error per
+	// channel in 0 - 255 steps. The frame is drawn into an offscreen target
+	// and the window is hidden, but there is no headless surface path: a
+	// window system that can create a surface and a swap chain is needed.
+	uint32_t CaptureFrame = 0;
+	std::string CapturePath = "capture.png";
+	std::string GoldenImage;
+	float GoldenTolerance = 1.0f;
+
+	static RendererSettings FromCommandLine(int argc, char** argv)
+	{
+		RendererSettings settings;
+		for (int i = 1; i < argc; i++)
+		{
+			if (strcmp(argv[i], "--bindless") == 0)
+			{
+				settings.Bindless = true;
+			}
+			else if (strcmp(argv[i], "--hot-reload") == 0)
+			{
+				settings.ShaderHotReload = true;
+			}
+			else if (strcmp(argv[i], "--low-latency") == 0)
+			{
+				settings.LowLatency = true;
+			}
+			else if (strcmp(argv[i], "--binary-sync") == 0)
+			{
+				settings.TimelineSemaphores = false;
+			}
+			else if (strcmp(argv[i], "--device-benchmark") == 0)
+			{
+				settings.DeviceBenchmark = true;
+			}
+			else if (strcmp(argv[i], "--device") == 0 && i + 1 < argc)
+			{
+				settings.Device = argv[++i];
+			}
+			else if (strcmp(argv[i], "--capture-frame") == 0 && i + 1 < argc)
+			{
+				settings.CaptureFrame = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 0));
+			}
+			else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+			{
+				settings.CapturePath = argv[++i];
+			}
+			else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc)
+			{
+				settings.GoldenImage = argv[++i];
+			}
+			else if (strcmp(argv[i], "--golden-tolerance") == 0 && i + 1 < argc)
+			{
+				settings.GoldenTolerance = static_cast<float>(atof(argv[++i]));
+			}
+			else if (strcmp(argv[i], "--present") == 0 && i + 1 < argc)
+			{
+				settings.PresentProfile = argv[++i];
+			}
+			else if (strcmp(argv[i], "--memory-report") == 0 && i + 1 < argc)
+			{
+				settings.MemoryReportInterval = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 0));
+			}
+			else if (strcmp(argv[i], "--frame-cap") == 0 && i + 1 < argc)
+			{
+				settings.FrameCap = static_cast<float>(atof(argv[++i]));
+			}
+			else if (strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc)
+			{
+				settings.FramesInFlight = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 0));
+			}
+			else if (strcmp(argv[i], "--swapchain-images") == 0 && i + 1 < argc)
+			{
+				settings.SwapChainImages = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 0));
+			}
+			else if (strcmp(argv[i], "--texture") == 0 && i + 1 < argc)
+			{
+				settings.Textures.push_back(argv[++i]);
+			}
+			else if (strcmp(argv[i], "--import-texture") == 0 && i + 2 < argc)
+			{
+				settings.TextureImports.push_back({ argv[i + 1], argv[i + 2] });
+				i += 2;
+			}
+			else if (strcmp(argv[i], "--texture-encoding") == 0 && i + 1 < argc)
+			{
+				settings.TextureEncoding = argv[++i];
+			}
+			else if (strcmp(argv[i], "--texture-budget") == 0 && i + 1 < argc)
+			{
+				settings.TextureBudgetMB = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 0));
+			}
+			else if (strcmp(argv[i], "--shader-option") == 0 && i + 1 < argc)
+			{
+				std::string option = argv[++i];
+				size_t separator = option.find('=');
+				std::string value = separator != std::string::npos ? option.substr(separator + 1) : "1";
+				settings.ShaderOptions.push_back({ option.substr(0, separator), static_cast<uint32_t>(strtoul(value.c_str(), nullptr, 0)) });
+			}
+		}
+		return settings;
+	}
+};
+#endif // !_RENDERERSETTINGS_H_
+//-----------------------------------------------------------------------------
@@ -16,6 +16,9 @@
 #include <map>
 #include <set>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <functional>
 #pragma endregion
 #pragma region Vulkan include
 #include <vulkan/vk_icd.h>
@@ -28,6 +31,33 @@
 #include <GLFW/glfw3.h>
 #include <GLFW/glfw3native.h>
 #include "FileHelper.h"
+#include "app/RendererSettings.h"
+#include "core/FramePacer.h"
+#include "core/JobSystem.h"
+#include "render/BindlessTable.h"
+#include "render/ComputeQueue.h"
+#include "render/DeletionQueue.h"
+#include "render/DescriptorAllocator.h"
+#include "render/DeviceFeatures.h"
+#include "render/DeviceSelector.h"
+#include "render/DrawQueue.h"
+#include "render/FrameReadback.h"
+#include "render/GeometryPool.h"
+#include "render/ImageFile.h"
+#include "render/LayoutCache.h"
+#include "render/MemoryTelemetry.h"
+#include "render/MemoryTypeSelector.h"
+#include "render/MipGenerator.h"
+#include "render/PipelineManager.h"
+#include "render/PresentPolicy.h"
+#include "render/RenderGraph.h"
+#include "render/ShaderPermutation.h"
+#include "render/ShaderReflection.h"
+#include "render/ShaderReloader.h"
+#include "render/StagingRing.h"
+#include "render/TextureImporter.h"
+#include "render/TextureStreamer.h"
+#include "render/TimelineSync.h"
 
 #include "geom/Indices.h"
 #include "geom/Vertex.h"
@@ -39,20 +69,58 @@ struct QueueFamilyIndices
 {
 	uint32_t GraphicsFamily	= -1;
 	uint32_t PresentFamily	= -1;
+	// A compute-only family when there is one, GraphicsFamily otherwise
+	uint32_t ComputeFamily	= -1;
 	bool IsComplete()
 	{
 		return GraphicsFamily >= 0 && PresentFamily >= 0;
 	}
 };
-
 //-----------------------------------------------------------------------------
-struct UniformTransformBufferObject
+// An image whose levels 1.. are still to be generated, level 0 is in
+// TRANSFER_DST_OPTIMAL
+struct MipChainRequest
+{
+	VkImage Image		= VK_NULL_HANDLE;
+	VkExtent2D Extent	= {};
+	uint32_t LevelCount	= 1;
+};
+//-----------------------------------------------------------------------------
+// A texture draws can sample, in Settings.Textures order. Bindless mode only.
+struct SampledTexture
+{
+	// InvalidTextureHandle for the mipmapped ones, their View never changes
+	render::TextureHandle Streamed	= render::InvalidTextureHandle;
+	VkImageView View				= VK_NULL_HANDLE;
+	// Bindless slot per frame in flight and the view it holds, only that
+	// frame's slot is rewritten when the streamer swaps the view
+	std::vector<uint32_t> Slots;
+	std::vector<VkImageView> SlotViews;
+};
+//-----------------------------------------------------------------------------
+// Per frame in flight, shared by every draw of the frame (set 0, binding 0)
+struct UniformFrameBufferObject
 {
-	glm::mat4 model;
 	glm::mat4 view;
 	glm::mat4 proj;
 };
 //-----------------------------------------------------------------------------
+// Per draw, pushed inline with vkCmdPushConstants. Keep it within the 128
+// bytes every implementation guarantees.
+struct PushConstantObject
+{
+	glm::mat4 model;
+	uint32_t materialIndex;
+	// InvalidBindlessIndex when the draw samples nothing
+	uint32_t textureIndex;
+};
+//-----------------------------------------------------------------------------
+// One entry of the bindless material array
+struct MaterialBufferObject
+{
+	glm::vec4 tint;
+};
+//-----------------------------------------------------------------------------
 struct SwapChainSupportDetails
 {
 	VkSurfaceCapabilitiesKHR Capabilities;
@@ -96,15 +164,25 @@ static void DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMesse
 class VulkanApplication
 {
 public:
-	VulkanApplication();
+	VulkanApplication(const RendererSettings& settings = RendererSettings());
 	~VulkanApplication();
 
 	void Start();
 	void Loop() ;
-	void Cleanup() const;
+	void Cleanup();
 
 	bool framebufferResized = false;
 
+	core::JobSystem& GetJobSystem() { return Jobs; }
+	// Non zero when the golden image comparison failed
+	const int32_t GetExitCode() const { return ExitCode; }
+
+	// Records a dispatch on AsyncCompute and submits it, at most once per
+	// frame and from the render thread; the next graphics submit waits for
+	// it at consumerStage. Buffers and images shared exclusively with
+	// graphics need ComputeQueue ownership transfers.
+	void SubmitAsyncCompute(const std::function<void(VkCommandBuffer)>& record, VkPipelineStageFlags consumerStage);
+
 private:
 
 	// Initialization funcs
@@ -112,7 +190,8 @@ private:
 	void InitVulkan();
 	const bool CheckValidationLayerSupport() const;
 	const bool CheckDeviceExtensionSupport(const VkPhysicalDevice& device) const;
-	void CreateInstance() const;
+	void CreateInstance();
+	// Highest render::DeviceSelector score, or Settings.Device
 	void PickPhysicalDevice();
 	void ListVulkanExtensions() const;
 	// Extension support
@@ -123,6 +202,9 @@ private:
 	const VkExtent2D ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
 	const QueueFamilyIndices FindQueueFamilies(const VkPhysicalDevice& device);
 	const bool IsDeviceSuitable(const VkPhysicalDevice& device);
+	// Fills features with what bindless mode enables, needsExtension is false
+	// when descriptor indexing comes from Vulkan 1.2 core
+	const bool CheckBindlessSupport(const VkPhysicalDevice& device, VkPhysicalDeviceDescriptorIndexingFeaturesEXT& features, bool& needsExtension);
 #pragma region Creation 
 	void CreateLogicalDevice();
 	void CreateVulkanSurface();
@@ -134,67 +216,198 @@ private:
 	void CreateFramebuffers();
 	void CreateCommandPool();
 	void CreateCommandBuffers();
+	void BuildDrawQueue();
+	// Touches the texture and returns its bindless index for this frame,
+	// InvalidBindlessIndex until something is resident
+	const uint32_t ReferenceTexture(size_t texture);
+	// After Streamer->Update, writes the views it left into the frame's slots
+	void UpdateTextureSlots();
+	void RecordCommandBuffer(uint32_t imageIndex);
+	// The draw queue in VKRenderPass, into the back buffer or the capture target
+	void RecordMainPass(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer);
+	// Generates PendingMipChains on AsyncCompute and takes the images back
+	// in the frame's command buffer
+	void GenerateMips(VkCommandBuffer commandBuffer);
+	// Also creates AsyncCompute, on top of the sync backend
 	void CreateSemaphores();
-	void CreateVertexBuffer();
+	// Adds the quad to Geometry
+	void CreateGeometry();
 	void CreateBuffer(const VkDeviceSize size, const VkBufferUsageFlags usage, const VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
-	void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
-	void CreateIndexBuffer();
+	void CreateBuffer(const VkDeviceSize size, const VkBufferUsageFlags usage, const render::MemoryRequest& memory, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+	// Fills a pool range. Written through its mapping on UMA and resizable
+	// BAR devices, through a staging copy otherwise.
+	void WriteBuffer(const render::BufferRange& range, const void* data);
+	// Copies data into UploadRing, or into a buffer of its own (returned in
+	// ownMemory) when the ring is full. Pass both to ReleaseStaging once the
+	// copy has completed.
+	const render::BufferRange StageData(const void* data, const VkDeviceSize size, VkDeviceMemory& ownMemory);
+	void ReleaseStaging(const render::BufferRange& range, VkDeviceMemory ownMemory);
+	void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset = 0, VkDeviceSize srcOffset = 0);
 	void CreateDescriptorSetLayout();
 	void CreateUniformBuffer();
+	void CreateDescriptorAllocators();
+	void CreateBindlessTable();
+	void ImportTextures();
+	void CreateTextures();
+	void CreateMipmappedTexture(const render::Ktx2File& file);
 #pragma endregion
 
 #pragma region Update
 
 	void DrawFrame();
-	void UpdateUniformBuffer(uint32_t currentImage);
+	// Waits for the current frame's fence and acquires the next image. False
+	// when the swap chain had to be recreated and the frame is skipped.
+	const bool AcquireFrame(uint32_t& imageIndex);
+	// Swaps in the shaders the reloader rebuilt, called between frames
+	void ApplyShaderReloads();
+	// Writes the capture this frame slot read back, if any, and compares it
+	// to the golden image. Once the slot's fence signaled.
+	void CollectReadback();
+	void UpdateUniformBuffer(uint32_t currentFrame);
 	void RecreateSwapChain();
-	void CleanupSwapChain() const;
+	void CleanupSwapChain();
 #pragma endregion
 	VkShaderModule CreateShaderModule(const std::vector<char>& code);
 	void SetupDebugCallback() const;
-	const int32_t RateDeviceSuitability(const VkPhysicalDevice& device) const;
 
+	// vkFreeMemory for what CreateBuffer and the texture code allocated
+	void FreeMemory(VkDeviceMemory memory) const;
+	// Per frame: refreshes the heap budgets and keeps the streamer inside them
+	void UpdateMemoryTelemetry();
+	// See MemoryRequest::Exactly
 	const uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
 private:
 	
+	RendererSettings Settings;
+	// Settings.Bindless and the device supports it
+	bool BindlessEnabled = false;
+	// Settings.Textures were given and the device samples BCn formats
+	bool TextureCompressionBCEnabled = false;
+	uint32_t InstanceApiVersion = VK_API_VERSION_1_0;
+
 	const int WIDTH = 800;
 	const int HEIGHT = 600;
-	const int MAX_FRAMES_IN_FLIGHT = 2;
+	static const uint32_t MaxFramesInFlight = 4;
+	// Settings.FramesInFlight clamped to [1, MaxFramesInFlight], sizes every per frame ring
+	uint32_t FramesInFlight = 2;
 	size_t CurrentFrame = 0;
 
+	// Present mode and frame cap from Settings.PresentProfile / FrameCap
+	render::PresentPolicy Presentation;
+	// Sleeps to the frame cap before each frame and records the present jitter
+	core::FramePacer Pacer;
+
+	// Time to first frame is measured from Start() to the first successful present
+	std::chrono::high_resolution_clock::time_point StartTime;
+	bool FirstFramePresented = false;
+
+	// Worker pool for culling, transform updates, command recording and asset decoding
+	core::JobSystem Jobs;
 	
-	// GH Add this to questions. How mutable should be handled?
-	// Should mutable be abused? Is it even const correct to do that?
+	// GH Add this to questions. How should be handled?
+	// Should be abused? Is it even const correct to do that?
 	mutable GLFWwindow*  Window;
+	// Read on the main thread, GLFW doesn't allow it from the init workers
+	int FramebufferWidth = 0;
+	int FramebufferHeight = 0;
 #pragma region Vulkan Vars
 	mutable VkInstance VKInstance;
 	mutable VkDebugUtilsMessengerEXT callback;
-	VkPhysicalDeviceProperties VKDeviceProperties;
-	VkPhysicalDeviceFeatures VKDeviceFeatures;
+	// Every GPU and its score, VKPhysicalDevice is its pick
+	std::unique_ptr<render::DeviceSelector> Devices;
 	VkPhysicalDevice VKPhysicalDevice;
+	// Memory types of VKPhysicalDevice, ranked per request
+	std::unique_ptr<render::MemoryTypeSelector> MemoryTypes;
+	// VK_EXT_memory_budget is enabled, Telemetry estimates otherwise
+	bool MemoryBudgetEnabled = false;
+	// Settings.TimelineSemaphores and the device supports them
+	bool TimelineEnabled = false;
+	std::unique_ptr<render::MemoryTelemetry> Telemetry;
+	uint64_t FrameNumber = 0;
+	// Frames actually recorded, an acquire that had to recreate the swap
+	// chain does not count. Drives the capture, and the animation while
+	// capturing.
+	uint64_t RecordedFrames = 0;
+	bool CaptureRecorded = false;
 	VkDevice VKDevice;
 	VkQueue VKGraphicsQueue;
 	VkSurfaceKHR VKSurface;
 	VkQueue VKPresentQueue;
-	VkSwapchainKHR VKSwapChain;
+	// Same as VKGraphicsQueue when there is no separate compute family
+	VkQueue VKComputeQueue;
+	VkSwapchainKHR VKSwapChain = VK_NULL_HANDLE;
 	std::vector<VkImage> VKSwapChainImages;
 	VkFormat VKSwapChainImageFormat;
 	VkExtent2D VKSwapChainExtent;
 	VkRenderPass VKRenderPass;
-	VkPipeline VKGraphicsPipeline;
+	// Compiled on the workers, FallbackPipeline (plain vertex colors) is built
+	// up front and drawn with until MainPipeline is ready
+	std::unique_ptr<render::PipelineManager> Pipelines;
+	render::PipelineHandle MainPipeline = render::InvalidPipelineHandle;
+	render::PipelineHandle FallbackPipeline = render::InvalidPipelineHandle;
+	render::GraphicsPipelineDesc MainPipelineDesc;
+	render::GraphicsPipelineDesc FallbackPipelineDesc;
+	// Hot reload only. Replaced modules are forgotten by Pipelines and go
+	// through Deletions.
+	std::unique_ptr<render::ShaderReloader> ShaderReload;
+	// Layouts are built from the reflected shaders and owned by Layouts
+	std::unique_ptr<render::LayoutCache> Layouts;
+	render::ShaderReflection PipelineInterface;
+	// Per stage of the main pipeline, PipelineInterface is their merge
+	render::ShaderReflection VertShaderReflection;
+	render::ShaderReflection FragShaderReflection;
 	VkDescriptorSetLayout VKDescriptorSetLayout;
+	std::vector<VkDescriptorSetLayoutBinding> VKDescriptorSetLayoutBindings;
 	VkPipelineLayout VKPipelineLayout;
+	// Loaded once at init, the pipeline is rebuilt from them on swap chain recreation
+	VkShaderModule VKVertShaderModule;
+	VkShaderModule VKFragShaderModule;
+	VkShaderModule VKBindlessFragShaderModule = VK_NULL_HANDLE;
+	// Touched by the draws sampling them, the streamer keeps their mips
+	// within the budget
+	std::unique_ptr<render::TextureStreamer> Streamer;
+	std::vector<SampledTexture> SampledTextures;
+	// Indices into SampledTextures referenced by this frame's draws
+	std::vector<size_t> FrameTextures;
+	// Uncompressed textures, fully resident with compute generated mips
+	std::vector<VkImage> VKTextureImages;
+	std::vector<VkDeviceMemory> VKTextureImagesMemory;
+	std::vector<VkImageView> VKTextureImageViews;
+	VkSampler VKTextureSampler = VK_NULL_HANDLE;
+	// Uploaded images released to the compute family, the first frame
+	// generates their mips
+	std::unique_ptr<render::MipGenerator> Mips;
+	std::vector<MipChainRequest> PendingMipChains;
 
 #pragma region VK Buffers
 	VkCommandPool VKCommandPool;
-	VkBuffer VKVertexBuffer;
-	VkDeviceMemory VKVertexBufferMemory;
-	VkBuffer VKIndexBuffer;
-	VkDeviceMemory VKIndexBufferMemory;
+	std::mutex UploadLock;
+	// Every mesh in one vertex and one index buffer, compacted a few MB per
+	// frame. Resolve meshes every frame, they move.
+	std::unique_ptr<render::GeometryPool> Geometry;
+	render::MeshHandle QuadMesh = render::InvalidMeshHandle;
+	// Persistently mapped upload space, recycled as frame fences signal
+	std::unique_ptr<render::StagingRing> UploadRing;
 
 	std::vector<VkBuffer> VKUniformBuffers;
 	std::vector<VkDeviceMemory> VKUniformBuffersMemory;
+	// Per frame in flight, the sets are kept across frames and the pools
+	// reset in bulk when they grew
+	std::vector<std::unique_ptr<render::DescriptorAllocator>> FrameDescriptorAllocators;
+	std::vector<std::unique_ptr<render::DescriptorSetCache>> FrameDescriptorSets;
+	// Bindless mode only: set 1 of the pipeline layout plus the materials it indexes
+	VkPhysicalDeviceDescriptorIndexingPropertiesEXT BindlessLimits = {};
+	std::unique_ptr<render::BindlessTable> Bindless;
+	VkBuffer VKMaterialBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory VKMaterialBufferMemory = VK_NULL_HANDLE;
+	uint32_t DefaultMaterialIndex = 0;
 	std::vector<VkCommandBuffer> VKCommandBuffers;
+	// One graph per command buffer, owns the transients its passes declared
+	std::vector<std::unique_ptr<render::RenderGraph>> FrameGraphs;
+	// Objects replaced at runtime, destroyed once the frames using them are done
+	std::unique_ptr<render::DeletionQueue> Deletions;
+	// Rebuilt and sorted every frame before recording
+	render::DrawQueue Draws;
 	std::vector<VkImageView> VKSwapChainImageViews;
 	std::vector<VkFramebuffer> VKSwapChainFramebuffers;
 #pragma endregion
@@ -203,6 +416,22 @@ private:
 	std::vector<VkSemaphore> VKImageAvailableSemaphores;
 	std::vector<VkSemaphore> VKRenderFinishedSemaphores;
 	std::vector<VkFence> VKInFlightFences;
+	// Per swap chain image, the fence of the last frame that rendered to it.
+	// The image count is independent of FramesInFlight so either may be larger.
+	std::vector<VkFence> VKImagesInFlight;
+	// Timeline backend, replaces the fences: the graphics value each frame
+	// slot and each swap chain image last signaled
+	std::unique_ptr<render::TimelineSync> Timelines;
+	std::vector<uint64_t> FrameTimelineValues;
+	std::vector<uint64_t> ImageTimelineValues;
+	// Async compute dispatches; their handoffs queued here are waited on by
+	// the next graphics submit, once each
+	std::unique_ptr<render::ComputeQueue> AsyncCompute;
+	std::vector<render::QueueHandoff> FrameComputeWaits;
+	// Settings.CaptureFrame, null when off or the swap chain format can't be
+	// read back
+	std::unique_ptr<render::FrameReadback> Readback;
+	int32_t ExitCode = 0;
 #pragma endregion
 	
 	std::vector<uint16_t> class_indices;
@@ -0,0 +1,57 @@
+//-----------------------------------------------------------------------------
+#ifndef _FILEWATCHER_H_
+#define _FILEWATCHER_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#pragma endregion
+//-----------------------------------------------------------------------------
+namespace core
+{
+	typedef std::function<void(const std::string&)> FileChangedFunction;
+	//-----------------------------------------------------------------------------
+	// Watches a fixed set of files in one directory from its own thread and
+	// reports each one once it has been written and left alone for a moment
+	// (editors often save in several steps). Uses inotify on Linux and polls
+	// modification times elsewhere.
+	class FileWatcher
+	{
+	public:
+		// onChanged gets the file name as listed in files, on the watcher thread
+		FileWatcher(const std::string& directory, const std::vector<std::string>& files, FileChangedFunction onChanged);
+		~FileWatcher();
+		FileWatcher(const FileWatcher&) = delete;
+		FileWatcher& operator=(const FileWatcher&) = delete;
+
+	private:
+		typedef std::chrono::steady_clock Clock;
+
+		void WatchLoop();
+		// Blocks for at most timeoutMs, records the files touched meanwhile
+		void CollectChanges(int timeoutMs);
+		void MarkChanged(const std::string& file);
+
+		std::string Directory;
+		std::vector<std::string> Files;
+		FileChangedFunction OnChanged;
+
+		// Last time each file was touched, reported once it settles
+		std::map<std::string, Clock::time_point> PendingChanges;
+#if defined(__linux__)
+		int NotifyFd = -1;
+#else
+		std::map<std::string, time_t> ModifiedTimes;
+#endif
+		std::atomic<bool> Running;
+		std::thread Thread;
+	};
+}
+#endif // !_FILEWATCHER_H_
+//-----------------------------------------------------------------------------
@@ -0,0 +1,79 @@
+//-----------------------------------------------------------------------------
+#ifndef _FRAMEPACER_H_
+#define _FRAMEPACER_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <chrono>
+#include <cstdint>
+#pragma endregion
+//-----------------------------------------------------------------------------
+namespace core
+{
+	// Present-to-present intervals since creation or the last ResetStats
+	struct FramePacerStats
+	{
+		uint64_t Frames			= 0;
+		double MeanIntervalMs	= 0.0;
+		double MinIntervalMs	= 0.0;
+		double MaxIntervalMs	= 0.0;
+		// Standard deviation of the interval
+		double JitterMs			= 0.0;
+		// Time Wait spent asleep and spinning
+		double SleptMs			= 0.0;
+		double SpunMs			= 0.0;
+	};
+	//-----------------------------------------------------------------------------
+	// Holds frames to a target interval and measures how evenly they are
+	// presented. Wait sleeps in 1 ms steps while the deadline is further away
+	// than a sleep has recently been seen to take, then yields the rest, so
+	// the deadline is met within tens of microseconds. The yielded part is
+	// capped at MaxSpinMs whatever the sleeps take. On Windows the pacer
+	// holds a 1 ms timer resolution while it exists, the default 15.6 ms
+	// would make every sleep overshoot the frame.
+	class FramePacer
+	{
+	public:
+		typedef std::chrono::steady_clock Clock;
+		static const double MaxSpinMs;
+
+		// 0 only records the intervals
+		explicit FramePacer(double targetIntervalMs = 0.0);
+		~FramePacer();
+		FramePacer(const FramePacer&) = delete;
+		FramePacer& operator=(const FramePacer&) = delete;
+
+		void SetTargetInterval(double targetIntervalMs);
+		const double GetTargetInterval() const { return TargetIntervalMs; }
+
+		// Blocks until one target interval after the previous deadline. A frame
+		// that ran late moves the schedule instead of rushing the next ones.
+		void Wait();
+		// Right after the present call returned
+		void MarkPresent();
+
+		const FramePacerStats GetStats() const;
+		void ResetStats();
+
+	private:
+		void SleepUntil(Clock::time_point deadline);
+
+		double TargetIntervalMs;
+		Clock::time_point Deadline;
+		bool Scheduled = false;
+
+		// Moving estimate of what a 1 ms sleep really takes, see Wait. It
+		// follows the last few dozen sleeps so a timer change shows quickly.
+		double SleepEstimateMs	= 1.0;
+		double SleepMeanMs		= 1.0;
+		double SleepVariance	= 0.0;
+
+		Clock::time_point LastPresent;
+		bool Presented = false;
+		// Welford's accumulators over the intervals
+		double IntervalMean		= 0.0;
+		double IntervalM2		= 0.0;
+		FramePacerStats Stats;
+	};
+}
+#endif // !_FRAMEPACER_H_
+//-----------------------------------------------------------------------------
@@ -0,0 +1,119 @@
+//-----------------------------------------------------------------------------
+#ifndef _JOBSYSTEM_H_
+#define _JOBSYSTEM_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#pragma endregion
+//-----------------------------------------------------------------------------
+namespace core
+{
+	class JobSystem;
+	typedef std::function<void()> JobFunction;
+	//-----------------------------------------------------------------------------
+	// Counts the jobs that still have to finish before something can go on.
+	// Jobs queued with RunAfter are parked on the counter and released by the
+	// worker that brings it back to zero.
+	class JobCounter
+	{
+	public:
+		JobCounter() : Pending(0) {}
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+
+		const bool IsDone() const { return Pending.load(std::memory_order_acquire) == 0; }
+		const uint32_t GetPending() const { return Pending.load(std::memory_order_acquire); }
+
+	private:
+		friend class JobSystem;
+		struct Continuation
+		{
+			JobFunction Function;
+			JobCounter* Signal;
+		};
+
+		std::atomic<uint32_t> Pending;
+		std::mutex ContinuationLock;
+		std::vector<Continuation> Continuations;
+	};
+	//-----------------------------------------------------------------------------
+	struct JobSystemConfig
+	{
+		// 0 means one worker per hardware thread, minus the ones reserved below
+		uint32_t WorkerCount		= 0;
+		// Core index the main and render threads are pinned to, -1 leaves them floating
+		int32_t MainThreadCore		= -1;
+		int32_t RenderThreadCore	= -1;
+		// Pin each worker to its own core, skipping the reserved ones
+		bool PinWorkers				= false;
+	};
+	//-----------------------------------------------------------------------------
+	// Work-stealing scheduler. Every worker owns a deque: it pushes and pops at
+	// the back, idle workers steal from the front of somebody else's.
+	class JobSystem
+	{
+	public:
+		JobSystem();
+		~JobSystem();
+
+		void Init(const JobSystemConfig& config = JobSystemConfig());
+		void Shutdown();
+
+		// Jobs must not throw, an exception escaping a worker terminates the process
+		void Run(JobFunction function, JobCounter* signal = nullptr);
+		// Queues function once dependency reaches zero
+		void RunAfter(JobCounter& dependency, JobFunction function, JobCounter* signal = nullptr);
+		// Blocks until counter reaches zero, running queued jobs meanwhile
+		void Wait(JobCounter& counter);
+		// Splits [begin, end) in chunks of grainSize and blocks until all of them ran
+		void ParallelFor(uint32_t begin, uint32_t end, uint32_t grainSize, const std::function<void(uint32_t, uint32_t)>& function);
+
+		const uint32_t GetWorkerCount() const { return static_cast<uint32_t>(Workers.size()); }
+		const bool IsRunning() const { return Running.load(std::memory_order_acquire); }
+		// Meant to be called from the thread that records and submits frames
+		void PinRenderThread() const;
+		static const bool SetCurrentThreadAffinity(uint32_t core);
+		// -1 for threads that are not workers of any job system
+		static const int32_t GetCurrentWorkerIndex();
+
+	private:
+		struct Job
+		{
+			JobFunction Function;
+			JobCounter* Signal;
+		};
+
+		struct WorkQueue
+		{
+			std::mutex Lock;
+			std::deque<Job> Jobs;
+		};
+
+		void Push(Job&& job);
+		const bool TryPop(Job& job);
+		const bool TrySteal(uint32_t thiefIndex, Job& job);
+		const bool TryRunOne();
+		void Execute(Job& job);
+		void Finish(JobCounter* signal);
+		void WorkerLoop(uint32_t index);
+
+		JobSystemConfig Config;
+		std::vector<std::thread> Workers;
+		// Index 0 is shared by every thread that is not a worker
+		std::vector<std::unique_ptr<WorkQueue>> Queues;
+
+		std::atomic<bool> Running;
+		std::atomic<uint32_t> QueuedJobs;
+		std::mutex SleepLock;
+		std::condition_variable WakeCondition;
+	};
+}
+#endif // !_JOBSYSTEM_H_
+//-----------------------------------------------------------------------------
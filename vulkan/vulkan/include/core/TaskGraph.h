@@ -0,0 +1,81 @@
+//-----------------------------------------------------------------------------
+#ifndef _TASKGRAPH_H_
+#define _TASKGRAPH_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#pragma endregion
+#include "core/JobSystem.h"
+//-----------------------------------------------------------------------------
+namespace core
+{
+	typedef uint32_t TaskHandle;
+	//-----------------------------------------------------------------------------
+	struct TaskTiming
+	{
+		std::string Name;
+		// Milliseconds since Run() started
+		double StartMs		= 0.0;
+		double EndMs		= 0.0;
+		// Worker that ran it, -1 for the thread that called Run()
+		int32_t Worker		= -1;
+		bool Skipped		= false;
+	};
+	//-----------------------------------------------------------------------------
+	// One-shot DAG of tasks on top of the job system. A task is queued as soon
+	// as the last of its dependencies finished. If a task throws, everything
+	// depending on it is skipped and Run() rethrows on the calling thread.
+	class TaskGraph
+	{
+	public:
+		explicit TaskGraph(JobSystem& jobs);
+		TaskGraph(const TaskGraph&) = delete;
+		TaskGraph& operator=(const TaskGraph&) = delete;
+
+		// Dependencies have to be tasks added before, so the graph can't cycle
+		TaskHandle AddTask(const std::string& name, JobFunction function, std::initializer_list<TaskHandle> dependencies = {});
+		// Blocks until every task ran or got skipped
+		void Run();
+
+		const std::vector<TaskTiming> GetTimings() const;
+		const double GetTotalMs() const { return TotalMs; }
+		// Longest chain of dependent tasks, what Run() can't go below no matter the worker count
+		const double GetCriticalPathMs() const;
+		void PrintReport(std::ostream& stream) const;
+
+	private:
+		struct Task
+		{
+			std::string Name;
+			JobFunction Function;
+			std::vector<TaskHandle> Dependencies;
+			std::vector<TaskHandle> Dependents;
+			std::atomic<uint32_t> RemainingDependencies;
+			std::atomic<bool> Failed;
+			TaskTiming Timing;
+		};
+
+		void Launch(TaskHandle handle);
+		void Execute(TaskHandle handle);
+
+		JobSystem& Jobs;
+		std::vector<std::unique_ptr<Task>> Tasks;
+		JobCounter Done;
+
+		std::chrono::high_resolution_clock::time_point StartTime;
+		double TotalMs = 0.0;
+
+		std::mutex ErrorLock;
+		std::exception_ptr FirstError;
+	};
+}
+#endif // !_TASKGRAPH_H_
+//-----------------------------------------------------------------------------
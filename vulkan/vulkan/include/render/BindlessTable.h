@@ -0,0 +1,73 @@
+//-----------------------------------------------------------------------------
+#ifndef _BINDLESSTABLE_H_
+#define _BINDLESSTABLE_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstdint>
+#include <vector>
+#pragma endregion
+#include <vulkan/vulkan.h>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	// Binding slots of the bindless set
+	const uint32_t BindlessStorageBufferBinding	= 0;
+	const uint32_t BindlessSampledImageBinding	= 1;
+	const uint32_t InvalidBindlessIndex			= ~0u;
+	//-----------------------------------------------------------------------------
+	struct BindlessTableDesc
+	{
+		uint32_t MaxStorageBuffers	= 4096;
+		uint32_t MaxSampledImages	= 16384;
+	};
+	//-----------------------------------------------------------------------------
+	// One update-after-bind descriptor set holding big arrays of storage
+	// buffers and sampled images. Everything registered gets a slot index,
+	// shaders pick their resources by index (from push constants), so the set
+	// is bound once per command buffer regardless of the number of materials.
+	// Needs VK_EXT_descriptor_indexing or Vulkan 1.2.
+	class BindlessTable
+	{
+	public:
+		// Counts are clamped to the device's update-after-bind limits
+		BindlessTable(VkDevice device, const VkPhysicalDeviceDescriptorIndexingPropertiesEXT& limits, const BindlessTableDesc& desc = BindlessTableDesc());
+		~BindlessTable();
+		BindlessTable(const BindlessTable&) = delete;
+		BindlessTable& operator=(const BindlessTable&) = delete;
+
+		const uint32_t RegisterBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+		const uint32_t RegisterImage(VkImageView view, VkSampler sampler, VkImageLayout layout);
+		// Points a registered slot at another view, under the same rule as a release
+		void UpdateImage(uint32_t index, VkImageView view, VkSampler sampler, VkImageLayout layout);
+		// Slots are recycled right away: shaders must not reach a released slot
+		// from a command buffer that is still pending
+		void ReleaseBuffer(uint32_t index);
+		void ReleaseImage(uint32_t index);
+
+		VkDescriptorSetLayout GetLayout() const { return Layout; }
+		VkDescriptorSet GetSet() const { return Set; }
+		const uint32_t GetMaxStorageBuffers() const { return MaxStorageBuffers; }
+		const uint32_t GetMaxSampledImages() const { return MaxSampledImages; }
+
+	private:
+		struct SlotList
+		{
+			uint32_t Next = 0;
+			std::vector<uint32_t> Free;
+		};
+		const uint32_t AcquireSlot(SlotList& slots, uint32_t capacity, const char* what);
+
+		VkDevice Device;
+		uint32_t MaxStorageBuffers;
+		uint32_t MaxSampledImages;
+
+		VkDescriptorSetLayout Layout	= VK_NULL_HANDLE;
+		VkDescriptorPool Pool			= VK_NULL_HANDLE;
+		VkDescriptorSet Set				= VK_NULL_HANDLE;
+
+		SlotList BufferSlots;
+		SlotList ImageSlots;
+	};
+}
+#endif // !_BINDLESSTABLE_H_
+//-----------------------------------------------------------------------------
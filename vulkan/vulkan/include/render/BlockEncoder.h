@@ -0,0 +1,35 @@
+//-----------------------------------------------------------------------------
+#ifndef _BLOCKENCODER_H_
+#define _BLOCKENCODER_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstdint>
+#include <vector>
+#pragma endregion
+#include <vulkan/vulkan.h>
+#include "core/JobSystem.h"
+//-----------------------------------------------------------------------------
+namespace render
+{
+	enum class BlockEncoding
+	{
+		// 4 bpp, RGB only: alpha is dropped
+		BC1,
+		// 8 bpp, RGBA, single subset (mode 6)
+		BC7
+	};
+	//-----------------------------------------------------------------------------
+	// texels is a 4x4 RGBA8 block, row major. Endpoints are fitted along the
+	// principal axis of the block, then refined once by least squares over
+	// the chosen indices.
+	void EncodeBC1Block(const uint8_t* texels, uint8_t* block);
+	void EncodeBC7Block(const uint8_t* texels, uint8_t* block);
+
+	const uint32_t GetEncodedBlockSize(BlockEncoding encoding);
+	const VkFormat GetEncodedFormat(BlockEncoding encoding, bool srgb);
+	// Encodes a RGBA8 image, edge blocks repeat the last row and column.
+	// Rows of blocks are spread over the job system.
+	std::vector<char> EncodeImage(core::JobSystem& jobs, const uint8_t* rgba, uint32_t width, uint32_t height, BlockEncoding encoding);
+}
+#endif // !_BLOCKENCODER_H_
+//-----------------------------------------------------------------------------
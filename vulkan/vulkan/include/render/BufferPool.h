@@ -0,0 +1,158 @@
+//-----------------------------------------------------------------------------
+#ifndef _BUFFERPOOL_H_
+#define _BUFFERPOOL_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#pragma endregion
+#include <vulkan/vulkan.h>
+#include "render/RangeAllocator.h"
+//-----------------------------------------------------------------------------
+namespace render
+{
+	typedef uint32_t BufferAllocation;
+	const BufferAllocation InvalidBufferAllocation = ~0u;
+	//-----------------------------------------------------------------------------
+	struct BufferPoolDesc
+	{
+		// TRANSFER_SRC and TRANSFER_DST are added, the defragmenter copies with them
+		VkBufferUsageFlags Usage				= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+		VkMemoryPropertyFlags MemoryProperties	= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		// Allocations bigger than a block get a block of their own
+		VkDeviceSize BlockSize					= 16ull << 20;
+		// 0 is unlimited. A single block is created up front and never
+		// released, defragmenting only compacts it.
+		uint32_t MaxBlocks						= 0;
+		uint32_t FramesInFlight					= 2;
+		// Bytes Defragment may copy per call
+		VkDeviceSize DefragBytesPerFrame		= 4ull << 20;
+	};
+	//-----------------------------------------------------------------------------
+	// Where an allocation lives right now, Defragment may move it
+	struct BufferRange
+	{
+		VkBuffer Buffer			= VK_NULL_HANDLE;
+		VkDeviceSize Offset		= 0;
+		VkDeviceSize Size		= 0;
+		// Host visible memory only, already offset
+		void* Mapped			= nullptr;
+	};
+	//-----------------------------------------------------------------------------
+	struct BufferPoolStats
+	{
+		uint32_t Blocks				= 0;
+		uint32_t Allocations		= 0;
+		VkDeviceSize BlockBytes		= 0;
+		VkDeviceSize UsedBytes		= 0;
+		// Last Defragment call only
+		VkDeviceSize MovedBytes		= 0;
+		// Since creation
+		uint64_t Moves				= 0;
+		uint64_t BlocksReleased		= 0;
+	};
+	//-----------------------------------------------------------------------------
+	// Suballocates buffers from large device memory blocks, one VkBuffer per
+	// block. Allocations are handles resolved to a buffer and offset, which
+	// lets Defragment move them: each call copies a bounded number of bytes
+	// with vkCmdCopyBuffer, either emptying the least used block so it can be
+	// released or, when there is nothing to release, pulling the last
+	// allocation of a fragmented block down into a hole. Ranges freed or moved
+	// away from stay reserved until their frame slot comes around again.
+	//
+	// Resolve handles every frame, after Defragment, and never keep the range.
+	// Allocate, Free and Resolve may be called from any thread.
+	class BufferPool
+	{
+	public:
+		typedef std::function<uint32_t(uint32_t, VkMemoryPropertyFlags)> MemoryTypeFinder;
+
+		BufferPool(VkDevice device, MemoryTypeFinder findMemoryType, const BufferPoolDesc& desc = BufferPoolDesc());
+		// The GPU must be done with every frame that used the pool
+		~BufferPool();
+		BufferPool(const BufferPool&) = delete;
+		BufferPool& operator=(const BufferPool&) = delete;
+
+		// Throws when MaxBlocks are full
+		BufferAllocation Allocate(VkDeviceSize size, VkDeviceSize alignment = 16);
+		void Free(BufferAllocation allocation);
+		const BufferRange Resolve(BufferAllocation allocation) const;
+		// The buffer of a single block pool, every allocation is in it
+		VkBuffer GetBuffer() const;
+
+		// Call once the fence of frameSlot signaled, recycles what that frame retired
+		void BeginFrame(uint32_t frameSlot);
+		// Records this frame's moves, outside of a render pass and before
+		// anything reads the moved allocations
+		void Defragment(VkCommandBuffer commandBuffer);
+
+		const BufferPoolStats GetStats() const;
+
+	private:
+		struct Block
+		{
+			uint32_t Id				= 0;
+			VkBuffer Buffer			= VK_NULL_HANDLE;
+			VkDeviceMemory Memory	= VK_NULL_HANDLE;
+			uint8_t* Mapped			= nullptr;
+			RangeAllocator Ranges;
+			uint32_t Live			= 0;
+			// Being emptied or empty, nothing new goes in
+			bool Releasing			= false;
+		};
+		struct Allocation
+		{
+			uint32_t BlockId		= 0;
+			VkDeviceSize Offset		= 0;
+			VkDeviceSize Size		= 0;
+			VkDeviceSize Alignment	= 1;
+			bool Live				= false;
+		};
+		struct RetiredRange
+		{
+			uint32_t BlockId;
+			VkDeviceSize Offset;
+			VkDeviceSize Size;
+		};
+		struct PendingCopy
+		{
+			VkBuffer Source;
+			VkBuffer Destination;
+			VkBufferCopy Region;
+		};
+
+		Block& CreateBlock(VkDeviceSize size);
+		void DestroyBlock(Block& block) const;
+		Block* FindBlock(uint32_t id) const;
+		// Reserves the range in any block but exclude, false if none has room
+		const bool Place(VkDeviceSize size, VkDeviceSize alignment, const Block* exclude, uint32_t& blockId, VkDeviceSize& offset);
+		// Points the allocation at its new range in to, reserved by the caller,
+		// and retires the old one
+		void Move(Allocation& allocation, Block& from, Block& to, VkDeviceSize offset, std::vector<PendingCopy>& copies);
+		// Least used block whose allocations fit in the others, nullptr if none
+		Block* FindEvacuationCandidate() const;
+
+		VkDevice Device;
+		MemoryTypeFinder FindMemoryType;
+		BufferPoolDesc Desc;
+
+		mutable std::mutex Lock;
+		std::vector<std::unique_ptr<Block>> Blocks;
+		uint32_t NextBlockId = 1;
+		// Releasing block Defragment is moving allocations out of, 0 for none
+		uint32_t EvacuatingBlock = 0;
+		std::vector<Allocation> Allocations;
+		std::vector<BufferAllocation> FreeHandles;
+
+		uint32_t FrameSlot = 0;
+		std::vector<std::vector<RetiredRange>> RetiredRanges;
+		std::vector<std::vector<uint32_t>> RetiredBlocks;
+
+		BufferPoolStats Stats;
+	};
+}
+#endif // !_BUFFERPOOL_H_
+//-----------------------------------------------------------------------------
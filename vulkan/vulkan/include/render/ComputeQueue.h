@@ -0,0 +1,83 @@
+//-----------------------------------------------------------------------------
+#ifndef _COMPUTEQUEUE_H_
+#define _COMPUTEQUEUE_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstdint>
+#include <vector>
+#pragma endregion
+#include <vulkan/vulkan.h>
+#include "render/TimelineSync.h"
+//-----------------------------------------------------------------------------
+namespace render
+{
+	// What a submission on one queue hands to a submission on another: wait
+	// on Semaphore at Stage. Value 0 is a binary semaphore, which must be
+	// waited on exactly once.
+	struct QueueHandoff
+	{
+		VkSemaphore Semaphore		= VK_NULL_HANDLE;
+		uint64_t Value				= 0;
+		VkPipelineStageFlags Stage	= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+	};
+	//-----------------------------------------------------------------------------
+	// Compute work on its own queue, ideally from a family without graphics
+	// so it runs alongside the graphics pass on otherwise idle units (culling,
+	// post-processing, simulation). One command buffer per frame slot.
+	//
+	// Synchronizes through the compute counter of a TimelineSync when given
+	// one, through a fence and a binary semaphore per frame slot otherwise.
+	// Resources created with VK_SHARING_MODE_EXCLUSIVE change family with
+	// the Release/Acquire pairs below, around the handoff.
+	class ComputeQueue
+	{
+	public:
+		ComputeQueue(VkDevice device, VkQueue queue, uint32_t family, uint32_t graphicsFamily, uint32_t framesInFlight, TimelineSync* timelines = nullptr);
+		// Waits for the queue
+		~ComputeQueue();
+		ComputeQueue(const ComputeQueue&) = delete;
+		ComputeQueue& operator=(const ComputeQueue&) = delete;
+
+		// Waits until the slot's previous submission is done, then hands out
+		// its command buffer, begun
+		VkCommandBuffer Begin(uint32_t frameSlot);
+		// Ends and submits what Begin returned after the given handoffs (once
+		// per Begin, a binary handoff is reused by the slot's next submit),
+		// returns the one consumers wait on at consumerStage
+		const QueueHandoff Submit(const std::vector<QueueHandoff>& waits, VkPipelineStageFlags consumerStage);
+		void WaitIdle() const;
+
+		const uint32_t GetFamily() const { return Family; }
+		const uint32_t GetGraphicsFamily() const { return GraphicsFamily; }
+		// Not sharing the graphics family, so work really overlaps and
+		// exclusive resources need ownership transfers
+		const bool IsAsync() const { return Family != GraphicsFamily; }
+
+		// Queue family ownership transfer: Release on the queue giving the
+		// resource up, before its handoff, and Acquire with the same families
+		// (and layouts) on the one taking it, after the wait at dstStage. Both
+		// record nothing when the families match, the semaphore is then enough.
+		static void ReleaseBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, uint32_t srcFamily, uint32_t dstFamily, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess);
+		static void AcquireBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, uint32_t srcFamily, uint32_t dstFamily, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+		static void ReleaseImage(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t srcFamily, uint32_t dstFamily, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess);
+		static void AcquireImage(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t srcFamily, uint32_t dstFamily, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+
+	private:
+		VkDevice Device;
+		VkQueue Queue;
+		uint32_t Family;
+		uint32_t GraphicsFamily;
+		TimelineSync* Timelines;
+
+		VkCommandPool CommandPool = VK_NULL_HANDLE;
+		std::vector<VkCommandBuffer> CommandBuffers;
+		// Binary sync only
+		std::vector<VkFence> Fences;
+		std::vector<VkSemaphore> Finished;
+		// Timeline sync only, compute value each slot last signaled
+		std::vector<uint64_t> SlotValues;
+		uint32_t FrameSlot = 0;
+	};
+}
+#endif // !_COMPUTEQUEUE_H_
+//-----------------------------------------------------------------------------
@@ -0,0 +1,88 @@
+//-----------------------------------------------------------------------------
+#ifndef _DELETIONQUEUE_H_
+#define _DELETIONQUEUE_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+#pragma endregion
+#include <vulkan/vulkan.h>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	struct DeletionQueueStats
+	{
+		uint32_t Pending		= 0;
+		// Since creation
+		uint64_t Destroyed		= 0;
+	};
+	//-----------------------------------------------------------------------------
+	// Destroys Vulkan objects once the GPU can no longer be using them,
+	// without idling the device. Each retired object is stamped with the
+	// frame being recorded and destroyed when a frame slot's fence proves
+	// that frame complete; a fence covers every earlier submission on its
+	// queue, so one stamp is enough.
+	//
+	// Retire may be called from any thread, the frame calls from the render
+	// thread only.
+	class DeletionQueue
+	{
+	public:
+		typedef std::function<void()> DestroyFunction;
+
+		DeletionQueue(VkDevice device, uint32_t framesInFlight);
+		// Flushes, the GPU must be idle
+		~DeletionQueue();
+		DeletionQueue(const DeletionQueue&) = delete;
+		DeletionQueue& operator=(const DeletionQueue&) = delete;
+
+		// For anything that needs more than one call, or the caller's own
+		// bookkeeping (memory going through the telemetry)
+		void Retire(DestroyFunction destroy);
+		// Separate names, non-dispatchable handles are all uint64_t on 32 bit
+		void RetireBuffer(VkBuffer buffer);
+		void RetireImage(VkImage image);
+		void RetireImageView(VkImageView view);
+		void RetirePipeline(VkPipeline pipeline);
+		void RetireFramebuffer(VkFramebuffer framebuffer);
+		void RetireRenderPass(VkRenderPass renderPass);
+		void RetireSwapchain(VkSwapchainKHR swapchain);
+
+		// Call once the fence of frameSlot signaled, destroys what was retired
+		// up to the frame last submitted with it
+		void BeginFrame(uint32_t frameSlot);
+		// Call right after submitting the frame with frameSlot's fence
+		void EndFrame(uint32_t frameSlot);
+		// Destroys everything, the GPU must be idle
+		void Flush();
+
+		const DeletionQueueStats GetStats() const;
+
+	private:
+		struct Entry
+		{
+			uint64_t Frame;
+			DestroyFunction Destroy;
+		};
+
+		// Runs the entries stamped up to frame, outside the lock so a destroy
+		// function may retire something else
+		void Collect(uint64_t frame);
+
+		VkDevice Device;
+
+		mutable std::mutex Lock;
+		// In stamp order, stamps never go down
+		std::deque<Entry> Entries;
+		// Stamp of what is retired now: the next submission
+		uint64_t Frame = 1;
+		// Last submission per slot, 0 before the first
+		std::vector<uint64_t> SubmittedFrames;
+		uint64_t Destroyed = 0;
+	};
+}
+#endif // !_DELETIONQUEUE_H_
+//-----------------------------------------------------------------------------
@@ -0,0 +1,140 @@
+//-----------------------------------------------------------------------------
+#ifndef _DESCRIPTORALLOCATOR_H_
+#define _DESCRIPTORALLOCATOR_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#pragma endregion
+#include <vulkan/vulkan.h>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	// Descriptors of one type per set, pools are sized SetsPerPool * Ratio
+	struct PoolSizeRatio
+	{
+		VkDescriptorType Type;
+		float Ratio;
+	};
+	//-----------------------------------------------------------------------------
+	struct DescriptorAllocatorStats
+	{
+		uint32_t Pools				= 0;
+		uint32_t SetsAllocated		= 0;
+		uint32_t PoolResets			= 0;
+	};
+	//-----------------------------------------------------------------------------
+	// Hands out descriptor sets from a list of pools. When a pool runs dry a
+	// new, bigger one is taken; sets are never freed one by one, Reset()
+	// recycles every pool at once. Pool sizes follow a ratio table built from
+	// the layouts registered with it.
+	class DescriptorAllocator
+	{
+	public:
+		DescriptorAllocator(VkDevice device, uint32_t initialSetsPerPool = 64, uint32_t maxSetsPerPool = 4096);
+		~DescriptorAllocator();
+		DescriptorAllocator(const DescriptorAllocator&) = delete;
+		DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+		// Folds the layout's descriptor counts into the ratio table used for new pools
+		void RegisterLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+		VkDescriptorSet Allocate(VkDescriptorSetLayout layout);
+		// Every set handed out so far becomes invalid, the GPU must be done with them
+		void Reset();
+		// A pool ran dry since the last Reset(), the sets are spread over several
+		const bool HasGrown() const { return UsedPools.size() > 1; }
+
+		const std::vector<PoolSizeRatio> GetRatios() const;
+		const DescriptorAllocatorStats& GetStats() const { return Stats; }
+
+	private:
+		VkDescriptorPool CreatePool(uint32_t setCount);
+		VkDescriptorPool GrabPool();
+
+		VkDevice Device;
+		uint32_t SetsPerPool;
+		uint32_t MaxSetsPerPool;
+
+		// Descriptors per type summed over the registered layouts
+		std::map<VkDescriptorType, uint32_t> DescriptorTotals;
+		uint32_t LayoutCount = 0;
+
+		VkDescriptorPool CurrentPool = VK_NULL_HANDLE;
+		std::vector<VkDescriptorPool> UsedPools;
+		std::vector<VkDescriptorPool> FreePools;
+
+		DescriptorAllocatorStats Stats;
+	};
+	//-----------------------------------------------------------------------------
+	// What a set points to, binding by binding. Doubles as the cache key.
+	class DescriptorBindings
+	{
+	public:
+		DescriptorBindings& Buffer(uint32_t binding, VkDescriptorType type, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+		DescriptorBindings& Image(uint32_t binding, VkDescriptorType type, VkImageView view, VkSampler sampler, VkImageLayout layout);
+
+		const size_t Hash() const;
+		bool operator==(const DescriptorBindings& other) const;
+
+	private:
+		friend class DescriptorSetCache;
+		struct Entry
+		{
+			uint32_t Binding;
+			VkDescriptorType Type;
+			VkDescriptorBufferInfo BufferInfo;
+			VkDescriptorImageInfo ImageInfo;
+			bool IsImage;
+		};
+		std::vector<Entry> Entries;
+	};
+	//-----------------------------------------------------------------------------
+	struct DescriptorCacheStats
+	{
+		uint32_t Hits				= 0;
+		uint32_t Misses				= 0;
+	};
+	//-----------------------------------------------------------------------------
+	// Returns the same set for the same layout and contents instead of
+	// allocating and writing a new one, across frames. Sets are written once
+	// and never updated, so a hit is safe while earlier frames still use it.
+	// Owns the resets of the allocator it draws from.
+	class DescriptorSetCache
+	{
+	public:
+		DescriptorSetCache(VkDevice device, DescriptorAllocator& allocator);
+
+		VkDescriptorSet Get(VkDescriptorSetLayout layout, const DescriptorBindings& bindings);
+		// Call once the GPU is done with the sets of earlier frames. Keeps the
+		// cache unless the allocator had to grow; then starts over, so only
+		// the sets still in use get allocated again, packed in one pool.
+		void BeginFrame();
+		// Drops every set and resets the allocator, the GPU must be done with
+		// them. Needed when something a set points to is destroyed: its
+		// handle can come back for a new object.
+		void Clear();
+
+		const DescriptorCacheStats& GetStats() const { return Stats; }
+
+	private:
+		struct Key
+		{
+			VkDescriptorSetLayout Layout;
+			DescriptorBindings Bindings;
+			bool operator==(const Key& other) const { return Layout == other.Layout && Bindings == other.Bindings; }
+		};
+		struct KeyHash
+		{
+			size_t operator()(const Key& key) const;
+		};
+
+		VkDevice Device;
+		DescriptorAllocator& Allocator;
+		std::unordered_map<Key, VkDescriptorSet, KeyHash> Sets;
+		DescriptorCacheStats Stats;
+	};
+}
+#endif // !_DESCRIPTORALLOCATOR_H_
+//-----------------------------------------------------------------------------
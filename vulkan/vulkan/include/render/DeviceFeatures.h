@@ -0,0 +1,21 @@
+//-----------------------------------------------------------------------------
+#ifndef _DEVICEFEATURES_H_
+#define _DEVICEFEATURES_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstdint>
+#pragma endregion
+#include <vulkan/vulkan.h>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	// Probe for an extension Vulkan 1.2 promoted to core, such as timeline
+	// semaphores or descriptor indexing. Needs 1.1 on the instance and the
+	// device for vkGetPhysicalDeviceFeatures2, then the extension or 1.2.
+	// features is the extension's feature structure with sType set and no
+	// pNext, the same structure serves 1.2 core. needsExtension is set when
+	// the extension has to be enabled. False when it isn't available.
+	const bool QueryPromotedFeatures(VkPhysicalDevice physicalDevice, uint32_t instanceApiVersion, const char* extensionName, void* features, bool& needsExtension);
+}
+#endif // !_DEVICEFEATURES_H_
+//-----------------------------------------------------------------------------
@@ -0,0 +1,89 @@
+//-----------------------------------------------------------------------------
+#ifndef _DEVICESELECTOR_H_
+#define _DEVICESELECTOR_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+#pragma endregion
+#include <vulkan/vulkan.h>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	// Surface, extension and queue checks the renderer can't do without
+	typedef std::function<bool(VkPhysicalDevice)> DeviceSuitability;
+	//-----------------------------------------------------------------------------
+	struct DeviceSelectorDesc
+	{
+		// Enumeration index or part of the device name, empty to pick the
+		// best score. A match that fails the suitability check is ignored.
+		std::string Override;
+		// Time a fill and a copy on every candidate (a temporary device each)
+		// and add the bandwidth to the score, results are cached per device
+		bool Benchmark				= false;
+		std::string CachePath;
+		uint32_t InstanceApiVersion	= VK_API_VERSION_1_0;
+	};
+	//-----------------------------------------------------------------------------
+	struct DeviceBenchmark
+	{
+		// GB/s, 0 when not measured
+		float FillBandwidth	= 0.0f;
+		float CopyBandwidth	= 0.0f;
+		bool Cached			= false;
+	};
+	//-----------------------------------------------------------------------------
+	struct DeviceCandidate
+	{
+		VkPhysicalDevice Device		= VK_NULL_HANDLE;
+		uint32_t Index				= 0;
+		std::string Name;
+		VkPhysicalDeviceType Type	= VK_PHYSICAL_DEVICE_TYPE_OTHER;
+		// Device UUID in hex on 1.1, vendor, device and driver ids otherwise
+		std::string Key;
+		VkDeviceSize DeviceLocalBytes	= 0;
+		bool AsyncCompute			= false;
+		bool DedicatedTransfer		= false;
+		bool Suitable				= false;
+		DeviceBenchmark Benchmark;
+		int64_t Score				= 0;
+	};
+	//-----------------------------------------------------------------------------
+	// Picks the physical device by score instead of enumeration order, so
+	// hybrid laptops and machines with a software driver (lavapipe,
+	// SwiftShader) land on the fast GPU. Scores device type first, then
+	// device local memory, queue families, the features and limits the
+	// renderer uses, and the optional benchmark.
+	class DeviceSelector
+	{
+	public:
+		DeviceSelector(VkInstance instance, const DeviceSelectorDesc& desc, DeviceSuitability isSuitable);
+
+		// The override when it matches a suitable device, the best score
+		// otherwise. Throws when no device is suitable.
+		const DeviceCandidate& Select() const;
+		// Every device, in enumeration order
+		const std::vector<DeviceCandidate>& GetCandidates() const { return Candidates; }
+		void Print(std::ostream& out) const;
+
+		static const int64_t Score(VkPhysicalDevice device, const DeviceCandidate& candidate);
+
+	private:
+		// First suitable device matching Desc.Override, if any
+		const DeviceCandidate* FindOverride() const;
+		void Describe(DeviceCandidate& candidate) const;
+		// Fill on a compute family and copy on a transfer family, timed
+		// with timestamp queries. Zeros when the device can't time them.
+		static const DeviceBenchmark RunBenchmark(VkPhysicalDevice device);
+		void LoadCache(std::vector<std::pair<std::string, DeviceBenchmark>>& cache) const;
+		void SaveCache(const std::vector<std::pair<std::string, DeviceBenchmark>>& cache) const;
+
+		DeviceSelectorDesc Desc;
+		std::vector<DeviceCandidate> Candidates;
+	};
+}
+#endif // !_DEVICESELECTOR_H_
+//-----------------------------------------------------------------------------
@@ -0,0 +1,137 @@
+//-----------------------------------------------------------------------------
+#ifndef _DRAWQUEUE_H_
+#define _DRAWQUEUE_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstdint>
+#include <vector>
+#pragma endregion
+#include <vulkan/vulkan.h>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	// 64-bit draw key, most significant field first so sorting by key groups
+	// draws by pass, then pipeline, then descriptor set, then mesh.
+	//   63..60 pass | 59..48 pipeline | 47..36 set | 35..20 mesh | 19..0 depth
+	namespace DrawKey
+	{
+		const uint32_t PassBits		= 4;
+		const uint32_t PipelineBits	= 12;
+		const uint32_t SetBits		= 12;
+		const uint32_t MeshBits		= 16;
+		const uint32_t DepthBits	= 20;
+
+		const uint32_t DepthShift		= 0;
+		const uint32_t MeshShift		= DepthShift + DepthBits;
+		const uint32_t SetShift			= MeshShift + MeshBits;
+		const uint32_t PipelineShift	= SetShift + SetBits;
+		const uint32_t PassShift		= PipelineShift + PipelineBits;
+
+		inline uint64_t Make(uint32_t pass, uint32_t pipeline, uint32_t set, uint32_t mesh, uint32_t depth)
+		{
+			return (uint64_t(pass & ((1u << PassBits) - 1)) << PassShift)
+				| (uint64_t(pipeline & ((1u << PipelineBits) - 1)) << PipelineShift)
+				| (uint64_t(set & ((1u << SetBits) - 1)) << SetShift)
+				| (uint64_t(mesh & ((1u << MeshBits) - 1)) << MeshShift)
+				| (uint64_t(depth & ((1u << DepthBits) - 1)) << DepthShift);
+		}
+
+		inline uint32_t GetPass(uint64_t key)		{ return uint32_t(key >> PassShift) & ((1u << PassBits) - 1); }
+		inline uint32_t GetPipeline(uint64_t key)	{ return uint32_t(key >> PipelineShift) & ((1u << PipelineBits) - 1); }
+		inline uint32_t GetSet(uint64_t key)		{ return uint32_t(key >> SetShift) & ((1u << SetBits) - 1); }
+		inline uint32_t GetMesh(uint64_t key)		{ return uint32_t(key >> MeshShift) & ((1u << MeshBits) - 1); }
+		inline uint32_t GetDepth(uint64_t key)		{ return uint32_t(key >> DepthShift) & ((1u << DepthBits) - 1); }
+
+		// Maps view depth in [nearPlane, farPlane] to the depth field. Front to
+		// back for opaque passes; pass invert for back to front (transparent).
+		uint32_t QuantizeDepth(float viewDepth, float nearPlane, float farPlane, bool invert = false);
+	}
+	//-----------------------------------------------------------------------------
+	struct PipelineBinding
+	{
+		VkPipeline Pipeline					= VK_NULL_HANDLE;
+		VkPipelineLayout Layout				= VK_NULL_HANDLE;
+		VkPipelineBindPoint BindPoint		= VK_PIPELINE_BIND_POINT_GRAPHICS;
+		// Stages of the layout's push constant range, 0 when it has none
+		VkShaderStageFlags PushConstantStages	= 0;
+	};
+	//-----------------------------------------------------------------------------
+	struct MeshBinding
+	{
+		VkBuffer VertexBuffer				= VK_NULL_HANDLE;
+		VkDeviceSize VertexOffset			= 0;
+		VkBuffer IndexBuffer				= VK_NULL_HANDLE;
+		VkDeviceSize IndexOffset			= 0;
+		VkIndexType IndexType				= VK_INDEX_TYPE_UINT16;
+	};
+	//-----------------------------------------------------------------------------
+	struct DrawItem
+	{
+		uint64_t Key						= 0;
+		uint32_t IndexCount					= 0;
+		uint32_t InstanceCount				= 1;
+		uint32_t FirstIndex					= 0;
+		int32_t VertexOffset				= 0;
+		uint32_t FirstInstance				= 0;
+		// Filled by Submit(), where the draw's push constants sit in the queue
+		uint32_t PushConstantOffset			= 0;
+		uint32_t PushConstantSize			= 0;
+	};
+	//-----------------------------------------------------------------------------
+	struct DrawQueueStats
+	{
+		uint32_t Draws						= 0;
+		uint32_t PipelineBinds				= 0;
+		uint32_t DescriptorSetBinds			= 0;
+		uint32_t VertexBufferBinds			= 0;
+		uint32_t IndexBufferBinds			= 0;
+		uint32_t PushConstantUpdates		= 0;
+		// Binds a naive recorder would have emitted but were already current
+		uint32_t SkippedBinds				= 0;
+	};
+	//-----------------------------------------------------------------------------
+	// Per-frame list of draws. Pipelines, descriptor sets and meshes are
+	// registered once and referenced by id from the key; Sort() orders the
+	// draws with an LSD radix sort and Record() only binds what changed.
+	class DrawQueue
+	{
+	public:
+		// Set id 0 is reserved for "no descriptor set"
+		const uint32_t RegisterPipeline(const PipelineBinding& pipeline);
+		const uint32_t RegisterDescriptorSet(VkDescriptorSet set);
+		const uint32_t RegisterMesh(const MeshBinding& mesh);
+
+		void Submit(const DrawItem& draw);
+		// Per-draw data pushed inline right before the draw, at offset 0 of the range
+		void Submit(const DrawItem& draw, const void* pushConstants, uint32_t size);
+		void Sort();
+		// Records every draw of pass (or all of them when pass is ~0u)
+		const DrawQueueStats Record(VkCommandBuffer commandBuffer, uint32_t pass = ~0u) const;
+
+		// Drops the draws, keeps what was registered
+		void Clear();
+		// Drops the draws and the registered pipelines, sets and meshes
+		void Reset();
+
+		const size_t GetDrawCount() const { return Draws.size(); }
+
+	private:
+		struct SortEntry
+		{
+			uint64_t Key;
+			uint32_t Index;
+		};
+
+		std::vector<PipelineBinding> Pipelines;
+		std::vector<VkDescriptorSet> DescriptorSets = { VK_NULL_HANDLE };
+		std::vector<MeshBinding> Meshes;
+
+		std::vector<DrawItem> Draws;
+		std::vector<uint8_t> PushConstantData;
+		// Sorted view on Draws plus the scratch buffer the radix passes ping-pong with
+		std::vector<SortEntry> Order;
+		std::vector<SortEntry> Scratch;
+	};
+}
+#endif // !_DRAWQUEUE_H_
+//-----------------------------------------------------------------------------
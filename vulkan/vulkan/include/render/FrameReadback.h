@@ -0,0 +1,71 @@
+//-----------------------------------------------------------------------------
+#ifndef _FRAMEREADBACK_H_
+#define _FRAMEREADBACK_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstdint>
+#include <vector>
+#pragma endregion
+#include <vulkan/vulkan.h>
+#include "render/MemoryTypeSelector.h"
+#include "render/TextureImporter.h"
+//-----------------------------------------------------------------------------
+namespace render
+{
+	struct FrameReadbackStats
+	{
+		uint64_t Recorded	= 0;
+		uint64_t Collected	= 0;
+	};
+	//-----------------------------------------------------------------------------
+	// Copies rendered images (swap chain or offscreen, 8 bit RGBA / BGRA)
+	// into host memory without stalling: each frame slot owns a readback
+	// buffer, the copy is recorded into that slot's command buffer and only
+	// read once the slot comes round again and its fence has signaled, a
+	// few frames later. Render thread only.
+	class FrameReadback
+	{
+	public:
+		FrameReadback(VkDevice device, const MemoryTypeSelector& memoryTypes, uint32_t framesInFlight);
+		// The GPU must be done with every recorded copy
+		~FrameReadback();
+		FrameReadback(const FrameReadback&) = delete;
+		FrameReadback& operator=(const FrameReadback&) = delete;
+
+		static const bool IsFormatSupported(VkFormat format);
+
+		// Records the copy of image, in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		// into the slot's buffer. Replaces a copy of the slot not collected yet.
+		void Record(VkCommandBuffer commandBuffer, uint32_t frameSlot, VkImage image, VkFormat format, VkExtent2D extent, uint64_t frame);
+		// Call once the slot's fence signaled: the copy it recorded last time
+		// round as RGBA, and the frame passed to Record. False when there is
+		// none.
+		const bool Collect(uint32_t frameSlot, RgbaImage& image, uint64_t& frame);
+
+		const FrameReadbackStats& GetStats() const { return Stats; }
+
+	private:
+		struct Slot
+		{
+			VkBuffer Buffer			= VK_NULL_HANDLE;
+			VkDeviceMemory Memory	= VK_NULL_HANDLE;
+			VkDeviceSize Size		= 0;
+			uint8_t* Mapped			= nullptr;
+			bool Coherent			= true;
+			VkFormat Format			= VK_FORMAT_UNDEFINED;
+			VkExtent2D Extent		= { 0, 0 };
+			uint64_t Frame			= 0;
+			bool Pending			= false;
+		};
+
+		void Allocate(Slot& slot, VkDeviceSize size);
+		void Release(Slot& slot);
+
+		VkDevice Device;
+		const MemoryTypeSelector& MemoryTypes;
+		std::vector<Slot> Slots;
+		FrameReadbackStats Stats;
+	};
+}
+#endif // !_FRAMEREADBACK_H_
+//-----------------------------------------------------------------------------
@@ -0,0 +1,102 @@
+//-----------------------------------------------------------------------------
+#ifndef _GEOMETRYPOOL_H_
+#define _GEOMETRYPOOL_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#pragma endregion
+#include <vulkan/vulkan.h>
+#include "render/BufferPool.h"
+//-----------------------------------------------------------------------------
+namespace render
+{
+	typedef uint32_t MeshHandle;
+	const MeshHandle InvalidMeshHandle = ~0u;
+	//-----------------------------------------------------------------------------
+	struct GeometryPoolDesc
+	{
+		// One vertex layout and one index type for every mesh
+		uint32_t VertexStride					= 0;
+		VkIndexType IndexType					= VK_INDEX_TYPE_UINT32;
+		VkDeviceSize VertexBytes				= 64ull << 20;
+		VkDeviceSize IndexBytes					= 32ull << 20;
+		VkMemoryPropertyFlags MemoryProperties	= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		uint32_t FramesInFlight					= 2;
+		// Per buffer, see BufferPoolDesc
+		VkDeviceSize DefragBytesPerFrame		= 2ull << 20;
+	};
+	//-----------------------------------------------------------------------------
+	// Where a mesh sits in the shared buffers, straight into vkCmdDrawIndexed
+	struct MeshRange
+	{
+		int32_t VertexOffset	= 0;
+		uint32_t VertexCount	= 0;
+		uint32_t FirstIndex		= 0;
+		uint32_t IndexCount		= 0;
+		// To fill the mesh, see BufferRange
+		BufferRange Vertices;
+		BufferRange Indices;
+	};
+	//-----------------------------------------------------------------------------
+	struct GeometryPoolStats
+	{
+		uint32_t Meshes				= 0;
+		BufferPoolStats Vertices;
+		BufferPoolStats Indices;
+	};
+	//-----------------------------------------------------------------------------
+	// Every mesh in one vertex buffer and one index buffer, so a whole pass
+	// binds them once and draws each mesh by offset (which multi-draw-indirect
+	// needs as well). Both buffers are single block BufferPools: freed space
+	// is reused through their free lists and Defragment compacts them.
+	//
+	// Resolve meshes every frame after Defragment, their offsets move.
+	// AddMesh, RemoveMesh and GetMesh may be called from any thread.
+	class GeometryPool
+	{
+	public:
+		typedef BufferPool::MemoryTypeFinder MemoryTypeFinder;
+
+		GeometryPool(VkDevice device, MemoryTypeFinder findMemoryType, const GeometryPoolDesc& desc);
+		GeometryPool(const GeometryPool&) = delete;
+		GeometryPool& operator=(const GeometryPool&) = delete;
+
+		// Reserves room for the mesh, fill it through GetMesh. Throws when full.
+		MeshHandle AddMesh(uint32_t vertexCount, uint32_t indexCount);
+		void RemoveMesh(MeshHandle mesh);
+		const MeshRange GetMesh(MeshHandle mesh) const;
+
+		VkBuffer GetVertexBuffer() const { return Vertices->GetBuffer(); }
+		VkBuffer GetIndexBuffer() const { return Indices->GetBuffer(); }
+		const VkIndexType GetIndexType() const { return Desc.IndexType; }
+
+		// See BufferPool
+		void BeginFrame(uint32_t frameSlot);
+		void Defragment(VkCommandBuffer commandBuffer);
+
+		const GeometryPoolStats GetStats() const;
+
+	private:
+		struct Mesh
+		{
+			BufferAllocation Vertices	= InvalidBufferAllocation;
+			BufferAllocation Indices	= InvalidBufferAllocation;
+			uint32_t VertexCount		= 0;
+			uint32_t IndexCount			= 0;
+		};
+
+		GeometryPoolDesc Desc;
+		uint32_t IndexSize;
+		std::unique_ptr<BufferPool> Vertices;
+		std::unique_ptr<BufferPool> Indices;
+
+		mutable std::mutex Lock;
+		std::vector<Mesh> Meshes;
+		std::vector<MeshHandle> FreeHandles;
+	};
+}
+#endif // !_GEOMETRYPOOL_H_
+//-----------------------------------------------------------------------------
@@ -0,0 +1,27 @@
+//-----------------------------------------------------------------------------
+#ifndef _HASH_H_
+#define _HASH_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#pragma endregion
+//-----------------------------------------------------------------------------
+namespace render
+{
+	// Hashing for the layout, descriptor set and pipeline caches
+	inline void HashCombine(size_t& seed, size_t value)
+	{
+		seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	}
+	//-----------------------------------------------------------------------------
+	template <typename T>
+	inline size_t HashHandle(T handle)
+	{
+		// Non-dispatchable handles are pointers or uint64_t depending on the platform
+		return std::hash<uint64_t>()((uint64_t)(handle));
+	}
+}
+#endif // !_HASH_H_
+//-----------------------------------------------------------------------------
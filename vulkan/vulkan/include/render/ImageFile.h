@@ -0,0 +1,36 @@
+//-----------------------------------------------------------------------------
+#ifndef _IMAGEFILE_H_
+#define _IMAGEFILE_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstdint>
+#include <string>
+#pragma endregion
+#include "render/TextureImporter.h"
+//-----------------------------------------------------------------------------
+namespace render
+{
+	// How far a captured frame is from its golden image, RGB only (the
+	// alpha of a swap chain image means nothing and PPM has none)
+	struct ImageDifference
+	{
+		bool SizeMismatch		= false;
+		// Per channel, 0 - 255
+		float MeanAbsoluteError	= 0.0f;
+		uint32_t MaxDelta		= 0;
+		// Infinite for identical images
+		float Psnr				= 0.0f;
+		// Any channel off by more than the pixel threshold
+		uint32_t DifferingPixels	= 0;
+	};
+	//-----------------------------------------------------------------------------
+	// .png (RGBA, stored without compression) or .ppm (binary P6, RGB) by
+	// extension. Throws when the file can't be written.
+	void WriteImage(const std::string& path, const RgbaImage& image);
+	// Binary P6 with a maxval of 255, alpha comes back opaque. Throws on
+	// anything else.
+	const RgbaImage ReadPpm(const std::string& path);
+	const ImageDifference CompareImages(const RgbaImage& image, const RgbaImage& golden, uint32_t pixelThreshold = 2);
+}
+#endif // !_IMAGEFILE_H_
+//-----------------------------------------------------------------------------
@@ -0,0 +1,56 @@
+//-----------------------------------------------------------------------------
+#ifndef _KTX2FILE_H_
+#define _KTX2FILE_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstdint>
+#include <string>
+#include <vector>
+#pragma endregion
+#include <vulkan/vulkan.h>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	struct Ktx2Level
+	{
+		uint64_t ByteOffset	= 0;
+		uint64_t ByteLength	= 0;
+		uint32_t Width		= 0;
+		uint32_t Height		= 0;
+	};
+	//-----------------------------------------------------------------------------
+	// Header and level index of a KTX2 container. Only block compressed and
+	// plain RGBA8 2D textures without supercompression are accepted, so every
+	// level can be copied to the GPU as it is stored. Level 0 is the largest one.
+	class Ktx2File
+	{
+	public:
+		// Throws if the file cannot be read or holds something else than a BCn / RGBA8 2D texture
+		explicit Ktx2File(const std::string& path);
+		// levels[0] is the largest, only BC1 and BC7 get a data format descriptor
+		static void Write(const std::string& path, VkFormat format, uint32_t width, uint32_t height, const std::vector<std::vector<char>>& levels);
+
+		// Reads one level from disk, safe to call from several threads at once
+		std::vector<char> ReadLevel(uint32_t level) const;
+
+		const std::string& GetPath() const { return Path; }
+		const VkFormat GetFormat() const { return Format; }
+		const uint32_t GetLevelCount() const { return static_cast<uint32_t>(Levels.size()); }
+		const Ktx2Level& GetLevel(uint32_t level) const { return Levels.at(level); }
+		// Bytes of a block: 8 for BC1 and BC4, 16 for the other BCn, 4 for a RGBA8 texel
+		const uint32_t GetBlockSize() const { return BlockSize; }
+		// Texels per block side, 4 for BCn and 1 for RGBA8
+		const uint32_t GetBlockExtent() const { return BlockExtent; }
+
+		static const bool IsBlockCompressed(VkFormat format);
+
+	private:
+		std::string Path;
+		VkFormat Format			= VK_FORMAT_UNDEFINED;
+		uint32_t BlockSize		= 0;
+		uint32_t BlockExtent	= 0;
+		std::vector<Ktx2Level> Levels;
+	};
+}
+#endif // !_KTX2FILE_H_
+//-----------------------------------------------------------------------------
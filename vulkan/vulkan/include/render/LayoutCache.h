@@ -0,0 +1,72 @@
+//-----------------------------------------------------------------------------
+#ifndef _LAYOUTCACHE_H_
+#define _LAYOUTCACHE_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#pragma endregion
+#include <vulkan/vulkan.h>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	struct LayoutCacheStats
+	{
+		uint32_t DescriptorSetLayouts	= 0;
+		uint32_t PipelineLayouts		= 0;
+		uint32_t Hits					= 0;
+		uint32_t Misses					= 0;
+	};
+	//-----------------------------------------------------------------------------
+	// Hash-consing store for descriptor set and pipeline layouts: equal
+	// descriptions always return the same handle, so pipelines built from
+	// different shaders with the same interface share their layouts and stay
+	// compatible for descriptor binding. Owns every layout it hands out,
+	// they live until the cache is destroyed. Safe to use from several threads.
+	class LayoutCache
+	{
+	public:
+		LayoutCache(VkDevice device);
+		~LayoutCache();
+		LayoutCache(const LayoutCache&) = delete;
+		LayoutCache& operator=(const LayoutCache&) = delete;
+
+		// Binding order does not matter, immutable samplers are not supported
+		VkDescriptorSetLayout GetDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, VkDescriptorSetLayoutCreateFlags flags = 0);
+		VkPipelineLayout GetPipelineLayout(const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstants);
+
+		const LayoutCacheStats GetStats() const;
+
+	private:
+		struct SetLayoutKey
+		{
+			VkDescriptorSetLayoutCreateFlags Flags;
+			std::vector<VkDescriptorSetLayoutBinding> Bindings;
+			bool operator==(const SetLayoutKey& other) const;
+		};
+		struct SetLayoutKeyHash
+		{
+			size_t operator()(const SetLayoutKey& key) const;
+		};
+		struct PipelineLayoutKey
+		{
+			std::vector<VkDescriptorSetLayout> SetLayouts;
+			std::vector<VkPushConstantRange> PushConstants;
+			bool operator==(const PipelineLayoutKey& other) const;
+		};
+		struct PipelineLayoutKeyHash
+		{
+			size_t operator()(const PipelineLayoutKey& key) const;
+		};
+
+		VkDevice Device;
+		mutable std::mutex Lock;
+		std::unordered_map<SetLayoutKey, VkDescriptorSetLayout, SetLayoutKeyHash> SetLayouts;
+		std::unordered_map<PipelineLayoutKey, VkPipelineLayout, PipelineLayoutKeyHash> PipelineLayouts;
+		LayoutCacheStats Stats;
+	};
+}
+#endif // !_LAYOUTCACHE_H_
+//-----------------------------------------------------------------------------
@@ -0,0 +1,98 @@
+//-----------------------------------------------------------------------------
+#ifndef _MEMORYTELEMETRY_H_
+#define _MEMORYTELEMETRY_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+#pragma endregion
+#include <vulkan/vulkan.h>
+#include "render/MemoryTypeSelector.h"
+//-----------------------------------------------------------------------------
+namespace render
+{
+	enum class MemoryCategory : uint32_t
+	{
+		Vertex,
+		Index,
+		Uniform,
+		Staging,
+		Texture,
+		Other,
+		Count
+	};
+	//-----------------------------------------------------------------------------
+	struct MemoryHeapReport
+	{
+		VkDeviceSize Size		= 0;
+		bool DeviceLocal		= false;
+		// From VK_EXT_memory_budget, otherwise a share of Size and what we tracked
+		VkDeviceSize Budget		= 0;
+		VkDeviceSize Usage		= 0;
+		// Our own allocations in this heap, per MemoryCategory
+		VkDeviceSize Tracked[static_cast<uint32_t>(MemoryCategory::Count)] = {};
+	};
+	//-----------------------------------------------------------------------------
+	// Device memory per heap: what the driver says the process may use and
+	// uses (VK_EXT_memory_budget), and what we allocated, split by category.
+	// Without the extension the budget falls back to a share of the heap size
+	// and the usage to what was tracked. Allocations can be tracked from any
+	// thread, Update and the getters belong to the render thread.
+	class MemoryTelemetry
+	{
+	public:
+		// budgetEnabled: VK_EXT_memory_budget was enabled on the device, see IsBudgetSupported
+		MemoryTelemetry(VkPhysicalDevice physicalDevice, const MemoryTypeSelector& memoryTypes, bool budgetEnabled);
+
+		// Needs vkGetPhysicalDeviceMemoryProperties2, core since 1.1
+		static const bool IsBudgetSupported(VkPhysicalDevice physicalDevice, uint32_t instanceApiVersion);
+		static const MemoryCategory GetCategory(VkBufferUsageFlags usage);
+		static const char* GetCategoryName(MemoryCategory category);
+
+		void OnAllocate(VkDeviceMemory memory, MemoryCategory category, uint32_t typeIndex, VkDeviceSize size);
+		// Ignores memory it never saw
+		void OnFree(VkDeviceMemory memory);
+		// For allocators reporting a total instead of each allocation, replaces
+		// their previous report
+		void SetExternal(MemoryCategory category, uint32_t heapIndex, VkDeviceSize size);
+
+		// Once per frame, before the getters
+		void Update();
+		const std::vector<MemoryHeapReport>& GetHeaps() const { return Heaps; }
+		// Budget left in the heap, 0 when over it
+		const VkDeviceSize GetHeadroom(uint32_t heapIndex) const;
+		// Heap device local allocations land in
+		const uint32_t GetDeviceLocalHeap() const { return DeviceLocalHeap; }
+		const bool IsBudgetEnabled() const { return BudgetEnabled; }
+
+		void PrintReport(std::ostream& out) const;
+
+		// Share of a heap assumed available without VK_EXT_memory_budget
+		static const float FallbackBudgetShare;
+
+	private:
+		struct Allocation
+		{
+			MemoryCategory Category;
+			uint32_t HeapIndex;
+			VkDeviceSize Size;
+		};
+
+		VkPhysicalDevice PhysicalDevice;
+		const MemoryTypeSelector& MemoryTypes;
+		bool BudgetEnabled;
+		uint32_t DeviceLocalHeap = 0;
+
+		std::mutex TrackedLock;
+		std::unordered_map<VkDeviceMemory, Allocation> Allocations;
+		std::vector<MemoryHeapReport> TrackedHeaps;
+		std::vector<MemoryHeapReport> ExternalHeaps;
+
+		std::vector<MemoryHeapReport> Heaps;
+	};
+}
+#endif // !_MEMORYTELEMETRY_H_
+//-----------------------------------------------------------------------------
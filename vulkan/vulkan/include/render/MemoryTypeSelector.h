@@ -0,0 +1,70 @@
+//-----------------------------------------------------------------------------
+#ifndef _MEMORYTYPESELECTOR_H_
+#define _MEMORYTYPESELECTOR_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstdint>
+#pragma endregion
+#include <vulkan/vulkan.h>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	// What an allocation needs from its memory type. Types missing a Required
+	// flag are never picked; among the rest every Preferred flag present and
+	// every Avoided flag absent counts, ties go to the bigger heap.
+	struct MemoryRequest
+	{
+		VkMemoryPropertyFlags Required	= 0;
+		VkMemoryPropertyFlags Preferred	= 0;
+		VkMemoryPropertyFlags Avoided	= 0;
+
+		// Only the GPU touches it
+		static const MemoryRequest DeviceLocal();
+		// Written once by the CPU, copied from by the GPU
+		static const MemoryRequest Staging();
+		// Written by the CPU and read by the GPU in place, see CanMapDeviceLocal
+		static const MemoryRequest DirectUpload();
+		// Written by the GPU, read back by the CPU
+		static const MemoryRequest Readback();
+		// Plain property flags: what is left out is avoided rather than
+		// ignored, so device local memory stays out of the BAR and host
+		// visible memory out of VRAM
+		static const MemoryRequest Exactly(VkMemoryPropertyFlags properties);
+	};
+	//-----------------------------------------------------------------------------
+	// Ranks the memory types of one physical device, whose properties are read
+	// once at creation. Immutable afterwards, so safe to share between threads.
+	class MemoryTypeSelector
+	{
+	public:
+		explicit MemoryTypeSelector(VkPhysicalDevice physicalDevice);
+
+		// Best type among typeFilter (VkMemoryRequirements::memoryTypeBits), false if none qualifies
+		const bool Find(uint32_t typeFilter, const MemoryRequest& request, uint32_t& typeIndex) const;
+		// Same, throws when nothing qualifies
+		const uint32_t Select(uint32_t typeFilter, const MemoryRequest& request) const;
+
+		// Integrated GPU (by device type): device local memory is system memory
+		const bool IsUnifiedMemory() const { return UnifiedMemory; }
+		// Discrete GPU exposing its whole memory to the CPU (resizable BAR),
+		// not just the classic 256 MB window
+		const bool HasResizableBar() const { return ResizableBar; }
+		// Either of the above, with a type DirectUpload can use: device local
+		// buffers can be written through a mapping and skip the staging copy
+		const bool CanMapDeviceLocal() const { return (UnifiedMemory || ResizableBar) && DirectUploadAvailable; }
+
+		const VkPhysicalDeviceMemoryProperties& GetProperties() const { return Properties; }
+		const uint32_t GetHeapIndex(uint32_t typeIndex) const { return Properties.memoryTypes[typeIndex].heapIndex; }
+
+		// Host visible device local heaps up to this size are the legacy BAR window
+		static const VkDeviceSize LegacyBarSize = 256ull << 20;
+
+	private:
+		VkPhysicalDeviceMemoryProperties Properties;
+		bool UnifiedMemory			= false;
+		bool ResizableBar			= false;
+		bool DirectUploadAvailable	= false;
+	};
+}
+#endif // !_MEMORYTYPESELECTOR_H_
+//-----------------------------------------------------------------------------
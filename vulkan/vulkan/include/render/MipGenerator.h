@@ -0,0 +1,69 @@
+//-----------------------------------------------------------------------------
+#ifndef _MIPGENERATOR_H_
+#define _MIPGENERATOR_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstdint>
+#include <functional>
+#include <vector>
+#pragma endregion
+#include <vulkan/vulkan.h>
+#include "render/DescriptorAllocator.h"
+#include "render/LayoutCache.h"
+//-----------------------------------------------------------------------------
+namespace render
+{
+	// Builds the mip chain of a RGBA8 image with one compute dispatch
+	// (content/shader/mipgen.comp) instead of a blit per level: each group
+	// reduces a 64x64 tile through shared memory, the last group to finish
+	// carries on from level 6. Bases up to 4096 texels get their full chain.
+	class MipGenerator
+	{
+	public:
+		typedef std::function<uint32_t(uint32_t, VkMemoryPropertyFlags)> MemoryTypeFinder;
+		// Levels below level 0 a single dispatch can write
+		static const uint32_t MaxGeneratedLevels = 12;
+		// The last group only reduces one 64x64 tile of level 6
+		static const uint32_t MaxBaseSize = 4096;
+
+		MipGenerator(VkDevice device, LayoutCache& layouts, const std::vector<char>& shaderCode, MemoryTypeFinder findMemoryType, VkPipelineCache cache = VK_NULL_HANDLE);
+		~MipGenerator();
+		MipGenerator(const MipGenerator&) = delete;
+		MipGenerator& operator=(const MipGenerator&) = delete;
+
+		// Fills levels 1.. of a VK_FORMAT_R8G8B8A8_UNORM image created with
+		// STORAGE and SAMPLED usage. Level 0 must be in TRANSFER_DST_OPTIMAL,
+		// every level ends up in SHADER_READ_ONLY_OPTIMAL. Records compute
+		// and transfer work only, so it fits a compute-only queue; readers on
+		// other queues wait on its submission.
+		void Generate(VkCommandBuffer commandBuffer, VkImage image, VkExtent2D extent, uint32_t levelCount);
+		// Frees the views and sets of the Generate calls so far, the GPU must be done with them
+		void Reset();
+
+	private:
+		struct MipConstants
+		{
+			float InvSourceSize[2];
+			uint32_t MipCount;
+			uint32_t GroupCount;
+		};
+
+		VkImageView CreateLevelView(VkImage image, uint32_t level);
+
+		VkDevice Device;
+		VkShaderModule Module				= VK_NULL_HANDLE;
+		// Owned by the layout cache
+		VkDescriptorSetLayout SetLayout		= VK_NULL_HANDLE;
+		VkPipelineLayout PipelineLayout		= VK_NULL_HANDLE;
+		VkPipeline Pipeline					= VK_NULL_HANDLE;
+		VkSampler Sampler					= VK_NULL_HANDLE;
+		// Groups finished so far, cleared before every dispatch
+		VkBuffer CounterBuffer				= VK_NULL_HANDLE;
+		VkDeviceMemory CounterMemory		= VK_NULL_HANDLE;
+
+		DescriptorAllocator Descriptors;
+		std::vector<VkImageView> Views;
+	};
+}
+#endif // !_MIPGENERATOR_H_
+//-----------------------------------------------------------------------------
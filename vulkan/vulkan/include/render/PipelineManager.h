@@ -0,0 +1,150 @@
+//-----------------------------------------------------------------------------
+#ifndef _PIPELINEMANAGER_H_
+#define _PIPELINEMANAGER_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#pragma endregion
+#include <vulkan/vulkan.h>
+#include "core/JobSystem.h"
+//-----------------------------------------------------------------------------
+namespace render
+{
+	typedef uint32_t PipelineHandle;
+	const PipelineHandle InvalidPipelineHandle = ~0u;
+
+	enum class PipelineStatus : uint32_t
+	{
+		Pending,
+		Ready,
+		Failed
+	};
+	//-----------------------------------------------------------------------------
+	// One layout(constant_id = Id) value, 32-bit like every scalar spec constant
+	struct SpecializationConstant
+	{
+		uint32_t Id;
+		uint32_t Value;
+	};
+	//-----------------------------------------------------------------------------
+	struct PipelineShaderStage
+	{
+		VkShaderStageFlagBits Stage;
+		VkShaderModule Module;
+		// Sorted by Id, see PermutationTable::Apply
+		std::vector<SpecializationConstant> Constants;
+	};
+	//-----------------------------------------------------------------------------
+	// Everything a graphics pipeline is built from, owned by value so it can
+	// be compiled on another thread later. Doubles as the cache key.
+	struct GraphicsPipelineDesc
+	{
+		std::vector<PipelineShaderStage> Stages;
+		std::vector<VkVertexInputBindingDescription> VertexBindings;
+		std::vector<VkVertexInputAttributeDescription> VertexAttributes;
+		VkPrimitiveTopology Topology	= VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		VkPolygonMode PolygonMode		= VK_POLYGON_MODE_FILL;
+		VkCullModeFlags CullMode		= VK_CULL_MODE_BACK_BIT;
+		VkFrontFace FrontFace			= VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		bool BlendEnable				= false;
+		// Viewport and scissor are baked in
+		VkExtent2D Extent				= { 0, 0 };
+		VkPipelineLayout Layout			= VK_NULL_HANDLE;
+		VkRenderPass RenderPass			= VK_NULL_HANDLE;
+		uint32_t Subpass				= 0;
+
+		const size_t Hash() const;
+		bool operator==(const GraphicsPipelineDesc& other) const;
+	};
+	//-----------------------------------------------------------------------------
+	struct PipelineManagerStats
+	{
+		uint32_t Requests			= 0;
+		uint32_t Hits				= 0;
+		uint32_t Compiled			= 0;
+		uint32_t Failed				= 0;
+		float CompileMs				= 0.0f;
+	};
+	//-----------------------------------------------------------------------------
+	// Compiles pipelines on the job system's workers through one shared
+	// VkPipelineCache. Request() returns at once with a handle that becomes
+	// ready later; until then Resolve() hands out its fallback, or nothing so
+	// the draw can be skipped. A new permutation never stalls the frame.
+	class PipelineManager
+	{
+	public:
+		PipelineManager(VkDevice device, core::JobSystem& jobs);
+		// Waits for the compiles still in flight
+		~PipelineManager();
+		PipelineManager(const PipelineManager&) = delete;
+		PipelineManager& operator=(const PipelineManager&) = delete;
+
+		// Same desc, same handle. The fallback should be a pipeline requested
+		// with RequestNow, so something is always there to draw with.
+		PipelineHandle Request(const GraphicsPipelineDesc& desc, PipelineHandle fallback = InvalidPipelineHandle);
+		// Compiles on the calling thread, for pipelines a frame can't do without
+		PipelineHandle RequestNow(const GraphicsPipelineDesc& desc);
+
+		const PipelineStatus GetStatus(PipelineHandle handle) const;
+		// handle if it is ready, else its fallback if that one is, else InvalidPipelineHandle
+		const PipelineHandle Resolve(PipelineHandle handle) const;
+		// VK_NULL_HANDLE unless ready
+		VkPipeline GetPipeline(PipelineHandle handle) const;
+
+		void WaitIdle();
+		// Destroys every pipeline and invalidates every handle, the GPU must be
+		// done with them. The VkPipelineCache is kept, so re-requests are cheap.
+		void Clear();
+		// Same, handing each pipeline to retire instead of destroying it
+		void Clear(const std::function<void(VkPipeline)>& retire);
+		// Before destroying a shader module: requests stop matching the
+		// pipelines built from it, so a recycled handle can't hit them. Waits
+		// for those still compiling. The pipelines stay valid until Clear.
+		void Forget(VkShaderModule module);
+
+		VkPipelineCache GetCache() const { return Cache; }
+		const PipelineManagerStats GetStats() const;
+
+	private:
+		struct Entry
+		{
+			GraphicsPipelineDesc Desc;
+			PipelineHandle Fallback;
+			std::atomic<PipelineStatus> Status;
+			// Written by the compiling worker before Status turns Ready
+			VkPipeline Pipeline = VK_NULL_HANDLE;
+		};
+		struct DescHash
+		{
+			size_t operator()(const GraphicsPipelineDesc& desc) const { return desc.Hash(); }
+		};
+
+		PipelineHandle Insert(const GraphicsPipelineDesc& desc, PipelineHandle fallback, Entry*& created);
+		const Entry* Find(PipelineHandle handle) const;
+		void Compile(Entry& entry);
+
+		VkDevice Device;
+		core::JobSystem& Jobs;
+		VkPipelineCache Cache = VK_NULL_HANDLE;
+
+		mutable std::mutex Lock;
+		// Handle is the index, entries never move
+		std::deque<std::unique_ptr<Entry>> Entries;
+		std::unordered_map<GraphicsPipelineDesc, PipelineHandle, DescHash> Lookup;
+		core::JobCounter InFlight;
+
+		PipelineManagerStats Stats;
+		std::atomic<uint32_t> Compiled;
+		std::atomic<uint32_t> Failed;
+		std::atomic<uint64_t> CompileMicroseconds;
+	};
+}
+#endif // !_PIPELINEMANAGER_H_
+//-----------------------------------------------------------------------------
@@ -0,0 +1,47 @@
+//-----------------------------------------------------------------------------
+#ifndef _PRESENTPOLICY_H_
+#define _PRESENTPOLICY_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <string>
+#include <vector>
+#pragma endregion
+#include <vulkan/vulkan.h>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	// How frames reach the screen, picked per deployment
+	enum class PresentProfile
+	{
+		// MAILBOX, then IMMEDIATE (tears), then FIFO. Renders as fast as it can
+		// unless a frame cap is set.
+		LowestLatency,
+		// FIFO paced to a frame cap, the GPU and CPU idle between frames
+		PowerSaving,
+		// FIFO_RELAXED: vsynced, but a late frame is shown at once instead of
+		// waiting for the next refresh. FIFO when not supported.
+		FifoRelaxed
+	};
+	//-----------------------------------------------------------------------------
+	struct PresentPolicy
+	{
+		PresentProfile Profile	= PresentProfile::LowestLatency;
+		// Frames per second the pacer holds, 0 leaves the rate to the present mode
+		float FrameCap			= 0.0f;
+
+		// Power saving without an explicit cap
+		static const float DefaultPowerSavingCap;
+
+		// lowest-latency, power-saving or fifo-relaxed
+		static const bool ParseProfile(const std::string& name, PresentProfile& profile);
+		static const char* GetProfileName(PresentProfile profile);
+
+		// First mode of the profile's preference list the surface supports,
+		// FIFO is always there
+		const VkPresentModeKHR ChoosePresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) const;
+		// Target interval between presents in milliseconds, 0 when uncapped
+		const double GetFrameIntervalMs() const;
+	};
+}
+#endif // !_PRESENTPOLICY_H_
+//-----------------------------------------------------------------------------
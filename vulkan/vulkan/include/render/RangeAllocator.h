@@ -0,0 +1,44 @@
+//-----------------------------------------------------------------------------
+#ifndef _RANGEALLOCATOR_H_
+#define _RANGEALLOCATOR_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstdint>
+#include <map>
+#pragma endregion
+#include <vulkan/vulkan.h>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	// Offsets into a fixed size range, for suballocating buffers. Free ranges
+	// are kept sorted by offset and merged with their neighbours on Free.
+	// Not thread-safe.
+	class RangeAllocator
+	{
+	public:
+		explicit RangeAllocator(VkDeviceSize size = 0);
+
+		// Smallest free range the aligned size fits in, false if none does
+		const bool Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+		// Lowest offset the aligned size fits at, ending at or before limit.
+		// Compaction moves allocations there.
+		const bool AllocateBelow(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize limit, VkDeviceSize& offset);
+		// The exact range an Allocate returned
+		void Free(VkDeviceSize offset, VkDeviceSize size);
+
+		const VkDeviceSize GetSize() const { return Size; }
+		const VkDeviceSize GetUsed() const { return Used; }
+		const VkDeviceSize GetLargestFree() const;
+		const size_t GetFreeRangeCount() const { return FreeRanges.size(); }
+
+	private:
+		void Take(std::map<VkDeviceSize, VkDeviceSize>::iterator range, VkDeviceSize offset, VkDeviceSize size);
+
+		VkDeviceSize Size;
+		VkDeviceSize Used = 0;
+		// Offset to size
+		std::map<VkDeviceSize, VkDeviceSize> FreeRanges;
+	};
+}
+#endif // !_RANGEALLOCATOR_H_
+//-----------------------------------------------------------------------------
@@ -0,0 +1,241 @@
+//-----------------------------------------------------------------------------
+#ifndef _RENDERGRAPH_H_
+#define _RENDERGRAPH_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <functional>
+#include <string>
+#include <vector>
+#pragma endregion
+#include <vulkan/vulkan.h>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	typedef uint32_t ResourceHandle;
+	const ResourceHandle InvalidResource = ~0u;
+	//-----------------------------------------------------------------------------
+	// How a pass touches an image. Stage, access mask and layout are derived
+	// from it, passes never spell barriers out by hand.
+	enum class ResourceUsage
+	{
+		ColorAttachment,
+		DepthAttachment,
+		DepthRead,
+		FragmentRead,
+		ComputeRead,
+		ComputeWrite,
+		TransferSrc,
+		TransferDst
+	};
+	//-----------------------------------------------------------------------------
+	struct ImageDesc
+	{
+		VkFormat Format					= VK_FORMAT_UNDEFINED;
+		VkExtent2D Extent				= { 0, 0 };
+		VkImageAspectFlags Aspect		= VK_IMAGE_ASPECT_COLOR_BIT;
+		uint32_t MipLevels				= 1;
+		// Transients get the union of what their passes need on top of this
+		VkImageUsageFlags ExtraUsage	= 0;
+	};
+	//-----------------------------------------------------------------------------
+	// State an imported image is in before the graph runs, or has to be left in
+	struct ImageState
+	{
+		VkImageLayout Layout			= VK_IMAGE_LAYOUT_UNDEFINED;
+		VkPipelineStageFlags Stage		= VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		VkAccessFlags Access			= 0;
+	};
+	//-----------------------------------------------------------------------------
+	struct RenderGraphStats
+	{
+		uint32_t DeclaredPasses		= 0;
+		uint32_t CulledPasses		= 0;
+		uint32_t Barriers			= 0;
+		uint32_t TransientImages	= 0;
+		// Memory the transients would take without aliasing vs what was allocated
+		VkDeviceSize TransientBytes	= 0;
+		VkDeviceSize AllocatedBytes	= 0;
+	};
+	//-----------------------------------------------------------------------------
+	class RenderGraph;
+	class PassBuilder
+	{
+	public:
+		ResourceHandle Create(const std::string& name, const ImageDesc& desc);
+		ResourceHandle Read(ResourceHandle resource, ResourceUsage usage);
+		ResourceHandle Write(ResourceHandle resource, ResourceUsage usage);
+		// Pass does something outside the graph and must never be culled
+		void SetSideEffect();
+
+	private:
+		friend class RenderGraph;
+		PassBuilder(RenderGraph& graph, uint32_t passIndex) : Graph(graph), PassIndex(passIndex) {}
+		RenderGraph& Graph;
+		uint32_t PassIndex;
+	};
+	//-----------------------------------------------------------------------------
+	struct PassContext
+	{
+		VkCommandBuffer CommandBuffer;
+		const RenderGraph* Graph;
+	};
+	//-----------------------------------------------------------------------------
+	// Frame graph: passes declare which virtual images they read and write,
+	// Compile() culls what does not reach an output, works out the minimal set
+	// of pipeline barriers / layout transitions and places transient images
+	// with disjoint lifetimes on the same memory.
+	class RenderGraph
+	{
+	public:
+		typedef std::function<void(PassBuilder&)> SetupFunction;
+		typedef std::function<void(PassContext&)> ExecuteFunction;
+		typedef std::function<uint32_t(uint32_t, VkMemoryPropertyFlags)> MemoryTypeFinder;
+
+		RenderGraph(VkDevice device, MemoryTypeFinder findMemoryType);
+		~RenderGraph();
+		RenderGraph(const RenderGraph&) = delete;
+		RenderGraph& operator=(const RenderGraph&) = delete;
+
+		ResourceHandle ImportImage(const std::string& name, VkImage image, VkImageView view, const ImageDesc& desc, const ImageState& initialState);
+		void AddPass(const std::string& name, SetupFunction setup, ExecuteFunction execute);
+		// The graph leaves resource in finalState and keeps every pass that feeds it
+		void MarkOutput(ResourceHandle resource, const ImageState& finalState);
+
+		void Compile();
+		void Execute(VkCommandBuffer commandBuffer) const;
+		// Drops passes and resources. Transient memory is kept and reused by the
+		// next Compile() when the transient layout did not change.
+		void Reset();
+		// Frees the transient images, the GPU must be done with them
+		void ReleaseTransients();
+
+		VkImage GetImage(ResourceHandle resource) const;
+		VkImageView GetImageView(ResourceHandle resource) const;
+		const ImageDesc& GetDesc(ResourceHandle resource) const;
+		const RenderGraphStats& GetStats() const { return Stats; }
+
+	private:
+		friend class PassBuilder;
+
+		struct Access
+		{
+			ResourceHandle Resource;
+			ResourceUsage Usage;
+			bool IsWrite;
+		};
+
+		struct Pass
+		{
+			std::string Name;
+			ExecuteFunction Execute;
+			std::vector<Access> Accesses;
+			bool SideEffect		= false;
+			bool Culled			= false;
+			uint32_t RefCount	= 0;
+		};
+
+		// What happened to an image so far while walking the compiled passes
+		struct TrackedState
+		{
+			VkImageLayout Layout				= VK_IMAGE_LAYOUT_UNDEFINED;
+			VkPipelineStageFlags WriteStage		= 0;
+			VkAccessFlags WriteAccess			= 0;
+			// Reads since the last write, they already waited for it
+			VkPipelineStageFlags ReadStages		= 0;
+			VkAccessFlags ReadAccess			= 0;
+			bool Touched						= false;
+		};
+
+		struct Resource
+		{
+			std::string Name;
+			ImageDesc Desc;
+			bool Imported		= false;
+			bool IsOutput		= false;
+			ImageState Initial;
+			ImageState Final;
+			VkImage Image		= VK_NULL_HANDLE;
+			VkImageView View	= VK_NULL_HANDLE;
+			VkImageUsageFlags Usage = 0;
+			std::vector<uint32_t> Producers;
+			uint32_t RefCount	= 0;
+			// Lifetime in compiled pass order, used for aliasing
+			uint32_t FirstUse	= ~0u;
+			uint32_t LastUse	= 0;
+			// Transients that lived on the same memory before this one
+			std::vector<ResourceHandle> AliasPredecessors;
+			TrackedState State;
+			uint32_t TransientSlot = ~0u;
+		};
+
+		struct BarrierBatch
+		{
+			VkPipelineStageFlags SrcStage = 0;
+			VkPipelineStageFlags DstStage = 0;
+			std::vector<VkImageMemoryBarrier> Barriers;
+		};
+
+		struct CompiledPass
+		{
+			uint32_t PassIndex;
+			BarrierBatch Before;
+		};
+
+		// Backing storage of a transient, survives Reset() for reuse
+		struct TransientImage
+		{
+			ImageDesc Desc;
+			VkImageUsageFlags Usage;
+			uint32_t FirstUse;
+			uint32_t LastUse;
+			VkImage Image;
+			VkImageView View;
+			uint32_t Block;
+			VkDeviceSize Offset;
+			VkDeviceSize Size;
+		};
+
+		struct MemoryBlock
+		{
+			uint32_t MemoryTypeIndex;
+			VkDeviceSize Size;
+			VkDeviceMemory Memory;
+		};
+
+		struct UsageInfo
+		{
+			VkPipelineStageFlags Stage;
+			VkAccessFlags ReadAccess;
+			VkAccessFlags WriteAccess;
+			VkImageLayout Layout;
+			VkImageUsageFlags ImageUsage;
+		};
+
+		static const UsageInfo GetUsageInfo(ResourceUsage usage);
+
+		ResourceHandle CreateTransient(const std::string& name, const ImageDesc& desc);
+		void AddAccess(uint32_t passIndex, ResourceHandle resource, ResourceUsage usage, bool isWrite);
+		void CullPasses();
+		void ComputeLifetimes();
+		void AllocateTransients();
+		void BuildBarriers();
+		void Transition(Resource& resource, VkImageLayout newLayout, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess, bool isWrite, BarrierBatch& batch);
+		const bool TransientLayoutMatches() const;
+
+		VkDevice Device;
+		MemoryTypeFinder FindMemoryType;
+
+		std::vector<Pass> Passes;
+		std::vector<Resource> Resources;
+		std::vector<CompiledPass> CompiledPasses;
+		BarrierBatch FinalBarriers;
+
+		std::vector<ResourceHandle> TransientOrder;
+		std::vector<TransientImage> Transients;
+		std::vector<MemoryBlock> Blocks;
+
+		RenderGraphStats Stats;
+	};
+}
+#endif // !_RENDERGRAPH_H_
+//-----------------------------------------------------------------------------
@@ -0,0 +1,68 @@
+//-----------------------------------------------------------------------------
+#ifndef _SHADERPERMUTATION_H_
+#define _SHADERPERMUTATION_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+#pragma endregion
+#include <vulkan/vulkan.h>
+#include "render/PipelineManager.h"
+//-----------------------------------------------------------------------------
+namespace render
+{
+	// One feature toggle: a layout(constant_id = ConstantId) in the shaders of
+	// Stages. Bools are 0 / 1, floats go through FloatBits.
+	struct PermutationOption
+	{
+		std::string Name;
+		uint32_t ConstantId;
+		VkShaderStageFlags Stages;
+		uint32_t Default;
+	};
+	//-----------------------------------------------------------------------------
+	class PermutationTable;
+	//-----------------------------------------------------------------------------
+	// A value for every option of a table, starts at the defaults
+	class ShaderPermutation
+	{
+	public:
+		// Throws on names the table does not declare
+		ShaderPermutation& Set(const std::string& name, uint32_t value);
+		const uint32_t Get(const std::string& name) const;
+
+	private:
+		friend class PermutationTable;
+		ShaderPermutation(const PermutationTable& table);
+
+		const PermutationTable* Table;
+		std::vector<uint32_t> Values;
+	};
+	//-----------------------------------------------------------------------------
+	// Declarative list of the specialization constants a shader family
+	// exposes. Variants are picked at pipeline creation instead of with
+	// runtime branches or extra SPIR-V files, so the driver folds them away;
+	// the PipelineManager cache is keyed by shader, constants and render state.
+	class PermutationTable
+	{
+	public:
+		PermutationTable(std::initializer_list<PermutationOption> options);
+
+		ShaderPermutation MakePermutation() const;
+		// Fills the constants of every desc stage the options apply to
+		void Apply(const ShaderPermutation& permutation, GraphicsPipelineDesc& desc) const;
+
+		// -1 when there is no such option
+		const int32_t FindOption(const std::string& name) const;
+		const std::vector<PermutationOption>& GetOptions() const { return Options; }
+
+	private:
+		std::vector<PermutationOption> Options;
+	};
+	//-----------------------------------------------------------------------------
+	const uint32_t FloatBits(float value);
+}
+#endif // !_SHADERPERMUTATION_H_
+//-----------------------------------------------------------------------------
@@ -0,0 +1,45 @@
+//-----------------------------------------------------------------------------
+#ifndef _SHADERREFLECTION_H_
+#define _SHADERREFLECTION_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstdint>
+#include <vector>
+#pragma endregion
+#include <vulkan/vulkan.h>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	// Bindings of one descriptor set, sorted by binding. A descriptorCount of 0
+	// is a runtime sized array.
+	struct DescriptorSetReflection
+	{
+		uint32_t Set;
+		std::vector<VkDescriptorSetLayoutBinding> Bindings;
+	};
+	//-----------------------------------------------------------------------------
+	// Interface of one SPIR-V module, or of a whole pipeline once merged.
+	// Only what layouts need is kept: descriptor bindings, push constant
+	// ranges and, for vertex shaders, the input locations and formats.
+	struct ShaderReflection
+	{
+		VkShaderStageFlags Stages = 0;
+		// Sorted by set
+		std::vector<DescriptorSetReflection> Sets;
+		std::vector<VkPushConstantRange> PushConstants;
+		// Location and format only, binding and offset come from the vertex layout
+		std::vector<VkVertexInputAttributeDescription> VertexInputs;
+
+		// Parses the words of a module as returned by FileHelper::ReadFile
+		static ShaderReflection FromSpirv(const std::vector<char>& code);
+		// Unions the stages of a pipeline. Bindings used by several stages get
+		// the stage flags of all of them, push constants end up as one range.
+		static ShaderReflection Merge(const std::vector<ShaderReflection>& stages);
+
+		const DescriptorSetReflection* FindSet(uint32_t set) const;
+		// Highest set index + 1, pipeline layouts need a layout for every set below it
+		const uint32_t GetSetCount() const;
+	};
+}
+#endif // !_SHADERREFLECTION_H_
+//-----------------------------------------------------------------------------
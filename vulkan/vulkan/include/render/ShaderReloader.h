@@ -0,0 +1,67 @@
+//-----------------------------------------------------------------------------
+#ifndef _SHADERRELOADER_H_
+#define _SHADERRELOADER_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#pragma endregion
+#include "core/FileWatcher.h"
+#include "core/JobSystem.h"
+//-----------------------------------------------------------------------------
+namespace render
+{
+	// GLSL source and the SPIR-V file it compiles to, both relative to the
+	// watched directory
+	struct ShaderSourceFile
+	{
+		std::string Source;
+		std::string Output;
+	};
+	//-----------------------------------------------------------------------------
+	struct ReloadedShader
+	{
+		std::string Output;
+		std::vector<char> Code;
+	};
+	//-----------------------------------------------------------------------------
+	// Recompiles shader sources with glslangValidator on the job system as
+	// soon as they are saved. Compiler errors are printed and leave the old
+	// SPIR-V in place; successful builds are queued for the render thread,
+	// which swaps them in between frames.
+	class ShaderReloader
+	{
+	public:
+		ShaderReloader(core::JobSystem& jobs, const std::string& directory, const std::vector<ShaderSourceFile>& files);
+		// Stops watching and waits for the compiles in flight
+		~ShaderReloader();
+		ShaderReloader(const ShaderReloader&) = delete;
+		ShaderReloader& operator=(const ShaderReloader&) = delete;
+
+		// Shaders rebuilt since the last call, the latest build of each
+		std::vector<ReloadedShader> TakeReloaded();
+
+	private:
+		void Compile(const ShaderSourceFile& file);
+		// $VULKAN_SDK / %VK_SDK_PATH% when set, PATH otherwise
+		static const std::string GetCompilerPath();
+
+		core::JobSystem& Jobs;
+		std::string Directory;
+		std::vector<ShaderSourceFile> Files;
+
+		// One compile at a time, two saves in a row would share the output file
+		std::mutex CompileLock;
+		core::JobCounter InFlight;
+
+		std::mutex ReloadedLock;
+		std::vector<ReloadedShader> Reloaded;
+
+		// Last, so it stops queueing compiles before anything else goes away
+		std::unique_ptr<core::FileWatcher> Watcher;
+	};
+}
+#endif // !_SHADERRELOADER_H_
+//-----------------------------------------------------------------------------
@@ -0,0 +1,86 @@
+//-----------------------------------------------------------------------------
+#ifndef _STAGINGRING_H_
+#define _STAGINGRING_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#pragma endregion
+#include <vulkan/vulkan.h>
+#include "render/BufferPool.h"
+//-----------------------------------------------------------------------------
+namespace render
+{
+	struct StagingRingDesc
+	{
+		// The ring holds this much per frame in flight
+		VkDeviceSize BytesPerFrame	= 16ull << 20;
+		uint32_t FramesInFlight		= 2;
+	};
+	//-----------------------------------------------------------------------------
+	struct StagingRingStats
+	{
+		VkDeviceSize Size			= 0;
+		// Reserved and not yet recycled
+		VkDeviceSize UsedBytes		= 0;
+		// Since creation
+		uint64_t Reservations		= 0;
+		uint64_t Failures			= 0;
+	};
+	//-----------------------------------------------------------------------------
+	// One persistently mapped, host coherent upload buffer used as a ring.
+	// Reserve bumps an atomic head, so any thread can write uploads without a
+	// lock or an allocation; the space comes back when BeginFrame sees the
+	// slot of the frame it was reserved in again, its fence having signaled.
+	//
+	// A reservation belongs to the frame current when it is made: the copy
+	// reading it goes into that frame's submission, or into a submission
+	// waited for before the frame ends.
+	class StagingRing
+	{
+	public:
+		typedef std::function<uint32_t(uint32_t, VkMemoryPropertyFlags)> MemoryTypeFinder;
+
+		StagingRing(VkDevice device, MemoryTypeFinder findMemoryType, const StagingRingDesc& desc = StagingRingDesc());
+		// The GPU must be done with every frame that used the ring
+		~StagingRing();
+		StagingRing(const StagingRing&) = delete;
+		StagingRing& operator=(const StagingRing&) = delete;
+
+		// Mapped range of size bytes, false when the ring is full (the caller
+		// falls back to a buffer of its own or tries again next frame).
+		// Never splits a range across the end of the buffer.
+		const bool Reserve(VkDeviceSize size, VkDeviceSize alignment, BufferRange& range);
+
+		// Call once the fence of frameSlot signaled, recycles what that frame
+		// reserved. Render thread only.
+		void BeginFrame(uint32_t frameSlot);
+
+		VkBuffer GetBuffer() const { return Buffer; }
+		const uint32_t GetMemoryTypeIndex() const { return MemoryTypeIndex; }
+		const StagingRingStats GetStats() const;
+
+	private:
+		VkDevice Device;
+		VkDeviceSize Size;
+		VkBuffer Buffer				= VK_NULL_HANDLE;
+		VkDeviceMemory Memory		= VK_NULL_HANDLE;
+		uint32_t MemoryTypeIndex	= 0;
+		uint8_t* Mapped				= nullptr;
+
+		// Positions grow forever, the offset in the buffer is position % Size.
+		// Head is where the next reservation goes; everything before Tail is free.
+		std::atomic<uint64_t> Head;
+		std::atomic<uint64_t> Tail;
+		// Head when each slot's frame ended
+		std::vector<uint64_t> FrameEnds;
+		uint32_t FrameSlot = 0;
+
+		std::atomic<uint64_t> Reservations;
+		std::atomic<uint64_t> Failures;
+	};
+}
+#endif // !_STAGINGRING_H_
+//-----------------------------------------------------------------------------
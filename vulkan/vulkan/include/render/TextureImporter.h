@@ -0,0 +1,39 @@
+//-----------------------------------------------------------------------------
+#ifndef _TEXTUREIMPORTER_H_
+#define _TEXTUREIMPORTER_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <cstdint>
+#include <string>
+#include <vector>
+#pragma endregion
+#include "core/JobSystem.h"
+#include "render/BlockEncoder.h"
+//-----------------------------------------------------------------------------
+namespace render
+{
+	struct RgbaImage
+	{
+		uint32_t Width	= 0;
+		uint32_t Height	= 0;
+		std::vector<uint8_t> Texels;
+	};
+	//-----------------------------------------------------------------------------
+	struct TextureImportStats
+	{
+		uint32_t Levels				= 0;
+		uint64_t SourceBytes		= 0;
+		uint64_t EncodedBytes		= 0;
+		float MipMilliseconds		= 0.0f;
+		float EncodeMilliseconds	= 0.0f;
+	};
+	//-----------------------------------------------------------------------------
+	// Full chain down to 1x1, base included. 2x2 box filter on the stored
+	// values, rows are spread over the job system.
+	std::vector<RgbaImage> BuildMipChain(core::JobSystem& jobs, const RgbaImage& base);
+	// Turns level 0 of a RGBA8 KTX2 into a BC1 / BC7 KTX2 with every level,
+	// the format TextureStreamer streams from. Throws on bad input.
+	const TextureImportStats ImportTexture(core::JobSystem& jobs, const std::string& input, const std::string& output, BlockEncoding encoding);
+}
+#endif // !_TEXTUREIMPORTER_H_
+//-----------------------------------------------------------------------------
@@ -0,0 +1,156 @@
+//-----------------------------------------------------------------------------
+#ifndef _TEXTURESTREAMER_H_
+#define _TEXTURESTREAMER_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#pragma endregion
+#include <vulkan/vulkan.h>
+#include "core/JobSystem.h"
+#include "render/Ktx2File.h"
+#include "render/StagingRing.h"
+//-----------------------------------------------------------------------------
+namespace render
+{
+	typedef uint32_t TextureHandle;
+	const TextureHandle InvalidTextureHandle = ~0u;
+	//-----------------------------------------------------------------------------
+	struct TextureStreamerDesc
+	{
+		// Device memory all streamed textures share; the tails are loaded even past it
+		VkDeviceSize BudgetBytes			= 256ull << 20;
+		// Level data uploaded per Update, a single bigger level still goes through alone
+		VkDeviceSize UploadBytesPerFrame	= 8ull << 20;
+		// Levels up to this size (in texels, either side) are loaded with the
+		// texture and never evicted, so there is always something to sample
+		uint32_t TailSize					= 64;
+		uint32_t FramesInFlight				= 2;
+		// Uploads go through it while it has room, through a buffer of their
+		// own otherwise. Must outlive the streamer.
+		StagingRing* Staging				= nullptr;
+	};
+	//-----------------------------------------------------------------------------
+	struct TextureStreamerStats
+	{
+		uint32_t Textures			= 0;
+		uint32_t PendingLoads		= 0;
+		VkDeviceSize ResidentBytes	= 0;
+		// This frame only
+		VkDeviceSize UploadedBytes	= 0;
+		// Since creation
+		uint64_t LevelsStreamed		= 0;
+		uint64_t LevelsEvicted		= 0;
+	};
+	//-----------------------------------------------------------------------------
+	// Streams the mip chain of block compressed KTX2 textures under a fixed
+	// memory budget. A texture starts with its small tail levels; each frame
+	// it is touched with a finer wanted level, the next finer level is read
+	// on the job system and uploaded once it is there. When the budget runs
+	// out the finest levels of the least recently used textures go first.
+	//
+	// Residency changes rebuild the image with the new level range and copy
+	// the levels both share on the GPU, so the image and view of a texture
+	// change while it streams: fetch them again every frame.
+	class TextureStreamer
+	{
+	public:
+		typedef std::function<uint32_t(uint32_t, VkMemoryPropertyFlags)> MemoryTypeFinder;
+
+		TextureStreamer(VkDevice device, core::JobSystem& jobs, MemoryTypeFinder findMemoryType, const TextureStreamerDesc& desc = TextureStreamerDesc());
+		// The GPU must be done with every frame that sampled a streamed texture
+		~TextureStreamer();
+		TextureStreamer(const TextureStreamer&) = delete;
+		TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+		// Reads the header and queues the tail, throws unless the file is a BCn KTX2
+		TextureHandle Load(const std::string& path);
+		// Marks the texture as used this frame, wanting levels down to wantedLevel
+		void Touch(TextureHandle texture, uint32_t wantedLevel = 0);
+
+		// Call once the fence of frameSlot signaled, frees what that frame retired
+		void BeginFrame(uint32_t frameSlot);
+		// Records uploads, copies and evictions, outside of a render pass and
+		// before anything samples the textures
+		void Update(VkCommandBuffer commandBuffer);
+
+		// VK_NULL_HANDLE until the tail is resident
+		VkImageView GetView(TextureHandle texture) const;
+		// Finest level the view starts at, the level count when nothing is resident
+		const uint32_t GetResidentLevel(TextureHandle texture) const;
+		VkSampler GetSampler() const { return Sampler; }
+		// Evicts down to it at the next Update if it shrank
+		void SetBudget(VkDeviceSize bytes) { Desc.BudgetBytes = bytes; }
+		const VkDeviceSize GetBudget() const { return Desc.BudgetBytes; }
+		const TextureStreamerStats& GetStats() const { return Stats; }
+
+	private:
+		struct Texture
+		{
+			explicit Texture(const std::string& path) : File(path), LoadReady(false) {}
+
+			Ktx2File File;
+			uint32_t TailLevel		= 0;
+			uint32_t ResidentLevel	= 0;
+			uint32_t WantedLevel	= 0;
+			uint64_t LastUsedFrame	= 0;
+			// A level could not be read, the texture stays where it is
+			bool StreamingFailed	= false;
+
+			VkImage Image			= VK_NULL_HANDLE;
+			VkImageView View		= VK_NULL_HANDLE;
+			VkDeviceMemory Memory	= VK_NULL_HANDLE;
+			VkDeviceSize Bytes		= 0;
+
+			// Levels [LoadFirstLevel, ResidentLevel) read by a job, owned by the
+			// job until LoadReady is set
+			bool Loading			= false;
+			uint32_t LoadFirstLevel	= 0;
+			std::vector<std::vector<char>> LoadData;
+			bool LoadFailed			= false;
+			std::atomic<bool> LoadReady;
+		};
+		struct RetiredResource
+		{
+			VkImage Image			= VK_NULL_HANDLE;
+			VkImageView View		= VK_NULL_HANDLE;
+			VkDeviceMemory Memory	= VK_NULL_HANDLE;
+			VkBuffer Buffer			= VK_NULL_HANDLE;
+		};
+
+		void StartLoad(Texture& texture, uint32_t firstLevel);
+		// Moves the texture to a new image holding [firstLevel, levelCount):
+		// upload fills the first levels, the rest is copied from the old image
+		const bool Rebuild(VkCommandBuffer commandBuffer, Texture& texture, uint32_t firstLevel, const std::vector<std::vector<char>>& upload);
+		// Evicts levels of textures last used before newerThan until bytes more
+		// fit in the budget, false if that is not possible
+		const bool MakeRoom(VkCommandBuffer commandBuffer, VkDeviceSize bytes, uint64_t newerThan, const Texture* keep);
+		const bool IsEvictable(const Texture& texture, uint64_t newerThan, const Texture* keep) const;
+		const VkDeviceSize GetLevelBytes(const Texture& texture, uint32_t firstLevel) const;
+		void Retire(const RetiredResource& resource);
+		void Destroy(const RetiredResource& resource) const;
+
+		VkDevice Device;
+		core::JobSystem& Jobs;
+		MemoryTypeFinder FindMemoryType;
+		TextureStreamerDesc Desc;
+		VkSampler Sampler = VK_NULL_HANDLE;
+
+		// Handle is the index, textures never move so jobs can hold on to them
+		std::vector<std::unique_ptr<Texture>> Textures;
+		core::JobCounter InFlight;
+
+		// Starts at 1, LastUsedFrame 0 means never touched
+		uint64_t Frame		= 1;
+		uint32_t FrameSlot	= 0;
+		std::vector<std::vector<RetiredResource>> Retired;
+
+		TextureStreamerStats Stats;
+	};
+}
+#endif // !_TEXTURESTREAMER_H_
+//-----------------------------------------------------------------------------
@@ -0,0 +1,91 @@
+//-----------------------------------------------------------------------------
+#ifndef _TIMELINESYNC_H_
+#define _TIMELINESYNC_H_
+//-----------------------------------------------------------------------------
+#pragma region STL Include
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#pragma endregion
+#include <vulkan/vulkan.h>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	enum class QueueTimeline : uint32_t
+	{
+		Graphics,
+		Compute,
+		Transfer,
+		Count
+	};
+	//-----------------------------------------------------------------------------
+	// One VK_KHR_timeline_semaphore counter per queue instead of a fence and
+	// a semaphore pair per frame. Every submission signals the next value of
+	// its queue, so "frame N is done" is a single number the CPU can wait on
+	// and another queue can wait on at any pipeline stage.
+	//
+	// Values have to be signaled in increasing order: call Advance from the
+	// thread submitting to that queue, right before the submit.
+	class TimelineSync
+	{
+	public:
+		// VK_KHR_timeline_semaphore or Vulkan 1.2, with the timelineSemaphore
+		// feature. needsExtension is set when it is not core.
+		static const bool IsSupported(VkPhysicalDevice physicalDevice, uint32_t instanceApiVersion, bool& needsExtension);
+
+		// The device must have been created with the feature enabled
+		explicit TimelineSync(VkDevice device);
+		// The GPU must be done with every value signaled
+		~TimelineSync();
+		TimelineSync(const TimelineSync&) = delete;
+		TimelineSync& operator=(const TimelineSync&) = delete;
+
+		VkSemaphore GetSemaphore(QueueTimeline queue) const { return Semaphores[static_cast<uint32_t>(queue)]; }
+		// Value the next submission to queue signals
+		const uint64_t Advance(QueueTimeline queue);
+		// Last value handed out by Advance, 0 before the first
+		const uint64_t GetLastValue(QueueTimeline queue) const;
+		// Last value the GPU reached, without blocking
+		const uint64_t GetCompletedValue(QueueTimeline queue) const;
+		// Blocks until queue reached value, false on timeout. 0 never blocks.
+		const bool Wait(QueueTimeline queue, uint64_t value, uint64_t timeout = std::numeric_limits<uint64_t>::max()) const;
+
+	private:
+		VkDevice Device;
+		VkSemaphore Semaphores[static_cast<uint32_t>(QueueTimeline::Count)];
+		std::atomic<uint64_t> Values[static_cast<uint32_t>(QueueTimeline::Count)];
+
+		PFN_vkWaitSemaphoresKHR WaitSemaphores					= nullptr;
+		PFN_vkGetSemaphoreCounterValueKHR GetSemaphoreCounterValue	= nullptr;
+	};
+	//-----------------------------------------------------------------------------
+	// Semaphores of one vkQueueSubmit, binary and timeline mixed: binary ones
+	// (swap chain acquire and present) get a dummy value. Keep it alive until
+	// vkQueueSubmit returns.
+	class TimelineSubmit
+	{
+	public:
+		void WaitBinary(VkSemaphore semaphore, VkPipelineStageFlags stage);
+		void WaitTimeline(const TimelineSync& sync, QueueTimeline queue, uint64_t value, VkPipelineStageFlags stage);
+		// Either kind, for semaphores handed over from elsewhere: value is
+		// ignored for binary ones
+		void WaitSemaphore(VkSemaphore semaphore, uint64_t value, VkPipelineStageFlags stage);
+		void SignalBinary(VkSemaphore semaphore);
+		void SignalTimeline(const TimelineSync& sync, QueueTimeline queue, uint64_t value);
+
+		// Points submitInfo at the semaphores and chains the values in front
+		// of its pNext
+		void Apply(VkSubmitInfo& submitInfo);
+
+	private:
+		std::vector<VkSemaphore> WaitSemaphores;
+		std::vector<uint64_t> WaitValues;
+		std::vector<VkPipelineStageFlags> WaitStages;
+		std::vector<VkSemaphore> SignalSemaphores;
+		std::vector<uint64_t> SignalValues;
+		VkTimelineSemaphoreSubmitInfoKHR Values = {};
+	};
+}
+#endif // !_TIMELINESYNC_H_
+//-----------------------------------------------------------------------------
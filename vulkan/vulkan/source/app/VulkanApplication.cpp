@@ -1,11 +1,33 @@
 //-----------------------------------------------------------------------------
 #include "app/VulkanApplication.h"
+#include "core/TaskGraph.h"
 #include <stdexcept>
 #include <iostream>
+#include <string>
 #include <vector>
 //-----------------------------------------------------------------------------
-VulkanApplication::VulkanApplication()
+// Feature toggles of shader.frag / shader_bindless.frag, one row per
+// layout(constant_id = N) they declare
+static const render::PermutationTable ShaderOptions =
 {
+	{ "VERTEX_COLOR",	0, VK_SHADER_STAGE_FRAGMENT_BIT, 1 },
+	{ "GRAYSCALE",		1, VK_SHADER_STAGE_FRAGMENT_BIT, 0 }
+};
+//-----------------------------------------------------------------------------
+VulkanApplication::VulkanApplication(const RendererSettings& settings) : Settings(settings)
+{
+	FramesInFlight = std::min(std::max(Settings.FramesInFlight, 1u), MaxFramesInFlight);
+	if (FramesInFlight != Settings.FramesInFlight)
+	{
+		std::cout << "Frames in flight: " << Settings.FramesInFlight << " is out of range, using " << FramesInFlight << std::endl;
+	}
+
+	if (!render::PresentPolicy::ParseProfile(Settings.PresentProfile, Presentation.Profile))
+	{
+		std::cout << "Present profile: unknown " << Settings.PresentProfile << ", using " << render::PresentPolicy::GetProfileName(Presentation.Profile) << std::endl;
+	}
+	Presentation.FrameCap = std::max(Settings.FrameCap, 0.0f);
+	Pacer.SetTargetInterval(Presentation.GetFrameIntervalMs());
 }
 //-----------------------------------------------------------------------------
 VulkanApplication::~VulkanApplication()
@@ -14,6 +36,8 @@ VulkanApplication::~VulkanApplication()
 //-----------------------------------------------------------------------------
 void VulkanApplication::Start()
 {
+	StartTime = std::chrono::high_resolution_clock::now();
+	Jobs.Init();
 	InitWindow();
 	InitVulkan();
 }
@@ -22,36 +46,77 @@ void VulkanApplication::Loop()
 {
 	while (!glfwWindowShouldClose(Window))
 	{
-		glfwPollEvents();
+		// Low latency mode polls inside DrawFrame, once nothing is left to block on
+		if (!Settings.LowLatency)
+		{
+			glfwPollEvents();
+		}
 		DrawFrame();
 	}
 
 	vkDeviceWaitIdle(VKDevice);
+
+	core::FramePacerStats pacing = Pacer.GetStats();
+	std::cout << "Frame pacing (" << render::PresentPolicy::GetProfileName(Presentation.Profile) << "): " << pacing.Frames << " frames, "
+		<< pacing.MeanIntervalMs << " ms mean, " << pacing.JitterMs << " ms jitter, "
+		<< pacing.MinIntervalMs << " - " << pacing.MaxIntervalMs << " ms" << std::endl;
 }
 //-----------------------------------------------------------------------------
-void VulkanApplication::Cleanup() const
+void VulkanApplication::Cleanup()
 {
+	// Stops the watcher thread and waits for the compiles it started
+	ShaderReload.reset();
 	CleanupSwapChain();
+	vkFreeCommandBuffers(VKDevice, VKCommandPool, static_cast<uint32_t>(VKCommandBuffers.size()), VKCommandBuffers.data());
+	FrameGraphs.clear();
+	// Loop idled the device, whatever is still queued can go
+	Deletions.reset();
+	// Only left when no frame was drawn
+	Mips.reset();
+	Readback.reset();
+	Pipelines.reset();
+	Streamer.reset();
+	for (size_t i = 0; i < VKTextureImages.size(); i++)
+	{
+		vkDestroyImageView(VKDevice, VKTextureImageViews[i], nullptr);
+		vkDestroyImage(VKDevice, VKTextureImages[i], nullptr);
+		FreeMemory(VKTextureImagesMemory[i]);
+	}
+	vkDestroySampler(VKDevice, VKTextureSampler, nullptr);
 
-	vkDestroyDescriptorSetLayout(VKDevice, VKDescriptorSetLayout, nullptr);
+	Bindless.reset();
+	vkDestroyBuffer(VKDevice, VKMaterialBuffer, nullptr);
+	FreeMemory(VKMaterialBufferMemory);
 
-	for (size_t i = 0; i < VKSwapChainImages.size(); i++)
+	vkDestroyShaderModule(VKDevice, VKBindlessFragShaderModule, nullptr);
+	vkDestroyShaderModule(VKDevice, VKFragShaderModule, nullptr);
+	vkDestroyShaderModule(VKDevice, VKVertShaderModule, nullptr);
+
+	FrameDescriptorSets.clear();
+	FrameDescriptorAllocators.clear();
+	Layouts.reset();
+
+	for (size_t i = 0; i < VKUniformBuffers.size(); i++)
 	{
 		vkDestroyBuffer(VKDevice, VKUniformBuffers[i], nullptr);
-		vkFreeMemory(VKDevice, VKUniformBuffersMemory[i], nullptr);
+		FreeMemory(VKUniformBuffersMemory[i]);
 	}
-	vkDestroyBuffer(VKDevice, VKIndexBuffer, nullptr);
-	vkFreeMemory(VKDevice, VKIndexBufferMemory, nullptr);
+	Geometry.reset();
+	UploadRing.reset();
 
-	vkDestroyBuffer(VKDevice, VKVertexBuffer, nullptr);
-	vkFreeMemory(VKDevice, VKVertexBufferMemory, nullptr);
-
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	for (size_t i = 0; i < FramesInFlight; i++)
 	{
 		vkDestroySemaphore(VKDevice, VKRenderFinishedSemaphores[i], nullptr);
 		vkDestroySemaphore(VKDevice, VKImageAvailableSemaphores[i], nullptr);
-		vkDestroyFence(VKDevice, VKInFlightFences[i], nullptr);
 	}
+	// None with the timeline backend
+	for (auto fence : VKInFlightFences)
+	{
+		vkDestroyFence(VKDevice, fence, nullptr);
+	}
+	// Waits for its queue, and still uses Timelines
+	AsyncCompute.reset();
+	Timelines.reset();
 
 	// GH : VK Cleanup
 	vkDestroyCommandPool(VKDevice, VKCommandPool, nullptr);
@@ -67,12 +132,20 @@ void VulkanApplication::Cleanup() const
 	// GH : GLFW cleanup
 	glfwDestroyWindow(Window); 
 	glfwTerminate();
+
+	Jobs.Shutdown();
 }
 //-----------------------------------------------------------------------------
 void VulkanApplication::InitWindow() 
 {
 	glfwInit();
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+	// Captures read an offscreen target, nothing needs to be shown. The
+	// surface still needs a window system.
+	if (Settings.CaptureFrame > 0)
+	{
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	}
 
 	Window = glfwCreateWindow(WIDTH, HEIGHT, "Vulkan", nullptr, nullptr);
 	glfwSetWindowUserPointer(Window, this);
@@ -81,24 +154,120 @@ void VulkanApplication::InitWindow()
 //-----------------------------------------------------------------------------
 void VulkanApplication::InitVulkan() 
 {
-	CreateInstance();
-	SetupDebugCallback();
-	//CreateVulkanSurface();
-	CreateSurface();
-	PickPhysicalDevice();
-	CreateLogicalDevice();
-	CreateSwapChain();
-	CreateImageViews();
-	CreateRenderPass();
-	CreateDescriptorSetLayout();
-	CreateGraphicsPipeline();
-	CreateFramebuffers();
-	CreateCommandPool();
-	CreateVertexBuffer();
-	CreateIndexBuffer();
-	CreateUniformBuffer();
-	CreateCommandBuffers();
-	CreateSemaphores();
+	// Steps only wait on what they actually consume, so shader I/O and the
+	// geometry uploads overlap with instance / device / swap chain creation
+	std::vector<char> vertShaderCode;
+	std::vector<char> fragShaderCode;
+	std::vector<char> bindlessFragShaderCode;
+
+	// The swap chain task sizes itself from this, GLFW only answers on the
+	// main thread
+	glfwGetFramebufferSize(Window, &FramebufferWidth, &FramebufferHeight);
+
+	core::TaskGraph init(Jobs);
+	auto readShaders	= init.AddTask("ReadShaders", [&]()
+	{
+		vertShaderCode = FileHelper::ReadFile(FileHelper::ContentDir + "/shader/vert.spv");
+		fragShaderCode = FileHelper::ReadFile(FileHelper::ContentDir + "/shader/frag.spv");
+		if (Settings.Bindless)
+		{
+			// Optional, the device task falls back to descriptor sets without it
+			try
+			{
+				bindlessFragShaderCode = FileHelper::ReadFile(FileHelper::ContentDir + "/shader/frag_bindless.spv");
+			}
+			catch (const std::runtime_error& error)
+			{
+				std::cout << "Bindless mode requested but frag_bindless.spv can't be read (" << error.what() << "), using descriptor sets" << std::endl;
+				Settings.Bindless = false;
+			}
+		}
+	});
+	auto instance		= init.AddTask("Instance", [this]()
+	{
+		CreateInstance();
+		SetupDebugCallback();
+		//CreateVulkanSurface();
+		CreateSurface();
+	});
+	auto device			= init.AddTask("Device", [this]()
+	{
+		PickPhysicalDevice();
+		MemoryTypes.reset(new render::MemoryTypeSelector(VKPhysicalDevice));
+		CreateLogicalDevice();
+		Telemetry.reset(new render::MemoryTelemetry(VKPhysicalDevice, *MemoryTypes, MemoryBudgetEnabled));
+
+		render::GeometryPoolDesc geometryDesc;
+		geometryDesc.VertexStride		= sizeof(Vertex);
+		geometryDesc.IndexType			= VK_INDEX_TYPE_UINT16;
+		geometryDesc.MemoryProperties	= MemoryTypes->CanMapDeviceLocal() ? render::MemoryRequest::DirectUpload().Required : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		geometryDesc.FramesInFlight		= FramesInFlight;
+		Geometry.reset(new render::GeometryPool(VKDevice,
+			[this](uint32_t typeFilter, VkMemoryPropertyFlags properties) { return FindMemoryType(typeFilter, properties); }, geometryDesc));
+		render::StagingRingDesc stagingDesc;
+		stagingDesc.FramesInFlight = FramesInFlight;
+		UploadRing.reset(new render::StagingRing(VKDevice,
+			[this](uint32_t typeFilter, VkMemoryPropertyFlags properties) { return FindMemoryType(typeFilter, properties); }, stagingDesc));
+		Layouts.reset(new render::LayoutCache(VKDevice));
+		Pipelines.reset(new render::PipelineManager(VKDevice, Jobs));
+		Deletions.reset(new render::DeletionQueue(VKDevice, FramesInFlight));
+		if (Settings.CaptureFrame > 0)
+		{
+			Readback.reset(new render::FrameReadback(VKDevice, *MemoryTypes, FramesInFlight));
+		}
+	}, { instance, readShaders });
+	auto reflect		= init.AddTask("ReflectShaders", [&]()
+	{
+		VertShaderReflection = render::ShaderReflection::FromSpirv(vertShaderCode);
+		FragShaderReflection = render::ShaderReflection::FromSpirv(BindlessEnabled ? bindlessFragShaderCode : fragShaderCode);
+		PipelineInterface = render::ShaderReflection::Merge({ VertShaderReflection, FragShaderReflection });
+	}, { readShaders, device });
+	auto shaderModules	= init.AddTask("ShaderModules", [&]()
+	{
+		VKVertShaderModule = CreateShaderModule(vertShaderCode);
+		VKFragShaderModule = CreateShaderModule(fragShaderCode);
+		if (BindlessEnabled)
+		{
+			VKBindlessFragShaderModule = CreateShaderModule(bindlessFragShaderCode);
+		}
+	}, { readShaders, device });
+	auto swapChain		= init.AddTask("SwapChain", [this]()
+	{
+		CreateSwapChain();
+		CreateImageViews();
+	}, { device });
+	auto renderPass		= init.AddTask("RenderPass", [this]() { CreateRenderPass(); }, { swapChain });
+	auto setLayout		= init.AddTask("DescriptorSetLayout", [this]() { CreateDescriptorSetLayout(); }, { device, reflect });
+	auto bindless		= init.AddTask("BindlessTable", [this]() { CreateBindlessTable(); }, { device });
+	auto pipeline		= init.AddTask("GraphicsPipeline", [this]() { CreateGraphicsPipeline(); }, { renderPass, setLayout, shaderModules, bindless });
+	auto framebuffers	= init.AddTask("Framebuffers", [this]() { CreateFramebuffers(); }, { renderPass });
+	auto commandPool	= init.AddTask("CommandPool", [this]() { CreateCommandPool(); }, { device });
+	auto geometry		= init.AddTask("Geometry", [this]() { CreateGeometry(); }, { commandPool });
+	init.AddTask("UniformBuffers", [this]() { CreateUniformBuffer(); }, { device });
+	init.AddTask("DescriptorAllocators", [this]() { CreateDescriptorAllocators(); }, { setLayout });
+	auto importTextures	= init.AddTask("ImportTextures", [this]() { ImportTextures(); });
+	init.AddTask("Textures", [this]() { CreateTextures(); }, { device, commandPool, importTextures });
+	init.AddTask("CommandBuffers", [this]() { CreateCommandBuffers(); }, { pipeline, framebuffers, geometry });
+	init.AddTask("SyncObjects", [this]() { CreateSemaphores(); }, { device });
+	init.Run();
+
+	std::cout << "Vulkan init" << std::endl;
+	init.PrintReport(std::cout);
+	Devices->Print(std::cout);
+	render::LayoutCacheStats layoutStats = Layouts->GetStats();
+	std::cout << "Layouts: " << layoutStats.DescriptorSetLayouts << " set, " << layoutStats.PipelineLayouts << " pipeline" << std::endl;
+	std::cout << "Memory: " << (MemoryTypes->IsUnifiedMemory() ? "unified" : MemoryTypes->HasResizableBar() ? "resizable BAR" : "discrete")
+		<< (MemoryTypes->CanMapDeviceLocal() ? ", static buffers skip staging" : "") << std::endl;
+	std::cout << "Sync: " << (TimelineEnabled ? "timeline semaphores" : "fences") << std::endl;
+	std::cout << "Compute: queue family " << AsyncCompute->GetFamily() << (AsyncCompute->IsAsync() ? ", async" : ", shared with graphics") << std::endl;
+
+	if (Settings.ShaderHotReload)
+	{
+		ShaderReload.reset(new render::ShaderReloader(Jobs, FileHelper::ContentDir + "/shader", {
+			{ "shader.vert", "vert.spv" },
+			{ "shader.frag", "frag.spv" },
+			{ "shader_bindless.frag", "frag_bindless.spv" } }));
+	}
 }
 //-----------------------------------------------------------------------------
 const bool VulkanApplication::CheckValidationLayerSupport() const
@@ -146,7 +315,46 @@ const bool VulkanApplication::CheckDeviceExtensionSupport(const VkPhysicalDevice
 	return requiredExtensions.empty();
 }
 //-----------------------------------------------------------------------------
-void VulkanApplication::CreateInstance() const
+const bool VulkanApplication::CheckBindlessSupport(const VkPhysicalDevice& device, VkPhysicalDeviceDescriptorIndexingFeaturesEXT& features, bool& needsExtension)
+{
+	// Same structure for the extension and for 1.2 core
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT supported = {};
+	supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+	if (!render::QueryPromotedFeatures(device, InstanceApiVersion, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME, &supported, needsExtension))
+	{
+		return false;
+	}
+
+	if (!supported.runtimeDescriptorArray ||
+		!supported.descriptorBindingPartiallyBound ||
+		!supported.shaderStorageBufferArrayNonUniformIndexing ||
+		!supported.shaderSampledImageArrayNonUniformIndexing ||
+		!supported.descriptorBindingStorageBufferUpdateAfterBind ||
+		!supported.descriptorBindingSampledImageUpdateAfterBind)
+	{
+		return false;
+	}
+
+	// Only turn on what the bindless table relies on
+	features = {};
+	features.sType										= VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+	features.runtimeDescriptorArray						= VK_TRUE;
+	features.descriptorBindingPartiallyBound			= VK_TRUE;
+	features.shaderStorageBufferArrayNonUniformIndexing	= VK_TRUE;
+	features.shaderSampledImageArrayNonUniformIndexing	= VK_TRUE;
+	features.descriptorBindingStorageBufferUpdateAfterBind	= VK_TRUE;
+	features.descriptorBindingSampledImageUpdateAfterBind	= VK_TRUE;
+
+	BindlessLimits = {};
+	BindlessLimits.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+	VkPhysicalDeviceProperties2 properties2 = {};
+	properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties2.pNext = &BindlessLimits;
+	vkGetPhysicalDeviceProperties2(device, &properties2);
+	return true;
+}
+//-----------------------------------------------------------------------------
+void VulkanApplication::CreateInstance()
 {
 	//  Poll against vulkan if we can validate any of the required layers
 	if (EnableValidationLayers && !CheckValidationLayerSupport())
@@ -161,7 +369,19 @@ void VulkanApplication::CreateInstance() const
 	appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 	appInfo.pEngineName = "No Engine";
 	appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-	appInfo.apiVersion = VK_API_VERSION_1_0;
+	// Newest version both we and the loader know, descriptor indexing needs
+	// at least 1.1 to be queried
+	InstanceApiVersion = VK_API_VERSION_1_0;
+	auto enumerateInstanceVersion = (PFN_vkEnumerateInstanceVersion)vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion");
+	if (enumerateInstanceVersion != nullptr && enumerateInstanceVersion(&InstanceApiVersion) == VK_SUCCESS)
+	{
+#ifdef VK_API_VERSION_1_2
+		InstanceApiVersion = std::min(InstanceApiVersion, static_cast<uint32_t>(VK_API_VERSION_1_2));
+#else
+		InstanceApiVersion = std::min(InstanceApiVersion, static_cast<uint32_t>(VK_API_VERSION_1_1));
+#endif
+	}
+	appInfo.apiVersion = InstanceApiVersion;
 
 	// GH: Create the required info
 	VkInstanceCreateInfo createInfo = {};
@@ -190,49 +410,13 @@ void VulkanApplication::CreateInstance() const
 //-----------------------------------------------------------------------------
 void VulkanApplication::PickPhysicalDevice()
 {
-	VKPhysicalDevice = VK_NULL_HANDLE;
-	uint32_t deviceCount = 0;
-	vkEnumeratePhysicalDevices(VKInstance, &deviceCount, nullptr);
-
-	if (deviceCount == 0)
-	{
-		throw std::runtime_error("failed to find GPUs with Vulkan Support");
-	}
-
-	std::vector<VkPhysicalDevice> devices(deviceCount);
-	vkEnumeratePhysicalDevices(VKInstance, &deviceCount, devices.data());
-
-	for (const auto& device : devices)
-	{
-		if (IsDeviceSuitable(device))
-		{
-			VKPhysicalDevice = device;
-			break;
-		}
-	}
-
-	if (VKPhysicalDevice == VK_NULL_HANDLE)
-	{
-		throw std::runtime_error("failed to find a suitable GPU!");
-	}
-
-	//// Get all the available physical devices and order them by score
-	//std::multimap<int, VkPhysicalDevice> candidates;
-
-	//for (const auto& device : devices)
-	//{
-	//	int32_t score = RateDeviceSuitability(device);
-	//	candidates.insert(std::make_pair(score, device));
-	//}
-
-	//if (candidates.rbegin()->first > 0)
-	//{
-	//	VKPhysicalDevice = candidates.rbegin()->second;
-	//}
-	//else
-	//{
-	//	throw std::runtime_error("failed to find a suitable GPU");
-	//}
+	render::DeviceSelectorDesc desc;
+	desc.Override			= Settings.Device;
+	desc.Benchmark			= Settings.DeviceBenchmark;
+	desc.CachePath			= FileHelper::ContentDir + "/device_cache.txt";
+	desc.InstanceApiVersion	= InstanceApiVersion;
+	Devices.reset(new render::DeviceSelector(VKInstance, desc, [this](VkPhysicalDevice device) { return IsDeviceSuitable(device); }));
+	VKPhysicalDevice = Devices->Select().Device;
 }
 //-----------------------------------------------------------------------------
 void VulkanApplication::ListVulkanExtensions() const
@@ -311,19 +495,7 @@ const VkSurfaceFormatKHR VulkanApplication::ChooseSwapSurfaceFormat(const std::v
 //-----------------------------------------------------------------------------
 const VkPresentModeKHR VulkanApplication::ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes)
 {
-	VkPresentModeKHR bestMode = VK_PRESENT_MODE_FIFO_KHR;
-	for(const auto& availablePresentMode : availablePresentModes)
-	{
-		if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
-		{
-			return availablePresentMode;
-		}
-		else if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR)
-		{
-			bestMode = availablePresentMode;
-		}
-	}
-	return bestMode;
+	return Presentation.ChoosePresentMode(availablePresentModes);
 }
 //-----------------------------------------------------------------------------
 const VkExtent2D VulkanApplication::ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities)
@@ -334,10 +506,7 @@ const VkExtent2D VulkanApplication::ChooseSwapExtent(const VkSurfaceCapabilities
 	}
 	else
 	{
-
-		int width, height;
-		glfwGetFramebufferSize(Window, &width, &height);
-		VkExtent2D actualExtent = { width, height };
+		VkExtent2D actualExtent = { (uint32_t)FramebufferWidth, (uint32_t)FramebufferHeight };
 		actualExtent.width = std::max(capabilities.minImageExtent.width, std::min(capabilities.maxImageExtent.width, actualExtent.width));
 		actualExtent.height = std::max(capabilities.minImageExtent.height, std::min(capabilities.maxImageExtent.height, actualExtent.height));
 
@@ -376,6 +545,19 @@ const QueueFamilyIndices VulkanApplication::FindQueueFamilies(const VkPhysicalDe
 		}
 		i++;
 	}
+
+	// A family without graphics usually maps to the async compute engines,
+	// which run next to the graphics pass instead of interleaving with it
+	indices.ComputeFamily = indices.GraphicsFamily;
+	for (uint32_t family = 0; family < queueFamilyCount; family++)
+	{
+		VkQueueFlags flags = queueFamilies[family].queueFlags;
+		if (queueFamilies[family].queueCount > 0 && (flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT))
+		{
+			indices.ComputeFamily = family;
+			break;
+		}
+	}
 	return indices;
 }
 //-----------------------------------------------------------------------------
@@ -404,7 +586,7 @@ void VulkanApplication::CreateLogicalDevice()
 	QueueFamilyIndices indices = FindQueueFamilies(VKPhysicalDevice);
 
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-	std::set<uint32_t> uniqueQueueFamilies = { indices.GraphicsFamily, indices.PresentFamily };
+	std::set<uint32_t> uniqueQueueFamilies = { indices.GraphicsFamily, indices.PresentFamily, indices.ComputeFamily };
 	float queuePriority = 1.0f;
 
 	for (int queueFamily : uniqueQueueFamilies)
@@ -419,14 +601,59 @@ void VulkanApplication::CreateLogicalDevice()
 
 	
 	VkPhysicalDeviceFeatures deviceFeatures = {};
+	VkPhysicalDeviceFeatures supportedFeatures;
+	vkGetPhysicalDeviceFeatures(VKPhysicalDevice, &supportedFeatures);
+	TextureCompressionBCEnabled = !Settings.Textures.empty() && supportedFeatures.textureCompressionBC == VK_TRUE;
+	deviceFeatures.textureCompressionBC = TextureCompressionBCEnabled ? VK_TRUE : VK_FALSE;
+
 	VkDeviceCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 	createInfo.queueCreateInfoCount		= static_cast<uint32_t>(queueCreateInfos.size());
 	createInfo.pQueueCreateInfos		= queueCreateInfos.data();
 	
 	createInfo.pEnabledFeatures			= &deviceFeatures;
-	createInfo.enabledExtensionCount	= static_cast<uint32_t>(DeviceExtensions.size());
-	createInfo.ppEnabledExtensionNames	= DeviceExtensions.data();
+
+	std::vector<const char*> extensions(DeviceExtensions.begin(), DeviceExtensions.end());
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = {};
+	BindlessEnabled = false;
+	if (Settings.Bindless)
+	{
+		bool needsExtension = false;
+		if (CheckBindlessSupport(VKPhysicalDevice, indexingFeatures, needsExtension))
+		{
+			BindlessEnabled = true;
+			createInfo.pNext = &indexingFeatures;
+			if (needsExtension)
+			{
+				extensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+			}
+		}
+		else
+		{
+			std::cout << "Bindless mode requested but descriptor indexing is not supported, using descriptor sets" << std::endl;
+		}
+	}
+	MemoryBudgetEnabled = render::MemoryTelemetry::IsBudgetSupported(VKPhysicalDevice, InstanceApiVersion);
+	if (MemoryBudgetEnabled)
+	{
+		extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	}
+	VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures = {};
+	bool timelineNeedsExtension = false;
+	TimelineEnabled = Settings.TimelineSemaphores && render::TimelineSync::IsSupported(VKPhysicalDevice, InstanceApiVersion, timelineNeedsExtension);
+	if (TimelineEnabled)
+	{
+		timelineFeatures.sType				= VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+		timelineFeatures.pNext				= const_cast<void*>(createInfo.pNext);
+		timelineFeatures.timelineSemaphore	= VK_TRUE;
+		createInfo.pNext					= &timelineFeatures;
+		if (timelineNeedsExtension)
+		{
+			extensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+		}
+	}
+	createInfo.enabledExtensionCount	= static_cast<uint32_t>(extensions.size());
+	createInfo.ppEnabledExtensionNames	= extensions.data();
 
 	if (EnableValidationLayers)
 	{
@@ -445,6 +672,7 @@ void VulkanApplication::CreateLogicalDevice()
 
 	vkGetDeviceQueue(VKDevice, indices.GraphicsFamily, 0, &VKGraphicsQueue);
 	vkGetDeviceQueue(VKDevice, indices.PresentFamily, 0, &VKPresentQueue);
+	vkGetDeviceQueue(VKDevice, indices.ComputeFamily, 0, &VKComputeQueue);
 
 }
 //-----------------------------------------------------------------------------
@@ -482,7 +710,8 @@ void VulkanApplication::CreateSwapChain()
 	VkPresentModeKHR presentMode				= ChooseSwapPresentMode(swapChainSupport.PresentModes);
 	VkExtent2D extent							= ChooseSwapExtent(swapChainSupport.Capabilities);
 
-	uint32_t imageCount = swapChainSupport.Capabilities.minImageCount + 1;
+	uint32_t imageCount = Settings.SwapChainImages > 0 ? Settings.SwapChainImages : swapChainSupport.Capabilities.minImageCount + 1;
+	imageCount = std::max(imageCount, swapChainSupport.Capabilities.minImageCount);
 	if (swapChainSupport.Capabilities.maxImageCount > 0 && imageCount > swapChainSupport.Capabilities.maxImageCount)
 	{
 		imageCount = swapChainSupport.Capabilities.maxImageCount;
@@ -497,6 +726,12 @@ void VulkanApplication::CreateSwapChain()
 	createInfo.imageExtent		= extent;
 	createInfo.imageArrayLayers = 1;
 	createInfo.imageUsage		= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	// The capture target shares the render pass, so it takes this format
+	if (Readback && !render::FrameReadback::IsFormatSupported(surfaceFormat.format))
+	{
+		std::cout << "Capture: the swap chain format can't be read back, disabled" << std::endl;
+		Readback.reset();
+	}
 
 	QueueFamilyIndices indices = FindQueueFamilies(VKPhysicalDevice);
 	uint32_t queueFamilyIndices[] = { indices.GraphicsFamily, indices.PresentFamily };
@@ -517,7 +752,8 @@ void VulkanApplication::CreateSwapChain()
 	createInfo.presentMode		= presentMode;
 	createInfo.clipped			= VK_TRUE;
 	
-	createInfo.oldSwapchain		= VK_NULL_HANDLE;
+	// Retired but alive until its frames are done, lets the driver hand its resources over
+	createInfo.oldSwapchain		= VKSwapChain;
 
 	if (vkCreateSwapchainKHR(VKDevice, &createInfo, nullptr, &VKSwapChain) != VK_SUCCESS)
 	{
@@ -527,6 +763,8 @@ void VulkanApplication::CreateSwapChain()
 	vkGetSwapchainImagesKHR(VKDevice, VKSwapChain, &imageCount, nullptr);
 	VKSwapChainImages.resize(imageCount);
 	vkGetSwapchainImagesKHR(VKDevice, VKSwapChain, &imageCount, VKSwapChainImages.data());
+	VKImagesInFlight.assign(imageCount, VK_NULL_HANDLE);
+	ImageTimelineValues.assign(imageCount, 0);
 
 	VKSwapChainImageFormat	= surfaceFormat.format;
 	VKSwapChainExtent		= extent;
@@ -563,126 +801,75 @@ void VulkanApplication::CreateImageViews()
 // Loads shaders, does not create a real pipeline
 void VulkanApplication::CreateGraphicsPipeline()
 {
-	auto vertShaderCode = FileHelper::ReadFile(FileHelper::ContentDir + "/shader/vert.spv");
-	auto fragShaderCode = FileHelper::ReadFile(FileHelper::ContentDir + "/shader/frag.spv");
-
-	VkShaderModule vertShaderModule = CreateShaderModule(vertShaderCode);
-	VkShaderModule fragShaderModule = CreateShaderModule(fragShaderCode);
-
-	VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
-	vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-	vertShaderStageInfo.module = vertShaderModule;
-	vertShaderStageInfo.pName = "main";
-
-	VkPipelineShaderStageCreateInfo fragShaderStageInfo = {};
-	fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-	fragShaderStageInfo.module = fragShaderModule;
-	fragShaderStageInfo.pName = "main";
-
-	VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
-
-	VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
-	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	
 	auto bindingDescription = Vertex::GetBindingDescription();
 	auto attributeDescriptions = Vertex::GetAttributeDescriptions();
+	for (const auto& input : PipelineInterface.VertexInputs)
+	{
+		auto attribute = std::find_if(attributeDescriptions.begin(), attributeDescriptions.end(),
+			[&input](const VkVertexInputAttributeDescription& a) { return a.location == input.location; });
+		if (attribute == attributeDescriptions.end() || attribute->format != input.format)
+		{
+			throw std::runtime_error("vertex shader input " + std::to_string(input.location) + " does not match the Vertex layout!");
+		}
+	}
 
-	vertexInputInfo.vertexBindingDescriptionCount = 1;
-	vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-	vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
-
-	VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo = {};
-	inputAssemblyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-	inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-	inputAssemblyInfo.primitiveRestartEnable = VK_FALSE;
-
-	VkViewport viewport = {};
-	viewport.x = 0.0f;
-	viewport.y = 0.0f;
-	viewport.width	= (float)VKSwapChainExtent.width;
-	viewport.height = (float)VKSwapChainExtent.height;
-	viewport.minDepth = 0.0f;
-	viewport.maxDepth = 1.0f;
-
-	VkRect2D scissor = {};
-	scissor.offset = { 0, 0 };
-	scissor.extent = VKSwapChainExtent;
-
-	VkPipelineViewportStateCreateInfo viewportStateInfo = {};
-	viewportStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-	viewportStateInfo.viewportCount = 1;
-	viewportStateInfo.pViewports = &viewport;
-	viewportStateInfo.scissorCount = 1;
-	viewportStateInfo.pScissors = &scissor;
-
-	VkPipelineRasterizationStateCreateInfo rasterizerInfo = {};
-	rasterizerInfo.sType					= VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-	rasterizerInfo.depthClampEnable			= VK_FALSE;
-	rasterizerInfo.rasterizerDiscardEnable	= VK_FALSE;
-	rasterizerInfo.polygonMode				= VK_POLYGON_MODE_FILL;
-	rasterizerInfo.lineWidth				= 1.0f;
-	rasterizerInfo.cullMode					= VK_CULL_MODE_BACK_BIT;
-	rasterizerInfo.frontFace				= VK_FRONT_FACE_CLOCKWISE;
-	rasterizerInfo.depthBiasEnable			= VK_FALSE;
-
-	VkPipelineMultisampleStateCreateInfo multisamplingInfo = {};
-	multisamplingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-	multisamplingInfo.sampleShadingEnable = VK_FALSE;
-	multisamplingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-
-	VkPipelineColorBlendAttachmentState colorBlendAttachmentState = {};
-	colorBlendAttachmentState.colorWriteMask =	  VK_COLOR_COMPONENT_R_BIT 
-												| VK_COLOR_COMPONENT_G_BIT 
-												| VK_COLOR_COMPONENT_B_BIT
-												| VK_COLOR_COMPONENT_A_BIT;
-	colorBlendAttachmentState.blendEnable = VK_FALSE;
-
-	VkPipelineColorBlendStateCreateInfo colorBlendingInfo = {};
-	colorBlendingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-	colorBlendingInfo.logicOpEnable = VK_FALSE;
-	colorBlendingInfo.logicOp = VK_LOGIC_OP_COPY;
-	colorBlendingInfo.attachmentCount = 1;
-	colorBlendingInfo.pAttachments = &colorBlendAttachmentState;
-	colorBlendingInfo.blendConstants[0] = 0.0f;
-	colorBlendingInfo.blendConstants[1] = 0.0f;
-	colorBlendingInfo.blendConstants[2] = 0.0f;
-	colorBlendingInfo.blendConstants[3] = 0.0f;
-
-	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutInfo.setLayoutCount = 1;
-	pipelineLayoutInfo.pSetLayouts = &VKDescriptorSetLayout;
-
-	if (vkCreatePipelineLayout(VKDevice, &pipelineLayoutInfo, nullptr, &VKPipelineLayout) != VK_SUCCESS)
-	{
-		throw std::runtime_error("failed to create pipeline layout");
-	}
-
-	VkGraphicsPipelineCreateInfo pipelineInfo = {};
-	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-	pipelineInfo.stageCount = 2;
-	pipelineInfo.pStages = shaderStages;
-	pipelineInfo.pVertexInputState = &vertexInputInfo;
-	pipelineInfo.pInputAssemblyState = &inputAssemblyInfo;
-	pipelineInfo.pViewportState = &viewportStateInfo;
-	pipelineInfo.pRasterizationState = &rasterizerInfo;
-	pipelineInfo.pMultisampleState = &multisamplingInfo;
-	pipelineInfo.pColorBlendState = &colorBlendingInfo;
-	pipelineInfo.layout = VKPipelineLayout;
-	pipelineInfo.renderPass = VKRenderPass;
-	pipelineInfo.subpass = 0;
-	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
-
-	if (vkCreateGraphicsPipelines(VKDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &VKGraphicsPipeline) != VK_SUCCESS)
-	{
-		throw std::runtime_error("failed to create graphics pipeline!");
-	}
-
-	vkDestroyShaderModule(VKDevice, fragShaderModule, nullptr);
-	vkDestroyShaderModule(VKDevice, vertShaderModule, nullptr);
+	// Set 0 is per frame, set 1 the bindless table when enabled. Sets the
+	// shaders skip still need a (shared, empty) layout.
+	uint32_t setCount = std::max(PipelineInterface.GetSetCount(), BindlessEnabled ? 2u : 1u);
+	std::vector<VkDescriptorSetLayout> setLayouts;
+	for (uint32_t set = 0; set < setCount; set++)
+	{
+		const render::DescriptorSetReflection* reflected = PipelineInterface.FindSet(set);
+		if (set == 1 && BindlessEnabled)
+		{
+			setLayouts.push_back(Bindless->GetLayout());
+		}
+		else
+		{
+			setLayouts.push_back(Layouts->GetDescriptorSetLayout(reflected != nullptr ? reflected->Bindings : std::vector<VkDescriptorSetLayoutBinding>()));
+		}
+	}
+
+	if (PipelineInterface.PushConstants.empty() || PipelineInterface.PushConstants[0].size < sizeof(PushConstantObject))
+	{
+		throw std::runtime_error("shader push constant block does not match PushConstantObject!");
+	}
+	// Same handle after a swap chain recreation, the cache owns it
+	VKPipelineLayout = Layouts->GetPipelineLayout(setLayouts, PipelineInterface.PushConstants);
+
+	render::GraphicsPipelineDesc desc;
+	desc.Stages				= { { VK_SHADER_STAGE_VERTEX_BIT, VKVertShaderModule }, { VK_SHADER_STAGE_FRAGMENT_BIT, VKFragShaderModule } };
+	desc.VertexBindings		= { bindingDescription };
+	desc.VertexAttributes.assign(attributeDescriptions.begin(), attributeDescriptions.end());
+	desc.Topology			= VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	desc.PolygonMode		= VK_POLYGON_MODE_FILL;
+	desc.CullMode			= VK_CULL_MODE_BACK_BIT;
+	// The projection flips Y, which flips the winding as well
+	desc.FrontFace			= VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	desc.Extent				= VKSwapChainExtent;
+	desc.Layout				= VKPipelineLayout;
+	desc.RenderPass			= VKRenderPass;
+	desc.Subpass			= 0;
+
+	// The fallback shares the layout, so swapping between the two needs no
+	// rebinding, and runs the default permutation
+	ShaderOptions.Apply(ShaderOptions.MakePermutation(), desc);
+	FallbackPipeline = Pipelines->RequestNow(desc);
+	FallbackPipelineDesc = desc;
+
+	render::ShaderPermutation permutation = ShaderOptions.MakePermutation();
+	for (const auto& option : Settings.ShaderOptions)
+	{
+		permutation.Set(option.first, option.second);
+	}
+	if (BindlessEnabled)
+	{
+		desc.Stages[1].Module = VKBindlessFragShaderModule;
+	}
+	ShaderOptions.Apply(permutation, desc);
+	// Without bindless or options it is the same desc, so the same (ready) handle
+	MainPipeline = Pipelines->Request(desc, FallbackPipeline);
+	MainPipelineDesc = desc;
 }
 //-----------------------------------------------------------------------------
 void VulkanApplication::CreateRenderPass()
@@ -694,8 +881,9 @@ void VulkanApplication::CreateRenderPass()
 	colorAttachment.storeOp			= VK_ATTACHMENT_STORE_OP_STORE;
 	colorAttachment.stencilLoadOp	= VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	colorAttachment.stencilStoreOp	= VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	colorAttachment.initialLayout	= VK_IMAGE_LAYOUT_UNDEFINED;
-	colorAttachment.finalLayout		= VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	// The render graph moves the backbuffer in and out of attachment layout
+	colorAttachment.initialLayout	= VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	colorAttachment.finalLayout		= VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
 	VkAttachmentReference colorAttachmentRef = {};
 	colorAttachmentRef.attachment	= 0;
@@ -706,23 +894,12 @@ void VulkanApplication::CreateRenderPass()
 	subpass.colorAttachmentCount	= 1;
 	subpass.pColorAttachments		= &colorAttachmentRef;
 
-	VkSubpassDependency dependency = {};
-	dependency.srcSubpass		= VK_SUBPASS_EXTERNAL;
-	dependency.dstSubpass		= 0;
-	dependency.srcStageMask		= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependency.srcAccessMask	= 0;
-	dependency.dstStageMask		= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependency.dstAccessMask	= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-
 	VkRenderPassCreateInfo renderPassInfo = {};
 	renderPassInfo.sType			= VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
 	renderPassInfo.attachmentCount	= 1;
 	renderPassInfo.pAttachments		= &colorAttachment;
 	renderPassInfo.subpassCount		= 1;
 	renderPassInfo.pSubpasses		= &subpass;
-	renderPassInfo.dependencyCount	= 1;
-	renderPassInfo.pDependencies	= &dependency;
 
 	if (vkCreateRenderPass(VKDevice, &renderPassInfo, nullptr, &VKRenderPass) != VK_SUCCESS)
 	{
@@ -778,6 +955,8 @@ void VulkanApplication::CreateCommandPool()
 	VkCommandPoolCreateInfo poolInfo = {};
 	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 	poolInfo.queueFamilyIndex = queueFamilyIndices.GraphicsFamily;
+	// Frame command buffers are re-recorded every frame
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
 	if (vkCreateCommandPool(VKDevice, &poolInfo, nullptr, &VKCommandPool) != VK_SUCCESS)
 	{
@@ -787,7 +966,8 @@ void VulkanApplication::CreateCommandPool()
 //-----------------------------------------------------------------------------
 void VulkanApplication::CreateCommandBuffers()
 {
-	VKCommandBuffers.resize(VKSwapChainFramebuffers.size());
+	// One per frame in flight, recorded in DrawFrame once its fence signaled
+	VKCommandBuffers.resize(FramesInFlight);
 
 	VkCommandBufferAllocateInfo allocInfo = {};
 	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -795,59 +975,284 @@ void VulkanApplication::CreateCommandBuffers()
 	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 	allocInfo.commandBufferCount = (uint32_t)VKCommandBuffers.size();
 
-	if (vkAllocateCommandBuffers(VKDevice, &allocInfo, VKCommandBuffers.data()) != VK_SUCCESS)
 	{
-		throw std::runtime_error("failed to allocate command buffers!");
+		// The texture task uploads through the same pool in parallel
+		std::lock_guard<std::mutex> lock(UploadLock);
+		if (vkAllocateCommandBuffers(VKDevice, &allocInfo, VKCommandBuffers.data()) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to allocate command buffers!");
+		}
 	}
 
+	auto findMemoryType = [this](uint32_t typeFilter, VkMemoryPropertyFlags properties)
+	{
+		return FindMemoryType(typeFilter, properties);
+	};
+
+	FrameGraphs.clear();
 	for (size_t i = 0; i < VKCommandBuffers.size(); i++)
 	{
-		VkCommandBufferBeginInfo beginInfo = {};
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+		FrameGraphs.emplace_back(new render::RenderGraph(VKDevice, findMemoryType));
+	}
+}
+//-----------------------------------------------------------------------------
+void VulkanApplication::BuildDrawQueue()
+{
+	Draws.Reset();
+	FrameTextures.clear();
+
+	// Nothing is drawn until at least the fallback is ready
+	render::PipelineHandle readyPipeline = Pipelines->Resolve(MainPipeline);
+	if (readyPipeline == render::InvalidPipelineHandle)
+	{
+		return;
+	}
+
+	render::PipelineBinding pipeline;
+	pipeline.Pipeline			= Pipelines->GetPipeline(readyPipeline);
+	pipeline.Layout				= VKPipelineLayout;
+	pipeline.PushConstantStages	= PipelineInterface.PushConstants[0].stageFlags;
+	uint32_t pipelineId = Draws.RegisterPipeline(pipeline);
+	render::DescriptorBindings frameBindings;
+	frameBindings.Buffer(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VKUniformBuffers[CurrentFrame], 0, sizeof(UniformFrameBufferObject));
+	uint32_t setId = Draws.RegisterDescriptorSet(FrameDescriptorSets[CurrentFrame]->Get(VKDescriptorSetLayout, frameBindings));
+
+	// One binding for every mesh, draws pick theirs by offset
+	render::MeshBinding geometry;
+	geometry.VertexBuffer	= Geometry->GetVertexBuffer();
+	geometry.IndexBuffer	= Geometry->GetIndexBuffer();
+	geometry.IndexType		= Geometry->GetIndexType();
+	uint32_t meshId = Draws.RegisterMesh(geometry);
+	render::MeshRange quad = Geometry->GetMesh(QuadMesh);
+
+	// Fixed step while capturing, so frame N looks the same on every run
+	// whatever init and the benchmark took
+	float time = Settings.CaptureFrame > 0 ? RecordedFrames / 60.0f :
+		std::chrono::duration<float, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - StartTime).count();
+
+	PushConstantObject constants = {};
+	constants.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	constants.materialIndex = DefaultMaterialIndex;
+	constants.textureIndex = render::InvalidBindlessIndex;
+	if (BindlessEnabled && !SampledTextures.empty())
+	{
+		// One texture at a time, the others age out of the streaming budget
+		constants.textureIndex = ReferenceTexture(static_cast<size_t>(time / 4.0f) % SampledTextures.size());
+	}
 
-		if (vkBeginCommandBuffer(VKCommandBuffers[i], &beginInfo) != VK_SUCCESS)
+	render::DrawItem draw;
+	draw.Key		= render::DrawKey::Make(0, pipelineId, setId, meshId, 0);
+	draw.IndexCount		= quad.IndexCount;
+	draw.FirstIndex		= quad.FirstIndex;
+	draw.VertexOffset	= quad.VertexOffset;
+	Draws.Submit(draw, &constants, sizeof(constants));
+
+	Draws.Sort();
+}
+//-----------------------------------------------------------------------------
+const uint32_t VulkanApplication::ReferenceTexture(size_t index)
+{
+	SampledTexture& texture = SampledTextures[index];
+	VkImageView view = texture.View;
+	VkSampler sampler = VKTextureSampler;
+	if (texture.Streamed != render::InvalidTextureHandle)
+	{
+		Streamer->Touch(texture.Streamed);
+		view = Streamer->GetView(texture.Streamed);
+		sampler = Streamer->GetSampler();
+	}
+	// Not even the tail yet, the view Update creates shows up next frame
+	if (view == VK_NULL_HANDLE)
+	{
+		return render::InvalidBindlessIndex;
+	}
+
+	if (texture.Slots.empty())
+	{
+		texture.Slots.resize(FramesInFlight, render::InvalidBindlessIndex);
+		texture.SlotViews.resize(FramesInFlight, VK_NULL_HANDLE);
+	}
+	// The earlier frame of this slot is complete, nothing pending reads it
+	uint32_t& slot = texture.Slots[CurrentFrame];
+	if (slot == render::InvalidBindlessIndex)
+	{
+		slot = Bindless->RegisterImage(view, sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		texture.SlotViews[CurrentFrame] = view;
+	}
+	FrameTextures.push_back(index);
+	return slot;
+}
+//-----------------------------------------------------------------------------
+void VulkanApplication::UpdateTextureSlots()
+{
+	for (size_t index : FrameTextures)
+	{
+		SampledTexture& texture = SampledTextures[index];
+		if (texture.Streamed == render::InvalidTextureHandle)
 		{
-			throw std::runtime_error("Failed to begin recording command buffer");
+			continue;
 		}
+		// Update rebuilt the image, the old view is retired with this frame
+		VkImageView view = Streamer->GetView(texture.Streamed);
+		if (view != VK_NULL_HANDLE && view != texture.SlotViews[CurrentFrame])
+		{
+			Bindless->UpdateImage(texture.Slots[CurrentFrame], view, Streamer->GetSampler(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			texture.SlotViews[CurrentFrame] = view;
+		}
+	}
+}
+//-----------------------------------------------------------------------------
+void VulkanApplication::RecordCommandBuffer(uint32_t imageIndex)
+{
+	RecordedFrames++;
+	VkCommandBuffer commandBuffer = VKCommandBuffers[CurrentFrame];
+	vkResetCommandBuffer(commandBuffer, 0);
 
-		VkRenderPassBeginInfo renderPassInfo = {};
-		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassInfo.renderPass = VKRenderPass;
-		renderPassInfo.framebuffer = VKSwapChainFramebuffers[i];
-		renderPassInfo.renderArea.offset = { 0, 0 };
-		renderPassInfo.renderArea.extent = VKSwapChainExtent;
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-		VkClearValue clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
-		renderPassInfo.clearValueCount = 1;
-		renderPassInfo.pClearValues = &clearColor;
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to begin recording command buffer");
+	}
 
-		vkCmdBeginRenderPass(VKCommandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	GenerateMips(commandBuffer);
+	// Before BuildDrawQueue resolves the moved meshes
+	Geometry->Defragment(commandBuffer);
 
-			vkCmdBindPipeline(VKCommandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, VKGraphicsPipeline);
-			VkBuffer vertexBuffers[] = { VKVertexBuffer };
-			VkDeviceSize offsets[] = { 0 };
+	// Touches what the draws sample, the Update right after streams for it
+	BuildDrawQueue();
+	if (Streamer)
+	{
+		Streamer->Update(commandBuffer);
+		UpdateTextureSlots();
+	}
 
-			vkCmdBindVertexBuffers(VKCommandBuffers[i], 0, 1, vertexBuffers, offsets);
+	render::RenderGraph& graph = *FrameGraphs[CurrentFrame];
+	graph.Reset();
 
-			vkCmdBindIndexBuffer(VKCommandBuffers[i], VKIndexBuffer, 0, VK_INDEX_TYPE_UINT16);
-			vkCmdDrawIndexed(VKCommandBuffers[i], static_cast<uint32_t>(class_indices.size()), 1, 0, 0, 0);
+	render::ImageDesc backBufferDesc;
+	backBufferDesc.Format = VKSwapChainImageFormat;
+	backBufferDesc.Extent = VKSwapChainExtent;
 
-		vkCmdEndRenderPass(VKCommandBuffers[i]);
+	// Fresh out of vkAcquireNextImageKHR, the submit waits on the semaphore
+	// at color attachment output
+	render::ImageState acquired;
+	acquired.Stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	render::ResourceHandle backBuffer = graph.ImportImage("BackBuffer", VKSwapChainImages[imageIndex], VKSwapChainImageViews[imageIndex], backBufferDesc, acquired);
 
-		if (vkEndCommandBuffer(VKCommandBuffers[i]) != VK_SUCCESS)
+	graph.AddPass("Main",
+		[backBuffer](render::PassBuilder& builder)
 		{
-			throw std::runtime_error("failed to record command buffer!");
-		}
+			builder.Write(backBuffer, render::ResourceUsage::ColorAttachment);
+		},
+		[this, imageIndex](render::PassContext& context)
+		{
+			RecordMainPass(context.CommandBuffer, VKSwapChainFramebuffers[imageIndex]);
+		});
 
+	// Set up below, read by the capture passes when the graph executes
+	render::ResourceHandle captureTarget = render::InvalidResource;
+	if (Readback && !CaptureRecorded && RecordedFrames >= Settings.CaptureFrame)
+	{
+		CaptureRecorded = true;
+		// Drawn a second time into a target of our own, whatever the swap
+		// chain allows and whether the window is shown
+		graph.AddPass("Capture",
+			[this, &captureTarget](render::PassBuilder& builder)
+			{
+				render::ImageDesc desc;
+				desc.Format = VKSwapChainImageFormat;
+				desc.Extent = VKSwapChainExtent;
+				captureTarget = builder.Write(builder.Create("CaptureTarget", desc), render::ResourceUsage::ColorAttachment);
+			},
+			[this, &captureTarget](render::PassContext& context)
+			{
+				VkImageView attachments[] = { context.Graph->GetImageView(captureTarget) };
+
+				VkFramebufferCreateInfo framebufferInfo = {};
+				framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+				framebufferInfo.renderPass = VKRenderPass;
+				framebufferInfo.attachmentCount = 1;
+				framebufferInfo.pAttachments = attachments;
+				framebufferInfo.width = VKSwapChainExtent.width;
+				framebufferInfo.height = VKSwapChainExtent.height;
+				framebufferInfo.layers = 1;
+
+				VkFramebuffer framebuffer;
+				if (vkCreateFramebuffer(VKDevice, &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS)
+				{
+					throw std::runtime_error("Failed to create the capture framebuffer!");
+				}
+				RecordMainPass(context.CommandBuffer, framebuffer);
+				Deletions->RetireFramebuffer(framebuffer);
+			});
+		// Collected when this frame slot comes round again, nothing waits for it
+		graph.AddPass("Readback",
+			[&captureTarget](render::PassBuilder& builder)
+			{
+				builder.Read(captureTarget, render::ResourceUsage::TransferSrc);
+				builder.SetSideEffect();
+			},
+			[this, &captureTarget](render::PassContext& context)
+			{
+				Readback->Record(context.CommandBuffer, static_cast<uint32_t>(CurrentFrame), context.Graph->GetImage(captureTarget), VKSwapChainImageFormat, VKSwapChainExtent, RecordedFrames);
+			});
 	}
+
+	render::ImageState present;
+	present.Layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	present.Stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+	graph.MarkOutput(backBuffer, present);
+
+	graph.Compile();
+	graph.Execute(commandBuffer);
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to record command buffer!");
+	}
+}
+//-----------------------------------------------------------------------------
+void VulkanApplication::RecordMainPass(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer)
+{
+	VkRenderPassBeginInfo renderPassInfo = {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass = VKRenderPass;
+	renderPassInfo.framebuffer = framebuffer;
+	renderPassInfo.renderArea.offset = { 0, 0 };
+	renderPassInfo.renderArea.extent = VKSwapChainExtent;
+
+	VkClearValue clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
+	renderPassInfo.clearValueCount = 1;
+	renderPassInfo.pClearValues = &clearColor;
+
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		if (BindlessEnabled)
+		{
+			// Once per command buffer, draws only push their material index
+			VkDescriptorSet bindlessSet = Bindless->GetSet();
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, VKPipelineLayout, 1, 1, &bindlessSet, 0, nullptr);
+		}
+		Draws.Record(commandBuffer, 0);
+	vkCmdEndRenderPass(commandBuffer);
 }
 //-----------------------------------------------------------------------------
 void VulkanApplication::CreateSemaphores()
 {
-	VKImageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-	VKRenderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-	VKInFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+	VKImageAvailableSemaphores.resize(FramesInFlight);
+	VKRenderFinishedSemaphores.resize(FramesInFlight);
+	if (TimelineEnabled)
+	{
+		// Present still takes binary semaphores, the fences go
+		Timelines.reset(new render::TimelineSync(VKDevice));
+		FrameTimelineValues.assign(FramesInFlight, 0);
+	}
+	else
+	{
+		VKInFlightFences.resize(FramesInFlight);
+	}
 
 	VkSemaphoreCreateInfo semaphoreInfo = {};
 	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -856,39 +1261,125 @@ void VulkanApplication::CreateSemaphores()
 	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	for (size_t i = 0; i < FramesInFlight; i++)
 	{
 		if (vkCreateSemaphore(VKDevice, &semaphoreInfo, nullptr, &VKImageAvailableSemaphores[i]) != VK_SUCCESS ||
 			vkCreateSemaphore(VKDevice, &semaphoreInfo, nullptr, &VKRenderFinishedSemaphores[i]) != VK_SUCCESS || 
-			vkCreateFence(VKDevice, &fenceInfo, nullptr, &VKInFlightFences[i]) != VK_SUCCESS)
+			(!TimelineEnabled && vkCreateFence(VKDevice, &fenceInfo, nullptr, &VKInFlightFences[i]) != VK_SUCCESS))
 		{
 			throw std::runtime_error("Failed to create semaphores!");
 		}
 	}
+
+	QueueFamilyIndices indices = FindQueueFamilies(VKPhysicalDevice);
+	AsyncCompute.reset(new render::ComputeQueue(VKDevice, VKComputeQueue, indices.ComputeFamily, indices.GraphicsFamily,
+		static_cast<uint32_t>(FramesInFlight), Timelines.get()));
 }
 //-----------------------------------------------------------------------------
-void VulkanApplication::CreateVertexBuffer() 
+void VulkanApplication::SubmitAsyncCompute(const std::function<void(VkCommandBuffer)>& record, VkPipelineStageFlags consumerStage)
+{
+	VkCommandBuffer commandBuffer = AsyncCompute->Begin(static_cast<uint32_t>(CurrentFrame));
+	record(commandBuffer);
+	FrameComputeWaits.push_back(AsyncCompute->Submit({}, consumerStage));
+}
+//-----------------------------------------------------------------------------
+void VulkanApplication::GenerateMips(VkCommandBuffer commandBuffer)
+{
+	if (PendingMipChains.empty())
+	{
+		return;
+	}
+
+	uint32_t computeFamily	= AsyncCompute->GetFamily();
+	uint32_t graphicsFamily	= AsyncCompute->GetGraphicsFamily();
+	SubmitAsyncCompute([&](VkCommandBuffer computeBuffer)
+	{
+		for (const auto& request : PendingMipChains)
+		{
+			render::ComputeQueue::AcquireImage(computeBuffer, request.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				graphicsFamily, computeFamily, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+			Mips->Generate(computeBuffer, request.Image, request.Extent, request.LevelCount);
+			render::ComputeQueue::ReleaseImage(computeBuffer, request.Image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				computeFamily, graphicsFamily, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+		}
+	}, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+	// Recorded ahead of the draws, after the wait on the dispatch
+	for (const auto& request : PendingMipChains)
+	{
+		render::ComputeQueue::AcquireImage(commandBuffer, request.Image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			computeFamily, graphicsFamily, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+	}
+	std::cout << "Mips: " << PendingMipChains.size() << " textures generated on " << (AsyncCompute->IsAsync() ? "async compute" : "the graphics queue") << std::endl;
+	PendingMipChains.clear();
+
+	// Nothing else needs it; this frame's submit waits for the dispatch, so
+	// its fence covers the views and sets too
+	render::MipGenerator* mips = Mips.release();
+	Deletions->Retire([mips]() { delete mips; });
+}
+//-----------------------------------------------------------------------------
+void VulkanApplication::CreateGeometry()
 {
 	vertices = Vertex::MakeRGBTriangle();
-	VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-	CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
-	
-	// OLD STYLE C: WHY
-	void* data;
-	vkMapMemory(VKDevice, stagingBufferMemory, 0, bufferSize, 0, &data);
-		memcpy(data, vertices.data(), (size_t)bufferSize);
-	vkUnmapMemory(VKDevice, stagingBufferMemory);
+	class_indices = Indices::MakeSquareIndices();
+	QuadMesh = Geometry->AddMesh(static_cast<uint32_t>(vertices.size()), static_cast<uint32_t>(class_indices.size()));
 
-	CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VKVertexBuffer, VKVertexBufferMemory);
-	CopyBuffer(stagingBuffer, VKVertexBuffer, bufferSize);
+	render::MeshRange quad = Geometry->GetMesh(QuadMesh);
+	WriteBuffer(quad.Vertices, vertices.data());
+	WriteBuffer(quad.Indices, class_indices.data());
+}
+//-----------------------------------------------------------------------------
+void VulkanApplication::WriteBuffer(const render::BufferRange& range, const void* data)
+{
+	VkDeviceSize size = range.Size;
+	if (range.Mapped != nullptr)
+	{
+		memcpy(range.Mapped, data, (size_t)size);
+		return;
+	}
 
-	vkDestroyBuffer(VKDevice, stagingBuffer, nullptr);
-	vkFreeMemory(VKDevice, stagingBufferMemory, nullptr);
+	VkDeviceMemory ownMemory;
+	render::BufferRange staging = StageData(data, size, ownMemory);
+	CopyBuffer(staging.Buffer, range.Buffer, size, range.Offset, staging.Offset);
+	ReleaseStaging(staging, ownMemory);
+}
+//-----------------------------------------------------------------------------
+const render::BufferRange VulkanApplication::StageData(const void* data, const VkDeviceSize size, VkDeviceMemory& ownMemory)
+{
+	render::BufferRange range;
+	ownMemory = VK_NULL_HANDLE;
+	// 16 covers vertex, index and every texel block copy
+	if (!UploadRing->Reserve(size, 16, range))
+	{
+		CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, render::MemoryRequest::Staging(), range.Buffer, ownMemory);
+		vkMapMemory(VKDevice, ownMemory, 0, size, 0, &range.Mapped);
+		range.Size = size;
+	}
+	memcpy(range.Mapped, data, (size_t)size);
+	if (ownMemory != VK_NULL_HANDLE)
+	{
+		vkUnmapMemory(VKDevice, ownMemory);
+	}
+	return range;
+}
+//-----------------------------------------------------------------------------
+void VulkanApplication::ReleaseStaging(const render::BufferRange& range, VkDeviceMemory ownMemory)
+{
+	// Ring space comes back by itself with the frame
+	if (ownMemory != VK_NULL_HANDLE)
+	{
+		vkDestroyBuffer(VKDevice, range.Buffer, nullptr);
+		FreeMemory(ownMemory);
+	}
 }
 //-----------------------------------------------------------------------------
 void VulkanApplication::CreateBuffer(const VkDeviceSize size, const VkBufferUsageFlags usage, const VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+{
+	CreateBuffer(size, usage, render::MemoryRequest::Exactly(properties), buffer, bufferMemory);
+}
+//-----------------------------------------------------------------------------
+void VulkanApplication::CreateBuffer(const VkDeviceSize size, const VkBufferUsageFlags usage, const render::MemoryRequest& memory, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
 {
 	VkBufferCreateInfo bufferInfo	= {};
 	bufferInfo.sType				= VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -907,17 +1398,18 @@ void VulkanApplication::CreateBuffer(const VkDeviceSize size, const VkBufferUsag
 	VkMemoryAllocateInfo allocInfo	= {};
 	allocInfo.sType					= VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
 	allocInfo.allocationSize		= memRequirements.size;
-	allocInfo.memoryTypeIndex		= FindMemoryType(memRequirements.memoryTypeBits, properties);
+	allocInfo.memoryTypeIndex		= MemoryTypes->Select(memRequirements.memoryTypeBits, memory);
 	
 	if (vkAllocateMemory(VKDevice, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
 	{
 		throw std::runtime_error("failed to allocate buffer memory");
 	}
+	Telemetry->OnAllocate(bufferMemory, render::MemoryTelemetry::GetCategory(usage), allocInfo.memoryTypeIndex, allocInfo.allocationSize);
 
 	vkBindBufferMemory(VKDevice, buffer, bufferMemory, 0);
 }
 //-----------------------------------------------------------------------------
-void VulkanApplication::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
+void VulkanApplication::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset, VkDeviceSize srcOffset)
 {
 	VkCommandBufferAllocateInfo allocInfo = {};
 	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -925,6 +1417,10 @@ void VulkanApplication::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDev
 	allocInfo.commandPool = VKCommandPool;
 	allocInfo.commandBufferCount = 1;
 
+	// Uploads run from init tasks in parallel, the pool and the queue are
+	// externally synchronized
+	std::lock_guard<std::mutex> lock(UploadLock);
+
 	VkCommandBuffer commandBuffer;
 	vkAllocateCommandBuffers(VKDevice, &allocInfo, &commandBuffer);
 
@@ -934,6 +1430,8 @@ void VulkanApplication::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDev
 	vkBeginCommandBuffer(commandBuffer, &beginInfo);
 
 	VkBufferCopy copyRegion = {};
+	copyRegion.srcOffset = srcOffset;
+	copyRegion.dstOffset = dstOffset;
 	copyRegion.size = size;
 	vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 	vkEndCommandBuffer(commandBuffer);
@@ -949,101 +1447,567 @@ void VulkanApplication::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDev
 	vkFreeCommandBuffers(VKDevice, VKCommandPool, 1, &commandBuffer);
 }
 //-----------------------------------------------------------------------------
-void VulkanApplication::CreateIndexBuffer()
+void VulkanApplication::CreateDescriptorSetLayout()
 {
-	class_indices = Indices::MakeSquareIndices();
-	VkDeviceSize bufferSize = sizeof(class_indices[0]) * class_indices.size();
+	// Set 0 (per frame) as the shaders declare it
+	const render::DescriptorSetReflection* frameSet = PipelineInterface.FindSet(0);
+	if (frameSet == nullptr)
+	{
+		throw std::runtime_error("shaders do not declare the per frame descriptor set!");
+	}
+
+	VKDescriptorSetLayoutBindings = frameSet->Bindings;
+	VKDescriptorSetLayout = Layouts->GetDescriptorSetLayout(VKDescriptorSetLayoutBindings);
+}
+//-----------------------------------------------------------------------------
+void VulkanApplication::CreateUniformBuffer()
+{
+	// Written by the CPU while older frames are still in flight, hence one per frame
+	VkDeviceSize bufferSize = sizeof(UniformFrameBufferObject);
+	VKUniformBuffers.resize(FramesInFlight);
+	VKUniformBuffersMemory.resize(FramesInFlight);
+
+	for (size_t i = 0; i < VKUniformBuffers.size(); i++)
+	{
+		CreateBuffer(bufferSize, 
+					VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
+					VKUniformBuffers[i], VKUniformBuffersMemory[i]);
+	}
+}
+//-----------------------------------------------------------------------------
+void VulkanApplication::CreateDescriptorAllocators()
+{
+	FrameDescriptorSets.clear();
+	FrameDescriptorAllocators.clear();
+	for (uint32_t i = 0; i < FramesInFlight; i++)
+	{
+		FrameDescriptorAllocators.emplace_back(new render::DescriptorAllocator(VKDevice));
+		FrameDescriptorAllocators.back()->RegisterLayout(VKDescriptorSetLayoutBindings);
+		FrameDescriptorSets.emplace_back(new render::DescriptorSetCache(VKDevice, *FrameDescriptorAllocators.back()));
+	}
+}
+//-----------------------------------------------------------------------------
+void VulkanApplication::CreateBindlessTable()
+{
+	if (!BindlessEnabled)
+	{
+		return;
+	}
+
+	Bindless.reset(new render::BindlessTable(VKDevice, BindlessLimits));
+
+	MaterialBufferObject material = {};
+	material.tint = glm::vec4(1.0f);
+
+	VkDeviceSize bufferSize = sizeof(material);
+	CreateBuffer(bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VKMaterialBuffer, VKMaterialBufferMemory);
 
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-	CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
-	
 	void* data;
-	vkMapMemory(VKDevice, stagingBufferMemory, 0, bufferSize, 0, &data);
-		memcpy(data, class_indices.data(), (size_t)bufferSize);
-	vkUnmapMemory(VKDevice, stagingBufferMemory);
+	vkMapMemory(VKDevice, VKMaterialBufferMemory, 0, bufferSize, 0, &data);
+		memcpy(data, &material, sizeof(material));
+	vkUnmapMemory(VKDevice, VKMaterialBufferMemory);
 
-	CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VKIndexBuffer, VKIndexBufferMemory);
-	CopyBuffer(stagingBuffer, VKIndexBuffer, bufferSize);
+	DefaultMaterialIndex = Bindless->RegisterBuffer(VKMaterialBuffer, 0, bufferSize);
+}
+//-----------------------------------------------------------------------------
+void VulkanApplication::ImportTextures()
+{
+	render::BlockEncoding encoding = Settings.TextureEncoding == "bc1" ? render::BlockEncoding::BC1 : render::BlockEncoding::BC7;
+	for (const auto& import : Settings.TextureImports)
+	{
+		try
+		{
+			render::TextureImportStats stats = render::ImportTexture(Jobs, import.first, import.second, encoding);
+			std::cout << "Texture import: " << import.second << ", " << stats.Levels << " levels, "
+				<< stats.SourceBytes / 1024 << " KB RGBA8 -> " << stats.EncodedBytes / 1024 << " KB with mips, "
+				<< stats.MipMilliseconds << " ms mips, " << stats.EncodeMilliseconds << " ms encode" << std::endl;
+		}
+		catch (const std::runtime_error& error)
+		{
+			std::cout << "Texture import: " << error.what() << std::endl;
+		}
+	}
+}
+//-----------------------------------------------------------------------------
+void VulkanApplication::CreateTextures()
+{
+	for (const auto& path : Settings.Textures)
+	{
+		try
+		{
+			render::Ktx2File file(path);
+			if (!render::Ktx2File::IsBlockCompressed(file.GetFormat()))
+			{
+				if (!Mips)
+				{
+					Mips.reset(new render::MipGenerator(VKDevice, *Layouts, FileHelper::ReadFile(FileHelper::ContentDir + "/shader/mipgen.spv"),
+						[this](uint32_t typeFilter, VkMemoryPropertyFlags properties) { return FindMemoryType(typeFilter, properties); }, Pipelines->GetCache()));
+
+					// Full chains, sampled like the streamed ones
+					VkSamplerCreateInfo samplerInfo = {};
+					samplerInfo.sType			= VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+					samplerInfo.magFilter		= VK_FILTER_LINEAR;
+					samplerInfo.minFilter		= VK_FILTER_LINEAR;
+					samplerInfo.mipmapMode		= VK_SAMPLER_MIPMAP_MODE_LINEAR;
+					samplerInfo.addressModeU	= VK_SAMPLER_ADDRESS_MODE_REPEAT;
+					samplerInfo.addressModeV	= VK_SAMPLER_ADDRESS_MODE_REPEAT;
+					samplerInfo.addressModeW	= VK_SAMPLER_ADDRESS_MODE_REPEAT;
+					samplerInfo.maxLod			= VK_LOD_CLAMP_NONE;
+					samplerInfo.borderColor		= VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+					if (vkCreateSampler(VKDevice, &samplerInfo, nullptr, &VKTextureSampler) != VK_SUCCESS)
+					{
+						throw std::runtime_error("failed to create texture sampler!");
+					}
+				}
+				CreateMipmappedTexture(file);
+				continue;
+			}
 
-	vkDestroyBuffer(VKDevice, stagingBuffer, nullptr);
-	vkFreeMemory(VKDevice, stagingBufferMemory, nullptr);
+			if (!TextureCompressionBCEnabled)
+			{
+				std::cout << "Texture streaming: the device can't sample BCn formats, skipping " << path << std::endl;
+				continue;
+			}
+			if (!Streamer)
+			{
+				render::TextureStreamerDesc desc;
+				desc.BudgetBytes	= static_cast<VkDeviceSize>(Settings.TextureBudgetMB) << 20;
+				desc.FramesInFlight	= FramesInFlight;
+				desc.Staging		= UploadRing.get();
+				Streamer.reset(new render::TextureStreamer(VKDevice, Jobs,
+					[this](uint32_t typeFilter, VkMemoryPropertyFlags properties) { return FindMemoryType(typeFilter, properties); }, desc));
+			}
+			SampledTexture texture;
+			texture.Streamed = Streamer->Load(path);
+			SampledTextures.push_back(texture);
+		}
+		catch (const std::runtime_error& error)
+		{
+			std::cout << "Textures: " << error.what() << std::endl;
+		}
+	}
 }
 //-----------------------------------------------------------------------------
-void VulkanApplication::CreateDescriptorSetLayout()
+void VulkanApplication::CreateMipmappedTexture(const render::Ktx2File& file)
 {
-	VkDescriptorSetLayoutBinding uboLayoutBinding = {};
-	uboLayoutBinding.binding			= 0;
-	uboLayoutBinding.descriptorType		= VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	uboLayoutBinding.descriptorCount	= 1;
-	uboLayoutBinding.stageFlags			= VK_SHADER_STAGE_VERTEX_BIT;
-	uboLayoutBinding.pImmutableSamplers = nullptr;
+	const render::Ktx2Level& base = file.GetLevel(0);
+	if (std::max(base.Width, base.Height) > render::MipGenerator::MaxBaseSize)
+	{
+		throw std::runtime_error(file.GetPath() + " is too big for GPU mip generation!");
+	}
+	uint32_t levelCount = 1;
+	while ((std::max(base.Width, base.Height) >> levelCount) > 0)
+	{
+		levelCount++;
+	}
+
+	std::vector<char> texels = file.ReadLevel(0);
+	VkDeviceMemory stagingMemory;
+	render::BufferRange staging = StageData(texels.data(), texels.size(), stagingMemory);
+
+	// Storage views are UNORM, sRGB files are sampled through a second format
+	bool srgb = file.GetFormat() == VK_FORMAT_R8G8B8A8_SRGB;
+	VkImageCreateInfo imageInfo = {};
+	imageInfo.sType			= VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.flags			= srgb ? VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT : 0;
+	imageInfo.imageType		= VK_IMAGE_TYPE_2D;
+	imageInfo.format		= VK_FORMAT_R8G8B8A8_UNORM;
+	imageInfo.extent		= { base.Width, base.Height, 1 };
+	imageInfo.mipLevels		= levelCount;
+	imageInfo.arrayLayers	= 1;
+	imageInfo.samples		= VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling		= VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage			= VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	imageInfo.sharingMode	= VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout	= VK_IMAGE_LAYOUT_UNDEFINED;
+
+	VkImage image;
+	if (vkCreateImage(VKDevice, &imageInfo, nullptr, &image) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create texture image!");
+	}
 
-	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
-	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-	layoutInfo.bindingCount = 1;
-	layoutInfo.pBindings = &uboLayoutBinding;
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(VKDevice, image, &memRequirements);
+	VkMemoryAllocateInfo allocInfo	= {};
+	allocInfo.sType					= VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize		= memRequirements.size;
+	allocInfo.memoryTypeIndex		= FindMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-	if (vkCreateDescriptorSetLayout(VKDevice, &layoutInfo, nullptr, &VKDescriptorSetLayout) != VK_SUCCESS)
+	VkDeviceMemory imageMemory;
+	if (vkAllocateMemory(VKDevice, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate texture image memory!");
+	}
+	Telemetry->OnAllocate(imageMemory, render::MemoryCategory::Texture, allocInfo.memoryTypeIndex, allocInfo.allocationSize);
+	vkBindImageMemory(VKDevice, image, imageMemory, 0);
+
+	VkImageViewCreateInfo viewInfo = {};
+	viewInfo.sType								= VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image								= image;
+	viewInfo.viewType							= VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format								= file.GetFormat();
+	viewInfo.subresourceRange.aspectMask		= VK_IMAGE_ASPECT_COLOR_BIT;
+	viewInfo.subresourceRange.baseMipLevel		= 0;
+	viewInfo.subresourceRange.levelCount		= levelCount;
+	viewInfo.subresourceRange.baseArrayLayer	= 0;
+	viewInfo.subresourceRange.layerCount		= 1;
+
+	VkImageView view;
+	if (vkCreateImageView(VKDevice, &viewInfo, nullptr, &view) != VK_SUCCESS)
 	{
-		throw std::runtime_error("failed to create descriptor set layout!");
+		throw std::runtime_error("failed to create texture image view!");
 	}
+
+	VkCommandBufferAllocateInfo commandInfo = {};
+	commandInfo.sType				= VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	commandInfo.level				= VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	commandInfo.commandPool			= VKCommandPool;
+	commandInfo.commandBufferCount	= 1;
+
+	std::lock_guard<std::mutex> lock(UploadLock);
+
+	VkCommandBuffer commandBuffer;
+	vkAllocateCommandBuffers(VKDevice, &commandInfo, &commandBuffer);
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+	VkImageMemoryBarrier toTransfer = {};
+	toTransfer.sType							= VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	toTransfer.oldLayout						= VK_IMAGE_LAYOUT_UNDEFINED;
+	toTransfer.newLayout						= VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	toTransfer.srcQueueFamilyIndex				= VK_QUEUE_FAMILY_IGNORED;
+	toTransfer.dstQueueFamilyIndex				= VK_QUEUE_FAMILY_IGNORED;
+	toTransfer.image							= image;
+	toTransfer.subresourceRange.aspectMask		= VK_IMAGE_ASPECT_COLOR_BIT;
+	// Every level, the ownership transfer below covers the whole image
+	toTransfer.subresourceRange.levelCount		= levelCount;
+	toTransfer.subresourceRange.layerCount		= 1;
+	toTransfer.dstAccessMask					= VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+	VkBufferImageCopy region = {};
+	region.bufferOffset					= staging.Offset;
+	region.imageSubresource.aspectMask	= VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.layerCount	= 1;
+	region.imageExtent					= { base.Width, base.Height, 1 };
+	vkCmdCopyBufferToImage(commandBuffer, staging.Buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+	// The mips are generated on the compute queue by the first frame
+	QueueFamilyIndices indices = FindQueueFamilies(VKPhysicalDevice);
+	render::ComputeQueue::ReleaseImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		indices.GraphicsFamily, indices.ComputeFamily, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+	vkEndCommandBuffer(commandBuffer);
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+
+	vkQueueSubmit(VKGraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+	vkQueueWaitIdle(VKGraphicsQueue);
+
+	vkFreeCommandBuffers(VKDevice, VKCommandPool, 1, &commandBuffer);
+	ReleaseStaging(staging, stagingMemory);
+
+	MipChainRequest request;
+	request.Image		= image;
+	request.Extent		= { base.Width, base.Height };
+	request.LevelCount	= levelCount;
+	PendingMipChains.push_back(request);
+
+	VKTextureImages.push_back(image);
+	VKTextureImagesMemory.push_back(imageMemory);
+	VKTextureImageViews.push_back(view);
+	SampledTexture texture;
+	texture.View = view;
+	SampledTextures.push_back(texture);
+	std::cout << "Texture: " << file.GetPath() << ", " << levelCount << " levels, mips queued for the GPU" << std::endl;
 }
 //-----------------------------------------------------------------------------
-void VulkanApplication::CreateUniformBuffer()
+// Descriptor sets and push constants, what the pipeline layout is built from
+static const bool HasSameLayoutInterface(const render::ShaderReflection& a, const render::ShaderReflection& b)
 {
-	VkDeviceSize bufferSize = sizeof(UniformTransformBufferObject);
-	VKUniformBuffers.resize(VKSwapChainImages.size());
-	VKUniformBuffersMemory.resize(VKSwapChainImages.size());
+	if (a.Sets.size() != b.Sets.size() || a.PushConstants.size() != b.PushConstants.size())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < a.Sets.size(); i++)
+	{
+		if (a.Sets[i].Set != b.Sets[i].Set || a.Sets[i].Bindings.size() != b.Sets[i].Bindings.size())
+		{
+			return false;
+		}
+		for (size_t j = 0; j < a.Sets[i].Bindings.size(); j++)
+		{
+			const VkDescriptorSetLayoutBinding& x = a.Sets[i].Bindings[j];
+			const VkDescriptorSetLayoutBinding& y = b.Sets[i].Bindings[j];
+			if (x.binding != y.binding || x.descriptorType != y.descriptorType || x.descriptorCount != y.descriptorCount || x.stageFlags != y.stageFlags)
+			{
+				return false;
+			}
+		}
+	}
+	for (size_t i = 0; i < a.PushConstants.size(); i++)
+	{
+		const VkPushConstantRange& x = a.PushConstants[i];
+		const VkPushConstantRange& y = b.PushConstants[i];
+		if (x.stageFlags != y.stageFlags || x.offset != y.offset || x.size != y.size)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+//-----------------------------------------------------------------------------
+void VulkanApplication::CollectReadback()
+{
+	render::RgbaImage capture;
+	uint64_t frame;
+	if (!Readback->Collect(static_cast<uint32_t>(CurrentFrame), capture, frame))
+	{
+		return;
+	}
 
-	for (size_t i = 0; i < VKSwapChainImages.size(); i++)
+	render::WriteImage(Settings.CapturePath, capture);
+	std::cout << "Capture: frame " << frame << " written to " << Settings.CapturePath << std::endl;
+	if (!Settings.GoldenImage.empty())
 	{
-		CreateBuffer(bufferSize, 
-					VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 
-					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
-					VKUniformBuffers[i], VKUniformBuffersMemory[i]);
+		render::ImageDifference difference = render::CompareImages(capture, render::ReadPpm(Settings.GoldenImage));
+		bool passed = !difference.SizeMismatch && difference.MeanAbsoluteError <= Settings.GoldenTolerance;
+		std::cout << "Golden: " << (passed ? "passed" : "FAILED") << " against " << Settings.GoldenImage;
+		if (difference.SizeMismatch)
+		{
+			std::cout << ", size differs" << std::endl;
+		}
+		else
+		{
+			std::cout << ", mean error " << difference.MeanAbsoluteError << " (tolerance " << Settings.GoldenTolerance << "), max "
+				<< difference.MaxDelta << ", PSNR " << difference.Psnr << " dB, " << difference.DifferingPixels << " pixels off" << std::endl;
+		}
+		ExitCode = passed ? 0 : 1;
 	}
+	glfwSetWindowShouldClose(Window, GLFW_TRUE);
 }
 //-----------------------------------------------------------------------------
-void VulkanApplication::DrawFrame()
+void VulkanApplication::ApplyShaderReloads()
 {
-	vkWaitForFences(VKDevice, 1, &VKInFlightFences[CurrentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
-	uint32_t imageIndex;
+	if (!ShaderReload)
+	{
+		return;
+	}
+
+	std::vector<render::ReloadedShader> reloaded = ShaderReload->TakeReloaded();
+	const std::string mainFragOutput = BindlessEnabled ? "frag_bindless.spv" : "frag.spv";
+	bool mainPipelineChanged = false;
+	bool fallbackChanged = false;
+	for (const auto& shader : reloaded)
+	{
+		bool isVert = shader.Output == "vert.spv";
+		bool isMainFrag = shader.Output == mainFragOutput;
+		bool isFallbackFrag = shader.Output == "frag.spv";
+		if (!isVert && !isMainFrag && !isFallbackFrag)
+		{
+			continue;
+		}
+
+		render::ShaderReflection reflection;
+		try
+		{
+			reflection = render::ShaderReflection::FromSpirv(shader.Code);
+		}
+		catch (const std::runtime_error& error)
+		{
+			std::cerr << "Shader reload: " << shader.Output << " " << error.what() << std::endl;
+			continue;
+		}
+
+		if (isVert || isMainFrag)
+		{
+			// The layouts, descriptor sets and vertex buffers stay as they are,
+			// so the interface has to as well
+			render::ShaderReflection merged = render::ShaderReflection::Merge({ isVert ? reflection : VertShaderReflection, isVert ? FragShaderReflection : reflection });
+			bool sameInputs = merged.VertexInputs.size() == PipelineInterface.VertexInputs.size() && std::equal(merged.VertexInputs.begin(), merged.VertexInputs.end(), PipelineInterface.VertexInputs.begin(),
+				[](const VkVertexInputAttributeDescription& a, const VkVertexInputAttributeDescription& b) { return a.location == b.location && a.format == b.format; });
+			if (!sameInputs || !HasSameLayoutInterface(merged, PipelineInterface))
+			{
+				std::cerr << "Shader reload: " << shader.Output << " changed its resource interface, restart to pick it up" << std::endl;
+				continue;
+			}
+			(isVert ? VertShaderReflection : FragShaderReflection) = reflection;
+			mainPipelineChanged = true;
+		}
+
+		fallbackChanged |= isVert || isFallbackFrag;
+
+		VkShaderModule& module = isVert ? VKVertShaderModule : (isFallbackFrag ? VKFragShaderModule : VKBindlessFragShaderModule);
+		VkShaderModule retired = module;
+		module = CreateShaderModule(shader.Code);
+		// The pipelines built from it are still drawn with, they keep working
+		// without it
+		Pipelines->Forget(retired);
+		VkDevice device = VKDevice;
+		Deletions->Retire([device, retired]() { vkDestroyShaderModule(device, retired, nullptr); });
+	}
+
+	if (fallbackChanged)
+	{
+		// Built right away like at init, the main pipeline falls back to it
+		FallbackPipelineDesc.Stages[0].Module = VKVertShaderModule;
+		FallbackPipelineDesc.Stages[1].Module = VKFragShaderModule;
+		try
+		{
+			FallbackPipeline = Pipelines->RequestNow(FallbackPipelineDesc);
+		}
+		catch (const std::runtime_error& error)
+		{
+			std::cerr << "Shader reload: " << error.what() << " The previous fallback pipeline stays" << std::endl;
+		}
+	}
+	if (!mainPipelineChanged)
+	{
+		return;
+	}
+
+	// Whatever draws now keeps drawing until the new pipeline is compiled,
+	// and stays if it fails
+	render::PipelineHandle current = Pipelines->Resolve(MainPipeline);
+	MainPipelineDesc.Stages[0].Module = VKVertShaderModule;
+	MainPipelineDesc.Stages[1].Module = BindlessEnabled ? VKBindlessFragShaderModule : VKFragShaderModule;
+	MainPipeline = Pipelines->Request(MainPipelineDesc, current != render::InvalidPipelineHandle ? current : FallbackPipeline);
+}
+//-----------------------------------------------------------------------------
+const bool VulkanApplication::AcquireFrame(uint32_t& imageIndex)
+{
+	if (Timelines)
+	{
+		Timelines->Wait(render::QueueTimeline::Graphics, FrameTimelineValues[CurrentFrame]);
+	}
+	else
+	{
+		vkWaitForFences(VKDevice, 1, &VKInFlightFences[CurrentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+	}
+	Deletions->BeginFrame(static_cast<uint32_t>(CurrentFrame));
+	if (Readback)
+	{
+		CollectReadback();
+	}
+
+	// The GPU is done with this slot's earlier frames. Their sets stay
+	// cached, the pools are only recycled once they had to grow.
+	FrameDescriptorSets[CurrentFrame]->BeginFrame();
+
+	ApplyShaderReloads();
+
+	if (Streamer)
+	{
+		Streamer->BeginFrame(static_cast<uint32_t>(CurrentFrame));
+	}
+	Geometry->BeginFrame(static_cast<uint32_t>(CurrentFrame));
+	UploadRing->BeginFrame(static_cast<uint32_t>(CurrentFrame));
+	UpdateMemoryTelemetry();
+
 	VkResult result = vkAcquireNextImageKHR(VKDevice, VKSwapChain, std::numeric_limits<std::uint64_t>::max(), VKImageAvailableSemaphores[CurrentFrame], VK_NULL_HANDLE, &imageIndex);
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR)
 	{
 		RecreateSwapChain();	
-		return;
+		return false;
 	}
 	else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
 	{
 		throw std::runtime_error("Failed to acquire swap chain image!");
 	}
 
-	
+	// With more frames in flight than images, an earlier frame may still be rendering to this one
+	if (Timelines)
+	{
+		// Set at submit, the value is not taken yet
+		Timelines->Wait(render::QueueTimeline::Graphics, ImageTimelineValues[imageIndex]);
+		return true;
+	}
+	if (VKImagesInFlight[imageIndex] != VK_NULL_HANDLE)
+	{
+		vkWaitForFences(VKDevice, 1, &VKImagesInFlight[imageIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+	}
+	VKImagesInFlight[imageIndex] = VKInFlightFences[CurrentFrame];
+	return true;
+}
+//-----------------------------------------------------------------------------
+void VulkanApplication::DrawFrame()
+{
+	// Before anything else, the sleep must not age the input or the image
+	Pacer.Wait();
+
+	uint32_t imageIndex;
+	if (!AcquireFrame(imageIndex))
+	{
+		return;
+	}
+
+	if (Settings.LowLatency)
+	{
+		// Everything that could block is behind us, the input is as fresh as it gets
+		glfwPollEvents();
+	}
+
+	UpdateUniformBuffer(static_cast<uint32_t>(CurrentFrame));
+	RecordCommandBuffer(imageIndex);
+
 	VkSubmitInfo submitInfo = {};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-	VkSemaphore waitSemaphores[] = { VKImageAvailableSemaphores[CurrentFrame] };
-
-	VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-	submitInfo.waitSemaphoreCount	= 1;
-	submitInfo.pWaitSemaphores		= waitSemaphores;
-	submitInfo.pWaitDstStageMask	= waitStages;
+	std::vector<VkSemaphore> waitSemaphores = { VKImageAvailableSemaphores[CurrentFrame] };
+	std::vector<VkPipelineStageFlags> waitStages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+	for (const auto& wait : FrameComputeWaits)
+	{
+		waitSemaphores.push_back(wait.Semaphore);
+		waitStages.push_back(wait.Stage);
+	}
+	submitInfo.waitSemaphoreCount	= static_cast<uint32_t>(waitSemaphores.size());
+	submitInfo.pWaitSemaphores		= waitSemaphores.data();
+	submitInfo.pWaitDstStageMask	= waitStages.data();
 	submitInfo.commandBufferCount	= 1;
-	submitInfo.pCommandBuffers		= &VKCommandBuffers[imageIndex];
+	submitInfo.pCommandBuffers		= &VKCommandBuffers[CurrentFrame];
 
 	VkSemaphore signalSemaphores[]	= { VKRenderFinishedSemaphores[CurrentFrame] };
 	submitInfo.signalSemaphoreCount = 1;
 	submitInfo.pSignalSemaphores	= signalSemaphores;
 
-	vkResetFences(VKDevice, 1, &VKInFlightFences[CurrentFrame]);
-	result = vkQueueSubmit(VKGraphicsQueue, 1, &submitInfo, VKInFlightFences[CurrentFrame]);
+	VkResult result;
+	if (Timelines)
+	{
+		// The binary pair stays for the swap chain, the graphics counter
+		// takes the fence's place
+		uint64_t value = Timelines->Advance(render::QueueTimeline::Graphics);
+		render::TimelineSubmit timelineSubmit;
+		timelineSubmit.WaitBinary(VKImageAvailableSemaphores[CurrentFrame], VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		for (const auto& wait : FrameComputeWaits)
+		{
+			timelineSubmit.WaitSemaphore(wait.Semaphore, wait.Value, wait.Stage);
+		}
+		timelineSubmit.SignalBinary(VKRenderFinishedSemaphores[CurrentFrame]);
+		timelineSubmit.SignalTimeline(*Timelines, render::QueueTimeline::Graphics, value);
+		timelineSubmit.Apply(submitInfo);
+		result = vkQueueSubmit(VKGraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+		FrameTimelineValues[CurrentFrame]	= value;
+		ImageTimelineValues[imageIndex]		= value;
+	}
+	else
+	{
+		vkResetFences(VKDevice, 1, &VKInFlightFences[CurrentFrame]);
+		result = vkQueueSubmit(VKGraphicsQueue, 1, &submitInfo, VKInFlightFences[CurrentFrame]);
+	}
 	if (result != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to submit draw command buffer!");
 	}
+	FrameComputeWaits.clear();
+	Deletions->EndFrame(static_cast<uint32_t>(CurrentFrame));
 
 	VkPresentInfoKHR presentInfo	= {};
 	presentInfo.sType				= VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -1065,67 +2029,73 @@ void VulkanApplication::DrawFrame()
 	{
 		throw std::runtime_error("Failed to acquire swap chain image!");
 	}
-	CurrentFrame = (CurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+	else
+	{
+		Pacer.MarkPresent();
+		if (!FirstFramePresented)
+		{
+			FirstFramePresented = true;
+			float timeToFirstFrame = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - StartTime).count();
+			std::cout << "Time to first frame: " << timeToFirstFrame << " ms" << std::endl;
+		}
+	}
+	CurrentFrame = (CurrentFrame + 1) % FramesInFlight;
 }
 //-----------------------------------------------------------------------------
-void VulkanApplication::UpdateUniformBuffer(uint32_t currentImage)
+void VulkanApplication::UpdateUniformBuffer(uint32_t currentFrame)
 {
-	static auto startTime = std::chrono::high_resolution_clock::now();
-
-	auto currentTime = std::chrono::high_resolution_clock::now();
-	float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
-
-	UniformTransformBufferObject ubo = {};
-	ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	// Only what is shared by the whole frame, per-draw transforms are push constants
+	UniformFrameBufferObject ubo = {};
 	ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 	ubo.proj = glm::perspective(glm::radians(45.0f), VKSwapChainExtent.width / (float)VKSwapChainExtent.height, 0.1f, 10.0f);
 	// GH: OGL inversion clip coordinates.
 	ubo.proj[1][1] *= -1;
 
 	void* data;
-	vkMapMemory(VKDevice, VKUniformBuffersMemory[currentImage], 0, sizeof(ubo), 0, &data);
+	vkMapMemory(VKDevice, VKUniformBuffersMemory[currentFrame], 0, sizeof(ubo), 0, &data);
 	memcpy(data, &ubo, sizeof(ubo));
-	vkUnmapMemory(VKDevice, VKUniformBuffersMemory[currentImage]);
+	vkUnmapMemory(VKDevice, VKUniformBuffersMemory[currentFrame]);
 }
 //-----------------------------------------------------------------------------
 void VulkanApplication::RecreateSwapChain()
 {
-	int width = 0, height = 0;
-	while (width == 0 || height == 0)
+	FramebufferWidth = 0;
+	FramebufferHeight = 0;
+	while (FramebufferWidth == 0 || FramebufferHeight == 0)
 	{
-		glfwGetFramebufferSize(Window, &width, &height);
+		glfwGetFramebufferSize(Window, &FramebufferWidth, &FramebufferHeight);
 		glfwWaitEvents();
 	}
 
-	vkDeviceWaitIdle(VKDevice);
+	// No idle: the old objects are retired and go once the frames in flight
+	// are done. Command buffers and frame graphs are per frame slot, not per
+	// swap chain, and stay.
 	CleanupSwapChain();
 	CreateSwapChain();
 	CreateImageViews();
 	CreateRenderPass();
 	CreateGraphicsPipeline();
 	CreateFramebuffers();
-	CreateCommandBuffers();
 }
 //-----------------------------------------------------------------------------
-void VulkanApplication::CleanupSwapChain() const
+void VulkanApplication::CleanupSwapChain()
 {
 	for (auto frameBuffer : VKSwapChainFramebuffers)
 	{
-		vkDestroyFramebuffer(VKDevice, frameBuffer, nullptr);
+		Deletions->RetireFramebuffer(frameBuffer);
 	}
 
-	vkFreeCommandBuffers(VKDevice, VKCommandPool, static_cast<uint32_t>(VKCommandBuffers.size()), VKCommandBuffers.data());
-
-	vkDestroyPipeline(VKDevice, VKGraphicsPipeline, nullptr);
-	vkDestroyPipelineLayout(VKDevice, VKPipelineLayout, nullptr);
-	vkDestroyRenderPass(VKDevice, VKRenderPass, nullptr);
+	render::DeletionQueue& deletions = *Deletions;
+	Pipelines->Clear([&deletions](VkPipeline pipeline) { deletions.RetirePipeline(pipeline); });
+	Deletions->RetireRenderPass(VKRenderPass);
 
 	for(auto image : VKSwapChainImageViews)
 	{
-		vkDestroyImageView(VKDevice, image, nullptr);
+		Deletions->RetireImageView(image);
 	}
 
-	vkDestroySwapchainKHR(VKDevice, VKSwapChain, nullptr);
+	// The handle stays, CreateSwapChain passes it as the old swap chain
+	Deletions->RetireSwapchain(VKSwapChain);
 }
 //-----------------------------------------------------------------------------
 void VulkanApplication::SetupDebugCallback() const
@@ -1148,38 +2118,47 @@ void VulkanApplication::SetupDebugCallback() const
 	}
 }
 //-----------------------------------------------------------------------------
-// TO-DO: arbitrary scoring for now. Need to add more information and a better rating system
-const int32_t VulkanApplication::RateDeviceSuitability(const VkPhysicalDevice& device) const
+void VulkanApplication::FreeMemory(VkDeviceMemory memory) const
+{
+	Telemetry->OnFree(memory);
+	vkFreeMemory(VKDevice, memory, nullptr);
+}
+//-----------------------------------------------------------------------------
+void VulkanApplication::UpdateMemoryTelemetry()
 {
-	int32_t score = 0;
-	// Rate higher the discrete devices type
-	if (VKDeviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+	uint32_t heapIndex = Telemetry->GetDeviceLocalHeap();
+	render::GeometryPoolStats geometryStats = Geometry->GetStats();
+	Telemetry->SetExternal(render::MemoryCategory::Vertex, heapIndex, geometryStats.Vertices.BlockBytes);
+	Telemetry->SetExternal(render::MemoryCategory::Index, heapIndex, geometryStats.Indices.BlockBytes);
+	Telemetry->SetExternal(render::MemoryCategory::Staging, MemoryTypes->GetHeapIndex(UploadRing->GetMemoryTypeIndex()), UploadRing->GetStats().Size);
+	if (Streamer)
 	{
-		score += 1000;
+		Telemetry->SetExternal(render::MemoryCategory::Texture, heapIndex, Streamer->GetStats().ResidentBytes);
+	}
+	Telemetry->Update();
+
+	if (Streamer)
+	{
+		// Grow only into what the driver still grants the process, and give
+		// back what others pushed us over by, before it starts paging
+		const render::MemoryHeapReport& heap = Telemetry->GetHeaps()[heapIndex];
+		VkDeviceSize resident	= Streamer->GetStats().ResidentBytes;
+		VkDeviceSize overshoot	= heap.Usage > heap.Budget ? heap.Usage - heap.Budget : 0;
+		VkDeviceSize allowed	= resident + Telemetry->GetHeadroom(heapIndex);
+		allowed					= allowed > overshoot ? allowed - overshoot : 0;
+		Streamer->SetBudget(std::min(static_cast<VkDeviceSize>(Settings.TextureBudgetMB) << 20, allowed));
 	}
-	
-	score += VKDeviceProperties.limits.maxImageDimension2D;
 
-	if (VKDeviceFeatures.geometryShader == false)
+	FrameNumber++;
+	if (Settings.MemoryReportInterval > 0 && FrameNumber % Settings.MemoryReportInterval == 0)
 	{
-		return 0;
+		std::cout << "Memory, frame " << FrameNumber << std::endl;
+		Telemetry->PrintReport(std::cout);
 	}
-	return score;
 }
 //-----------------------------------------------------------------------------
 const uint32_t VulkanApplication::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
 {
-	VkPhysicalDeviceMemoryProperties memProperties;
-	vkGetPhysicalDeviceMemoryProperties(VKPhysicalDevice, &memProperties);
-
-	for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
-	{
-		if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
-		{
-			return i;
-		}
-	}
-
-	throw std::runtime_error("Failed to find suitable memory type");
+	return MemoryTypes->Select(typeFilter, render::MemoryRequest::Exactly(properties));
 }
 //-----------------------------------------------------------------------------
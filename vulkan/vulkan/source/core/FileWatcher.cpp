@@ -0,0 +1,133 @@
+//-----------------------------------------------------------------------------
+#include "core/FileWatcher.h"
+#include <algorithm>
+#include <stdexcept>
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#else
+#include <sys/stat.h>
+#endif
+//-----------------------------------------------------------------------------
+namespace core
+{
+	// How long a file has to stay untouched before it is reported
+	static const std::chrono::milliseconds SettleTime(100);
+#if !defined(__linux__)
+	//-----------------------------------------------------------------------------
+	static time_t GetModifiedTime(const std::string& path)
+	{
+		struct stat info;
+		return stat(path.c_str(), &info) == 0 ? info.st_mtime : 0;
+	}
+#endif
+	//-----------------------------------------------------------------------------
+	FileWatcher::FileWatcher(const std::string& directory, const std::vector<std::string>& files, FileChangedFunction onChanged)
+		: Directory(directory)
+		, Files(files)
+		, OnChanged(onChanged)
+		, Running(true)
+	{
+#if defined(__linux__)
+		NotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (NotifyFd < 0)
+		{
+			throw std::runtime_error("failed to initialize inotify!");
+		}
+		// Saving through a temporary and a rename shows up as IN_MOVED_TO
+		if (inotify_add_watch(NotifyFd, Directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+		{
+			close(NotifyFd);
+			throw std::runtime_error("failed to watch " + Directory + "!");
+		}
+#else
+		for (const auto& file : Files)
+		{
+			ModifiedTimes[file] = GetModifiedTime(Directory + "/" + file);
+		}
+#endif
+		Thread = std::thread(&FileWatcher::WatchLoop, this);
+	}
+	//-----------------------------------------------------------------------------
+	FileWatcher::~FileWatcher()
+	{
+		Running = false;
+		Thread.join();
+#if defined(__linux__)
+		close(NotifyFd);
+#endif
+	}
+	//-----------------------------------------------------------------------------
+	void FileWatcher::WatchLoop()
+	{
+		while (Running.load(std::memory_order_acquire))
+		{
+			// Short timeout, it bounds both the shutdown latency and the settle check
+			CollectChanges(50);
+
+			Clock::time_point now = Clock::now();
+			for (auto it = PendingChanges.begin(); it != PendingChanges.end();)
+			{
+				if (now - it->second < SettleTime)
+				{
+					++it;
+					continue;
+				}
+				OnChanged(it->first);
+				it = PendingChanges.erase(it);
+			}
+		}
+	}
+	//-----------------------------------------------------------------------------
+	void FileWatcher::MarkChanged(const std::string& file)
+	{
+		if (std::find(Files.begin(), Files.end(), file) != Files.end())
+		{
+			PendingChanges[file] = Clock::now();
+		}
+	}
+	//-----------------------------------------------------------------------------
+#if defined(__linux__)
+	void FileWatcher::CollectChanges(int timeoutMs)
+	{
+		pollfd descriptor	= {};
+		descriptor.fd		= NotifyFd;
+		descriptor.events	= POLLIN;
+		if (poll(&descriptor, 1, timeoutMs) <= 0)
+		{
+			return;
+		}
+
+		alignas(inotify_event) char buffer[4096];
+		ssize_t length;
+		while ((length = read(NotifyFd, buffer, sizeof(buffer))) > 0)
+		{
+			for (char* cursor = buffer; cursor < buffer + length;)
+			{
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(cursor);
+				if (event->len > 0)
+				{
+					MarkChanged(event->name);
+				}
+				cursor += sizeof(inotify_event) + event->len;
+			}
+		}
+	}
+#else
+	void FileWatcher::CollectChanges(int timeoutMs)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+		for (auto& file : ModifiedTimes)
+		{
+			time_t modified = GetModifiedTime(Directory + "/" + file.first);
+			if (modified != file.second)
+			{
+				file.second = modified;
+				MarkChanged(file.first);
+			}
+		}
+	}
+#endif
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,135 @@
+//-----------------------------------------------------------------------------
+#include "core/FramePacer.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <mmsystem.h>
+#endif
+//-----------------------------------------------------------------------------
+namespace core
+{
+	const double FramePacer::MaxSpinMs = 2.0;
+	// Weight of the newest sleep in the estimate
+	static const double SleepEstimateWeight = 1.0 / 32.0;
+	//-----------------------------------------------------------------------------
+	static double ToMs(FramePacer::Clock::duration duration)
+	{
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+	//-----------------------------------------------------------------------------
+	FramePacer::FramePacer(double targetIntervalMs)
+		: TargetIntervalMs(std::max(targetIntervalMs, 0.0))
+	{
+#if defined(_WIN32)
+		timeBeginPeriod(1);
+#endif
+	}
+	//-----------------------------------------------------------------------------
+	FramePacer::~FramePacer()
+	{
+#if defined(_WIN32)
+		timeEndPeriod(1);
+#endif
+	}
+	//-----------------------------------------------------------------------------
+	void FramePacer::SetTargetInterval(double targetIntervalMs)
+	{
+		TargetIntervalMs = std::max(targetIntervalMs, 0.0);
+		Scheduled = false;
+	}
+	//-----------------------------------------------------------------------------
+	void FramePacer::Wait()
+	{
+		if (TargetIntervalMs <= 0.0)
+		{
+			return;
+		}
+
+		Clock::time_point now = Clock::now();
+		Clock::duration interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(TargetIntervalMs));
+		if (!Scheduled)
+		{
+			Deadline = now;
+			Scheduled = true;
+		}
+		Deadline += interval;
+		// More than a whole interval behind, start over from here
+		if (Deadline + interval < now)
+		{
+			Deadline = now;
+		}
+		SleepUntil(Deadline);
+	}
+	//-----------------------------------------------------------------------------
+	void FramePacer::SleepUntil(Clock::time_point deadline)
+	{
+		Clock::time_point start = Clock::now();
+		Clock::time_point now = start;
+
+		// Sleep while the deadline is further than a sleep may take, and learn
+		// how long a sleep takes on this machine (the timer resolution varies).
+		// A coarse timer costs an overshoot, never more than MaxSpinMs of spin.
+		while (ToMs(deadline - now) > SleepEstimateMs)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			Clock::time_point woke = Clock::now();
+			double observed = ToMs(woke - now);
+			now = woke;
+
+			double delta = observed - SleepMeanMs;
+			SleepMeanMs += SleepEstimateWeight * delta;
+			SleepVariance = (1.0 - SleepEstimateWeight) * (SleepVariance + SleepEstimateWeight * delta * delta);
+			SleepEstimateMs = std::min(SleepMeanMs + std::sqrt(SleepVariance), MaxSpinMs);
+		}
+		Stats.SleptMs += ToMs(now - start);
+
+		// The rest is shorter than the timer can be trusted with
+		Clock::time_point spinStart = now;
+		while (now < deadline)
+		{
+			std::this_thread::yield();
+			now = Clock::now();
+		}
+		Stats.SpunMs += ToMs(now - spinStart);
+	}
+	//-----------------------------------------------------------------------------
+	void FramePacer::MarkPresent()
+	{
+		Clock::time_point now = Clock::now();
+		if (Presented)
+		{
+			double interval = ToMs(now - LastPresent);
+			Stats.Frames++;
+			double delta = interval - IntervalMean;
+			IntervalMean += delta / Stats.Frames;
+			IntervalM2 += delta * (interval - IntervalMean);
+
+			Stats.MinIntervalMs = Stats.Frames == 1 ? interval : std::min(Stats.MinIntervalMs, interval);
+			Stats.MaxIntervalMs = std::max(Stats.MaxIntervalMs, interval);
+		}
+		LastPresent = now;
+		Presented = true;
+	}
+	//-----------------------------------------------------------------------------
+	const FramePacerStats FramePacer::GetStats() const
+	{
+		FramePacerStats stats	= Stats;
+		stats.MeanIntervalMs	= IntervalMean;
+		stats.JitterMs			= Stats.Frames > 1 ? std::sqrt(IntervalM2 / (Stats.Frames - 1)) : 0.0;
+		return stats;
+	}
+	//-----------------------------------------------------------------------------
+	void FramePacer::ResetStats()
+	{
+		Stats = FramePacerStats();
+		IntervalMean = 0.0;
+		IntervalM2 = 0.0;
+		// The next present starts a new interval
+		Presented = false;
+	}
+}
+//-----------------------------------------------------------------------------
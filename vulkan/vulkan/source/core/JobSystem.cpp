@@ -0,0 +1,354 @@
+//-----------------------------------------------------------------------------
+#include "core/JobSystem.h"
+#include <algorithm>
+#include <stdexcept>
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+//-----------------------------------------------------------------------------
+namespace core
+{
+	// Which worker the current thread is, and of which system
+	static thread_local int32_t CurrentWorkerIndex = -1;
+	static thread_local const JobSystem* CurrentOwner = nullptr;
+	//-----------------------------------------------------------------------------
+	JobSystem::JobSystem() : Running(false), QueuedJobs(0)
+	{
+	}
+	//-----------------------------------------------------------------------------
+	JobSystem::~JobSystem()
+	{
+		Shutdown();
+	}
+	//-----------------------------------------------------------------------------
+	void JobSystem::Init(const JobSystemConfig& config)
+	{
+		if (Running)
+		{
+			throw std::runtime_error("job system already running!");
+		}
+		Config = config;
+
+		uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+		uint32_t reservedThreads = 1 + (Config.RenderThreadCore >= 0 ? 1 : 0);
+		uint32_t workerCount = Config.WorkerCount;
+		if (workerCount == 0)
+		{
+			workerCount = hardwareThreads > reservedThreads ? hardwareThreads - reservedThreads : 1;
+		}
+
+		if (Config.MainThreadCore >= 0)
+		{
+			SetCurrentThreadAffinity(static_cast<uint32_t>(Config.MainThreadCore));
+		}
+
+		Queues.clear();
+		for (uint32_t i = 0; i < workerCount + 1; i++)
+		{
+			Queues.emplace_back(new WorkQueue());
+		}
+
+		Running = true;
+		uint32_t nextCore = 0;
+		for (uint32_t i = 0; i < workerCount; i++)
+		{
+			int32_t core = -1;
+			if (Config.PinWorkers && hardwareThreads > reservedThreads)
+			{
+				// Skip the cores the main and render threads live on
+				while (static_cast<int32_t>(nextCore % hardwareThreads) == Config.MainThreadCore ||
+					static_cast<int32_t>(nextCore % hardwareThreads) == Config.RenderThreadCore)
+				{
+					nextCore++;
+				}
+				core = static_cast<int32_t>(nextCore++ % hardwareThreads);
+			}
+
+			Workers.emplace_back([this, i, core]()
+			{
+				if (core >= 0)
+				{
+					SetCurrentThreadAffinity(static_cast<uint32_t>(core));
+				}
+				WorkerLoop(i + 1);
+			});
+		}
+	}
+	//-----------------------------------------------------------------------------
+	void JobSystem::Shutdown()
+	{
+		if (!Running)
+		{
+			return;
+		}
+
+		// Drain what is left so nobody waits on a counter forever
+		while (TryRunOne()) {}
+
+		{
+			std::lock_guard<std::mutex> lock(SleepLock);
+			Running = false;
+		}
+		WakeCondition.notify_all();
+
+		for (auto& worker : Workers)
+		{
+			worker.join();
+		}
+		Workers.clear();
+		Queues.clear();
+	}
+	//-----------------------------------------------------------------------------
+	void JobSystem::Run(JobFunction function, JobCounter* signal)
+	{
+		if (signal != nullptr)
+		{
+			signal->Pending.fetch_add(1, std::memory_order_acq_rel);
+		}
+
+		Job job = { std::move(function), signal };
+		if (!Running)
+		{
+			// No workers: behave like a plain function call
+			Execute(job);
+			return;
+		}
+		Push(std::move(job));
+	}
+	//-----------------------------------------------------------------------------
+	void JobSystem::RunAfter(JobCounter& dependency, JobFunction function, JobCounter* signal)
+	{
+		if (signal != nullptr)
+		{
+			signal->Pending.fetch_add(1, std::memory_order_acq_rel);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(dependency.ContinuationLock);
+			if (!dependency.IsDone())
+			{
+				dependency.Continuations.push_back({ std::move(function), signal });
+				return;
+			}
+		}
+
+		Job job = { std::move(function), signal };
+		if (!Running)
+		{
+			Execute(job);
+			return;
+		}
+		Push(std::move(job));
+	}
+	//-----------------------------------------------------------------------------
+	void JobSystem::Wait(JobCounter& counter)
+	{
+		while (!counter.IsDone())
+		{
+			if (!TryRunOne())
+			{
+				std::this_thread::yield();
+			}
+		}
+		// The last Finish() may still hold the lock
+		std::lock_guard<std::mutex> lock(counter.ContinuationLock);
+	}
+	//-----------------------------------------------------------------------------
+	void JobSystem::ParallelFor(uint32_t begin, uint32_t end, uint32_t grainSize, const std::function<void(uint32_t, uint32_t)>& function)
+	{
+		if (begin >= end)
+		{
+			return;
+		}
+		grainSize = std::max(1u, grainSize);
+
+		if (!Running || end - begin <= grainSize)
+		{
+			function(begin, end);
+			return;
+		}
+
+		JobCounter counter;
+		for (uint32_t chunkBegin = begin; chunkBegin < end; chunkBegin += grainSize)
+		{
+			uint32_t chunkEnd = std::min(end, chunkBegin + grainSize);
+			// function outlives the jobs since we wait below
+			Run([&function, chunkBegin, chunkEnd]() { function(chunkBegin, chunkEnd); }, &counter);
+		}
+		Wait(counter);
+	}
+	//-----------------------------------------------------------------------------
+	void JobSystem::PinRenderThread() const
+	{
+		if (Config.RenderThreadCore >= 0)
+		{
+			SetCurrentThreadAffinity(static_cast<uint32_t>(Config.RenderThreadCore));
+		}
+	}
+	//-----------------------------------------------------------------------------
+	const bool JobSystem::SetCurrentThreadAffinity(uint32_t core)
+	{
+#if defined(_WIN32)
+		if (core >= sizeof(DWORD_PTR) * 8)
+		{
+			return false;
+		}
+		return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << core) != 0;
+#elif defined(__linux__)
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		CPU_SET(core, &cpuSet);
+		return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet) == 0;
+#else
+		return false;
+#endif
+	}
+	//-----------------------------------------------------------------------------
+	const int32_t JobSystem::GetCurrentWorkerIndex()
+	{
+		return CurrentWorkerIndex;
+	}
+	//-----------------------------------------------------------------------------
+	void JobSystem::Push(Job&& job)
+	{
+		uint32_t queueIndex = (CurrentOwner == this && CurrentWorkerIndex > 0) ? static_cast<uint32_t>(CurrentWorkerIndex) : 0;
+		{
+			WorkQueue& queue = *Queues[queueIndex];
+			std::lock_guard<std::mutex> lock(queue.Lock);
+			// Counted inside the lock so a pop can never see the job before the count
+			QueuedJobs.fetch_add(1, std::memory_order_acq_rel);
+			queue.Jobs.push_back(std::move(job));
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(SleepLock);
+		}
+		WakeCondition.notify_one();
+	}
+	//-----------------------------------------------------------------------------
+	const bool JobSystem::TryPop(Job& job)
+	{
+		uint32_t queueIndex = (CurrentOwner == this && CurrentWorkerIndex > 0) ? static_cast<uint32_t>(CurrentWorkerIndex) : 0;
+		WorkQueue& queue = *Queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.Lock);
+		if (queue.Jobs.empty())
+		{
+			return false;
+		}
+		// LIFO for the owner: the newest job is the one still warm in cache
+		job = std::move(queue.Jobs.back());
+		queue.Jobs.pop_back();
+		QueuedJobs.fetch_sub(1, std::memory_order_acq_rel);
+		return true;
+	}
+	//-----------------------------------------------------------------------------
+	const bool JobSystem::TrySteal(uint32_t thiefIndex, Job& job)
+	{
+		uint32_t queueCount = static_cast<uint32_t>(Queues.size());
+		for (uint32_t offset = 1; offset < queueCount; offset++)
+		{
+			WorkQueue& queue = *Queues[(thiefIndex + offset) % queueCount];
+			std::unique_lock<std::mutex> lock(queue.Lock, std::try_to_lock);
+			if (!lock.owns_lock() || queue.Jobs.empty())
+			{
+				continue;
+			}
+			// FIFO for thieves: the oldest job tends to be the biggest chunk of work
+			job = std::move(queue.Jobs.front());
+			queue.Jobs.pop_front();
+			QueuedJobs.fetch_sub(1, std::memory_order_acq_rel);
+			return true;
+		}
+		return false;
+	}
+	//-----------------------------------------------------------------------------
+	const bool JobSystem::TryRunOne()
+	{
+		if (Queues.empty())
+		{
+			return false;
+		}
+
+		uint32_t ownIndex = (CurrentOwner == this && CurrentWorkerIndex > 0) ? static_cast<uint32_t>(CurrentWorkerIndex) : 0;
+		Job job;
+		if (TryPop(job) || TrySteal(ownIndex, job))
+		{
+			Execute(job);
+			return true;
+		}
+		return false;
+	}
+	//-----------------------------------------------------------------------------
+	void JobSystem::Execute(Job& job)
+	{
+		job.Function();
+		Finish(job.Signal);
+	}
+	//-----------------------------------------------------------------------------
+	void JobSystem::Finish(JobCounter* signal)
+	{
+		if (signal == nullptr)
+		{
+			return;
+		}
+
+		// Decrement under the lock: Wait() takes it too before letting the
+		// owner of the counter destroy it
+		std::vector<JobCounter::Continuation> continuations;
+		{
+			std::lock_guard<std::mutex> lock(signal->ContinuationLock);
+			if (signal->Pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			{
+				return;
+			}
+			continuations.swap(signal->Continuations);
+		}
+
+		for (auto& continuation : continuations)
+		{
+			Job job = { std::move(continuation.Function), continuation.Signal };
+			if (Running)
+			{
+				Push(std::move(job));
+			}
+			else
+			{
+				Execute(job);
+			}
+		}
+	}
+	//-----------------------------------------------------------------------------
+	void JobSystem::WorkerLoop(uint32_t index)
+	{
+		CurrentWorkerIndex = static_cast<int32_t>(index);
+		CurrentOwner = this;
+
+		while (true)
+		{
+			if (TryRunOne())
+			{
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(SleepLock);
+			WakeCondition.wait(lock, [this]()
+			{
+				return !Running || QueuedJobs.load(std::memory_order_acquire) > 0;
+			});
+
+			if (!Running && QueuedJobs.load(std::memory_order_acquire) == 0)
+			{
+				break;
+			}
+		}
+
+		CurrentWorkerIndex = -1;
+		CurrentOwner = nullptr;
+	}
+}
+//-----------------------------------------------------------------------------
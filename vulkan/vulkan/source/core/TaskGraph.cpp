@@ -0,0 +1,170 @@
+//-----------------------------------------------------------------------------
+#include "core/TaskGraph.h"
+#include <algorithm>
+#include <iomanip>
+#include <stdexcept>
+//-----------------------------------------------------------------------------
+namespace core
+{
+	TaskGraph::TaskGraph(JobSystem& jobs) : Jobs(jobs)
+	{
+	}
+	//-----------------------------------------------------------------------------
+	TaskHandle TaskGraph::AddTask(const std::string& name, JobFunction function, std::initializer_list<TaskHandle> dependencies)
+	{
+		TaskHandle handle = static_cast<TaskHandle>(Tasks.size());
+		std::unique_ptr<Task> task(new Task());
+		task->Name			= name;
+		task->Function		= std::move(function);
+		task->Timing.Name	= name;
+		task->Failed		= false;
+
+		for (TaskHandle dependency : dependencies)
+		{
+			if (dependency >= handle)
+			{
+				throw std::runtime_error("task " + name + " depends on a task that does not exist yet!");
+			}
+			if (std::find(task->Dependencies.begin(), task->Dependencies.end(), dependency) == task->Dependencies.end())
+			{
+				task->Dependencies.push_back(dependency);
+				Tasks[dependency]->Dependents.push_back(handle);
+			}
+		}
+		task->RemainingDependencies = static_cast<uint32_t>(task->Dependencies.size());
+
+		Tasks.push_back(std::move(task));
+		return handle;
+	}
+	//-----------------------------------------------------------------------------
+	void TaskGraph::Run()
+	{
+		StartTime = std::chrono::high_resolution_clock::now();
+
+		// Every task holds Done until it finished, dependents are launched from
+		// inside their last dependency so the count never drops to zero early
+		for (TaskHandle handle = 0; handle < Tasks.size(); handle++)
+		{
+			if (Tasks[handle]->Dependencies.empty())
+			{
+				Launch(handle);
+			}
+		}
+		Jobs.Wait(Done);
+
+		TotalMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - StartTime).count();
+
+		if (FirstError)
+		{
+			std::rethrow_exception(FirstError);
+		}
+	}
+	//-----------------------------------------------------------------------------
+	const std::vector<TaskTiming> TaskGraph::GetTimings() const
+	{
+		std::vector<TaskTiming> timings;
+		for (const auto& task : Tasks)
+		{
+			timings.push_back(task->Timing);
+		}
+		return timings;
+	}
+	//-----------------------------------------------------------------------------
+	const double TaskGraph::GetCriticalPathMs() const
+	{
+		// Tasks are stored in a topological order already
+		std::vector<double> pathMs(Tasks.size(), 0.0);
+		double longest = 0.0;
+		for (size_t i = 0; i < Tasks.size(); i++)
+		{
+			double start = 0.0;
+			for (TaskHandle dependency : Tasks[i]->Dependencies)
+			{
+				start = std::max(start, pathMs[dependency]);
+			}
+			pathMs[i] = start + (Tasks[i]->Timing.EndMs - Tasks[i]->Timing.StartMs);
+			longest = std::max(longest, pathMs[i]);
+		}
+		return longest;
+	}
+	//-----------------------------------------------------------------------------
+	void TaskGraph::PrintReport(std::ostream& stream) const
+	{
+		double serialMs = 0.0;
+		for (const auto& task : Tasks)
+		{
+			const TaskTiming& timing = task->Timing;
+			serialMs += timing.EndMs - timing.StartMs;
+
+			stream << "  " << std::left << std::setw(24) << timing.Name << std::right << std::fixed << std::setprecision(2)
+				<< std::setw(9) << timing.StartMs << " -> " << std::setw(9) << timing.EndMs << " ms";
+			if (timing.Skipped)
+			{
+				stream << "  (skipped)";
+			}
+			else if (timing.Worker >= 0)
+			{
+				stream << "  worker " << timing.Worker;
+			}
+			else
+			{
+				stream << "  caller";
+			}
+			stream << std::endl;
+		}
+		stream << std::fixed << std::setprecision(2)
+			<< "  wall " << TotalMs << " ms, serial " << serialMs << " ms, critical path " << GetCriticalPathMs() << " ms" << std::endl;
+	}
+	//-----------------------------------------------------------------------------
+	void TaskGraph::Launch(TaskHandle handle)
+	{
+		Jobs.Run([this, handle]() { Execute(handle); }, &Done);
+	}
+	//-----------------------------------------------------------------------------
+	void TaskGraph::Execute(TaskHandle handle)
+	{
+		Task& task = *Tasks[handle];
+		auto now = [this]()
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - StartTime).count();
+		};
+
+		task.Timing.Worker	= JobSystem::GetCurrentWorkerIndex();
+		task.Timing.StartMs	= now();
+		if (task.Failed)
+		{
+			task.Timing.Skipped = true;
+		}
+		else
+		{
+			try
+			{
+				task.Function();
+			}
+			catch (...)
+			{
+				task.Failed = true;
+				std::lock_guard<std::mutex> lock(ErrorLock);
+				if (!FirstError)
+				{
+					FirstError = std::current_exception();
+				}
+			}
+		}
+		task.Timing.EndMs = task.Timing.Skipped ? task.Timing.StartMs : now();
+
+		for (TaskHandle dependentHandle : task.Dependents)
+		{
+			Task& dependent = *Tasks[dependentHandle];
+			if (task.Failed)
+			{
+				dependent.Failed = true;
+			}
+			if (dependent.RemainingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				Launch(dependentHandle);
+			}
+		}
+	}
+}
+//-----------------------------------------------------------------------------
@@ -3,12 +3,12 @@
 #include <vulkan/vulkan.h>
 #include <iostream>
 #include "app/VulkanApplication.h"
-int main()
+int main(int argc, char** argv)
 {
-	VulkanApplication* vkApp = new VulkanApplication();
+	VulkanApplication* vkApp = new VulkanApplication(RendererSettings::FromCommandLine(argc, argv));
 	
 	vkApp->Start();
 	vkApp->Loop();
 	vkApp->Cleanup();
-	return 0;
+	return vkApp->GetExitCode();
 }
\ No newline at end of file
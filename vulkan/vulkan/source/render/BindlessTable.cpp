@@ -0,0 +1,153 @@
+//-----------------------------------------------------------------------------
+#include "render/BindlessTable.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	BindlessTable::BindlessTable(VkDevice device, const VkPhysicalDeviceDescriptorIndexingPropertiesEXT& limits, const BindlessTableDesc& desc)
+		: Device(device)
+	{
+		MaxStorageBuffers = std::min(desc.MaxStorageBuffers, std::min(limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers, limits.maxDescriptorSetUpdateAfterBindStorageBuffers));
+		MaxSampledImages = std::min(desc.MaxSampledImages, std::min(limits.maxPerStageDescriptorUpdateAfterBindSampledImages, limits.maxDescriptorSetUpdateAfterBindSampledImages));
+
+		VkDescriptorSetLayoutBinding bindings[2] = {};
+		bindings[0].binding			= BindlessStorageBufferBinding;
+		bindings[0].descriptorType	= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[0].descriptorCount	= MaxStorageBuffers;
+		bindings[0].stageFlags		= VK_SHADER_STAGE_ALL;
+
+		bindings[1].binding			= BindlessSampledImageBinding;
+		bindings[1].descriptorType	= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		bindings[1].descriptorCount	= MaxSampledImages;
+		bindings[1].stageFlags		= VK_SHADER_STAGE_ALL;
+
+		// Slots can be written while the set is bound, and unwritten slots are fine
+		// as long as no shader reaches them
+		VkDescriptorBindingFlagsEXT bindingFlags[2] =
+		{
+			VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT,
+			VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT
+		};
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfoEXT flagsInfo = {};
+		flagsInfo.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+		flagsInfo.bindingCount	= 2;
+		flagsInfo.pBindingFlags	= bindingFlags;
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+		layoutInfo.sType		= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.pNext		= &flagsInfo;
+		layoutInfo.flags		= VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+		layoutInfo.bindingCount	= 2;
+		layoutInfo.pBindings	= bindings;
+
+		if (vkCreateDescriptorSetLayout(Device, &layoutInfo, nullptr, &Layout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create bindless descriptor set layout!");
+		}
+
+		VkDescriptorPoolSize poolSizes[2] =
+		{
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, MaxStorageBuffers },
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MaxSampledImages }
+		};
+
+		VkDescriptorPoolCreateInfo poolInfo = {};
+		poolInfo.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.flags			= VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+		poolInfo.maxSets		= 1;
+		poolInfo.poolSizeCount	= 2;
+		poolInfo.pPoolSizes		= poolSizes;
+
+		if (vkCreateDescriptorPool(Device, &poolInfo, nullptr, &Pool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create bindless descriptor pool!");
+		}
+
+		VkDescriptorSetAllocateInfo allocInfo = {};
+		allocInfo.sType					= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool		= Pool;
+		allocInfo.descriptorSetCount	= 1;
+		allocInfo.pSetLayouts			= &Layout;
+
+		if (vkAllocateDescriptorSets(Device, &allocInfo, &Set) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to allocate bindless descriptor set!");
+		}
+	}
+	//-----------------------------------------------------------------------------
+	BindlessTable::~BindlessTable()
+	{
+		vkDestroyDescriptorPool(Device, Pool, nullptr);
+		vkDestroyDescriptorSetLayout(Device, Layout, nullptr);
+	}
+	//-----------------------------------------------------------------------------
+	const uint32_t BindlessTable::RegisterBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+	{
+		uint32_t index = AcquireSlot(BufferSlots, MaxStorageBuffers, "storage buffer");
+
+		VkDescriptorBufferInfo bufferInfo = { buffer, offset, range };
+
+		VkWriteDescriptorSet write	= {};
+		write.sType					= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet				= Set;
+		write.dstBinding			= BindlessStorageBufferBinding;
+		write.dstArrayElement		= index;
+		write.descriptorType		= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		write.descriptorCount		= 1;
+		write.pBufferInfo			= &bufferInfo;
+		vkUpdateDescriptorSets(Device, 1, &write, 0, nullptr);
+
+		return index;
+	}
+	//-----------------------------------------------------------------------------
+	const uint32_t BindlessTable::RegisterImage(VkImageView view, VkSampler sampler, VkImageLayout layout)
+	{
+		uint32_t index = AcquireSlot(ImageSlots, MaxSampledImages, "sampled image");
+		UpdateImage(index, view, sampler, layout);
+		return index;
+	}
+	//-----------------------------------------------------------------------------
+	void BindlessTable::UpdateImage(uint32_t index, VkImageView view, VkSampler sampler, VkImageLayout layout)
+	{
+		VkDescriptorImageInfo imageInfo = { sampler, view, layout };
+
+		VkWriteDescriptorSet write	= {};
+		write.sType					= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet				= Set;
+		write.dstBinding			= BindlessSampledImageBinding;
+		write.dstArrayElement		= index;
+		write.descriptorType		= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		write.descriptorCount		= 1;
+		write.pImageInfo			= &imageInfo;
+		vkUpdateDescriptorSets(Device, 1, &write, 0, nullptr);
+	}
+	//-----------------------------------------------------------------------------
+	void BindlessTable::ReleaseBuffer(uint32_t index)
+	{
+		BufferSlots.Free.push_back(index);
+	}
+	//-----------------------------------------------------------------------------
+	void BindlessTable::ReleaseImage(uint32_t index)
+	{
+		ImageSlots.Free.push_back(index);
+	}
+	//-----------------------------------------------------------------------------
+	const uint32_t BindlessTable::AcquireSlot(SlotList& slots, uint32_t capacity, const char* what)
+	{
+		if (!slots.Free.empty())
+		{
+			uint32_t index = slots.Free.back();
+			slots.Free.pop_back();
+			return index;
+		}
+		if (slots.Next >= capacity)
+		{
+			throw std::runtime_error(std::string("bindless table is out of ") + what + " slots!");
+		}
+		return slots.Next++;
+	}
+}
+//-----------------------------------------------------------------------------
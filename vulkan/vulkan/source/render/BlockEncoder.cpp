@@ -0,0 +1,410 @@
+//-----------------------------------------------------------------------------
+#include "render/BlockEncoder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	static const uint32_t BlockTexels = 16;
+	// BC7 4-bit index weights, out of 64
+	static const int32_t BC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+	//-----------------------------------------------------------------------------
+	struct BlockTexelsF
+	{
+		float Texels[BlockTexels][4];
+	};
+	//-----------------------------------------------------------------------------
+	// Appends bits LSB first, the way BC7 fields are laid out
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(uint8_t* block, uint32_t bytes) : Block(block) { memset(Block, 0, bytes); }
+
+		void Write(uint32_t value, uint32_t bits)
+		{
+			for (uint32_t i = 0; i < bits; i++, Position++)
+			{
+				Block[Position >> 3] |= static_cast<uint8_t>(((value >> i) & 1) << (Position & 7));
+			}
+		}
+
+	private:
+		uint8_t* Block;
+		uint32_t Position = 0;
+	};
+	//-----------------------------------------------------------------------------
+	static BlockTexelsF ToFloat(const uint8_t* texels)
+	{
+		BlockTexelsF block;
+		for (uint32_t i = 0; i < BlockTexels; i++)
+		{
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				block.Texels[i][c] = texels[i * 4 + c];
+			}
+		}
+		return block;
+	}
+	//-----------------------------------------------------------------------------
+	static float Clamp255(float value)
+	{
+		return std::min(std::max(value, 0.0f), 255.0f);
+	}
+	//-----------------------------------------------------------------------------
+	// Segment through the block along its principal axis, cut at the
+	// outermost projections
+	static void FitPrincipalAxis(const BlockTexelsF& block, uint32_t channels, float low[4], float high[4])
+	{
+		float mean[4] = {};
+		for (uint32_t i = 0; i < BlockTexels; i++)
+		{
+			for (uint32_t c = 0; c < channels; c++)
+			{
+				mean[c] += block.Texels[i][c] / BlockTexels;
+			}
+		}
+
+		float covariance[4][4] = {};
+		for (uint32_t i = 0; i < BlockTexels; i++)
+		{
+			for (uint32_t a = 0; a < channels; a++)
+			{
+				for (uint32_t b = 0; b < channels; b++)
+				{
+					covariance[a][b] += (block.Texels[i][a] - mean[a]) * (block.Texels[i][b] - mean[b]);
+				}
+			}
+		}
+
+		// Power iteration, a few steps are plenty for 16 points
+		float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		for (uint32_t step = 0; step < 8; step++)
+		{
+			float next[4] = {};
+			float length = 0.0f;
+			for (uint32_t a = 0; a < channels; a++)
+			{
+				for (uint32_t b = 0; b < channels; b++)
+				{
+					next[a] += covariance[a][b] * axis[b];
+				}
+				length += next[a] * next[a];
+			}
+			if (length < 1e-12f)
+			{
+				break;
+			}
+			length = std::sqrt(length);
+			for (uint32_t c = 0; c < channels; c++)
+			{
+				axis[c] = next[c] / length;
+			}
+		}
+
+		float minProjection = 0.0f;
+		float maxProjection = 0.0f;
+		for (uint32_t i = 0; i < BlockTexels; i++)
+		{
+			float projection = 0.0f;
+			for (uint32_t c = 0; c < channels; c++)
+			{
+				projection += (block.Texels[i][c] - mean[c]) * axis[c];
+			}
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			low[c]	= c < channels ? Clamp255(mean[c] + axis[c] * minProjection) : 255.0f;
+			high[c]	= c < channels ? Clamp255(mean[c] + axis[c] * maxProjection) : 255.0f;
+		}
+	}
+	//-----------------------------------------------------------------------------
+	// Endpoints with the least squared error for fixed weights (0 is low,
+	// 1 is high), false when all texels use the same weight
+	static const bool SolveEndpoints(const BlockTexelsF& block, const float weights[BlockTexels], uint32_t channels, float low[4], float high[4])
+	{
+		float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+		float ax[4] = {}, bx[4] = {};
+		for (uint32_t i = 0; i < BlockTexels; i++)
+		{
+			float a = 1.0f - weights[i];
+			float b = weights[i];
+			aa += a * a;
+			bb += b * b;
+			ab += a * b;
+			for (uint32_t c = 0; c < channels; c++)
+			{
+				ax[c] += a * block.Texels[i][c];
+				bx[c] += b * block.Texels[i][c];
+			}
+		}
+
+		float determinant = aa * bb - ab * ab;
+		if (std::fabs(determinant) < 1e-6f)
+		{
+			return false;
+		}
+		for (uint32_t c = 0; c < channels; c++)
+		{
+			low[c]	= Clamp255((ax[c] * bb - bx[c] * ab) / determinant);
+			high[c]	= Clamp255((bx[c] * aa - ax[c] * ab) / determinant);
+		}
+		return true;
+	}
+	//-----------------------------------------------------------------------------
+	static uint16_t To565(const float color[4])
+	{
+		uint32_t r = static_cast<uint32_t>(color[0] * 31.0f / 255.0f + 0.5f);
+		uint32_t g = static_cast<uint32_t>(color[1] * 63.0f / 255.0f + 0.5f);
+		uint32_t b = static_cast<uint32_t>(color[2] * 31.0f / 255.0f + 0.5f);
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+	//-----------------------------------------------------------------------------
+	static void From565(uint16_t value, float color[3])
+	{
+		uint32_t r = (value >> 11) & 31;
+		uint32_t g = (value >> 5) & 63;
+		uint32_t b = value & 31;
+		color[0] = static_cast<float>((r << 3) | (r >> 2));
+		color[1] = static_cast<float>((g << 2) | (g >> 4));
+		color[2] = static_cast<float>((b << 3) | (b >> 2));
+	}
+	//-----------------------------------------------------------------------------
+	// Packs one candidate, returns its squared error and the weight of each texel
+	static float TryBC1(const BlockTexelsF& block, const float low[4], const float high[4], uint8_t* output, float weights[BlockTexels])
+	{
+		uint16_t color0 = To565(low);
+		uint16_t color1 = To565(high);
+		// color0 > color1 selects the four color mode
+		bool swapped = color0 < color1;
+		if (swapped)
+		{
+			std::swap(color0, color1);
+		}
+
+		float palette[4][3];
+		From565(color0, palette[0]);
+		From565(color1, palette[1]);
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+			palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+		}
+		// Toward color1, swapped back so weights stay relative to low
+		const float paletteWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+		uint32_t indices	= 0;
+		float error			= 0.0f;
+		// Equal colors mean three color mode, index 0 stays valid in it
+		uint32_t usable		= color0 == color1 ? 1 : 4;
+		for (uint32_t i = 0; i < BlockTexels; i++)
+		{
+			uint32_t best		= 0;
+			float bestError		= 1e30f;
+			for (uint32_t p = 0; p < usable; p++)
+			{
+				float e = 0.0f;
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					float d = block.Texels[i][c] - palette[p][c];
+					e += d * d;
+				}
+				if (e < bestError)
+				{
+					bestError	= e;
+					best		= p;
+				}
+			}
+			indices		|= best << (i * 2);
+			error		+= bestError;
+			weights[i]	= swapped ? 1.0f - paletteWeights[best] : paletteWeights[best];
+		}
+
+		output[0] = static_cast<uint8_t>(color0 & 0xFF);
+		output[1] = static_cast<uint8_t>(color0 >> 8);
+		output[2] = static_cast<uint8_t>(color1 & 0xFF);
+		output[3] = static_cast<uint8_t>(color1 >> 8);
+		memcpy(output + 4, &indices, sizeof(indices));
+		return error;
+	}
+	//-----------------------------------------------------------------------------
+	void EncodeBC1Block(const uint8_t* texels, uint8_t* block)
+	{
+		BlockTexelsF source = ToFloat(texels);
+		float low[4], high[4], weights[BlockTexels];
+		FitPrincipalAxis(source, 3, low, high);
+		float error = TryBC1(source, low, high, block, weights);
+
+		uint8_t refined[8];
+		if (SolveEndpoints(source, weights, 3, low, high) && TryBC1(source, low, high, refined, weights) < error)
+		{
+			memcpy(block, refined, sizeof(refined));
+		}
+	}
+	//-----------------------------------------------------------------------------
+	// 7 bits per channel plus a p-bit shared by the endpoint, picked for the lower error
+	static void QuantizeBC7Endpoint(const float endpoint[4], uint32_t quantized[4], uint32_t& pbit)
+	{
+		float bestError = 1e30f;
+		for (uint32_t p = 0; p < 2; p++)
+		{
+			uint32_t candidate[4];
+			float error = 0.0f;
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				int32_t q = static_cast<int32_t>(std::floor((endpoint[c] - p) / 2.0f + 0.5f));
+				candidate[c] = static_cast<uint32_t>(std::min(std::max(q, 0), 127));
+				float d = static_cast<float>(candidate[c] * 2 + p) - endpoint[c];
+				error += d * d;
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				pbit = p;
+				memcpy(quantized, candidate, sizeof(candidate));
+			}
+		}
+	}
+	//-----------------------------------------------------------------------------
+	static float TryBC7(const BlockTexelsF& block, const float low[4], const float high[4], uint8_t* output, float weights[BlockTexels])
+	{
+		uint32_t quantized[2][4];
+		uint32_t pbits[2];
+		QuantizeBC7Endpoint(low, quantized[0], pbits[0]);
+		QuantizeBC7Endpoint(high, quantized[1], pbits[1]);
+
+		int32_t palette[16][4];
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			int32_t e0 = static_cast<int32_t>(quantized[0][c] * 2 + pbits[0]);
+			int32_t e1 = static_cast<int32_t>(quantized[1][c] * 2 + pbits[1]);
+			for (uint32_t w = 0; w < 16; w++)
+			{
+				palette[w][c] = ((64 - BC7Weights[w]) * e0 + BC7Weights[w] * e1 + 32) >> 6;
+			}
+		}
+
+		uint32_t indices[BlockTexels];
+		float error = 0.0f;
+		for (uint32_t i = 0; i < BlockTexels; i++)
+		{
+			float bestError = 1e30f;
+			for (uint32_t w = 0; w < 16; w++)
+			{
+				float e = 0.0f;
+				for (uint32_t c = 0; c < 4; c++)
+				{
+					float d = block.Texels[i][c] - palette[w][c];
+					e += d * d;
+				}
+				if (e < bestError)
+				{
+					bestError	= e;
+					indices[i]	= w;
+				}
+			}
+			error		+= bestError;
+			weights[i]	= BC7Weights[indices[i]] / 64.0f;
+		}
+
+		// The first index is stored without its top bit, flip the block if it is set
+		if (indices[0] & 8)
+		{
+			std::swap(quantized[0], quantized[1]);
+			std::swap(pbits[0], pbits[1]);
+			for (uint32_t i = 0; i < BlockTexels; i++)
+			{
+				indices[i] = 15 - indices[i];
+			}
+		}
+
+		BitWriter writer(output, 16);
+		writer.Write(1 << 6, 7);
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			writer.Write(quantized[0][c], 7);
+			writer.Write(quantized[1][c], 7);
+		}
+		writer.Write(pbits[0], 1);
+		writer.Write(pbits[1], 1);
+		writer.Write(indices[0], 3);
+		for (uint32_t i = 1; i < BlockTexels; i++)
+		{
+			writer.Write(indices[i], 4);
+		}
+		return error;
+	}
+	//-----------------------------------------------------------------------------
+	void EncodeBC7Block(const uint8_t* texels, uint8_t* block)
+	{
+		BlockTexelsF source = ToFloat(texels);
+		float low[4], high[4], weights[BlockTexels];
+		FitPrincipalAxis(source, 4, low, high);
+		float error = TryBC7(source, low, high, block, weights);
+
+		uint8_t refined[16];
+		if (SolveEndpoints(source, weights, 4, low, high) && TryBC7(source, low, high, refined, weights) < error)
+		{
+			memcpy(block, refined, sizeof(refined));
+		}
+	}
+	//-----------------------------------------------------------------------------
+	const uint32_t GetEncodedBlockSize(BlockEncoding encoding)
+	{
+		return encoding == BlockEncoding::BC1 ? 8 : 16;
+	}
+	//-----------------------------------------------------------------------------
+	const VkFormat GetEncodedFormat(BlockEncoding encoding, bool srgb)
+	{
+		if (encoding == BlockEncoding::BC1)
+		{
+			return srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+		}
+		return srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+	}
+	//-----------------------------------------------------------------------------
+	std::vector<char> EncodeImage(core::JobSystem& jobs, const uint8_t* rgba, uint32_t width, uint32_t height, BlockEncoding encoding)
+	{
+		uint32_t blocksX	= (width + 3) / 4;
+		uint32_t blocksY	= (height + 3) / 4;
+		uint32_t blockSize	= GetEncodedBlockSize(encoding);
+		std::vector<char> encoded(static_cast<size_t>(blocksX) * blocksY * blockSize);
+
+		// About 4k blocks per job, small levels end up in a single one
+		uint32_t grainSize = std::max(4096u / blocksX, 1u);
+		jobs.ParallelFor(0, blocksY, grainSize, [&](uint32_t begin, uint32_t end)
+		{
+			uint8_t texels[BlockTexels * 4];
+			for (uint32_t by = begin; by < end; by++)
+			{
+				for (uint32_t bx = 0; bx < blocksX; bx++)
+				{
+					for (uint32_t y = 0; y < 4; y++)
+					{
+						uint32_t sy = std::min(by * 4 + y, height - 1);
+						for (uint32_t x = 0; x < 4; x++)
+						{
+							uint32_t sx = std::min(bx * 4 + x, width - 1);
+							memcpy(texels + (y * 4 + x) * 4, rgba + (static_cast<size_t>(sy) * width + sx) * 4, 4);
+						}
+					}
+
+					uint8_t* block = reinterpret_cast<uint8_t*>(encoded.data()) + (static_cast<size_t>(by) * blocksX + bx) * blockSize;
+					if (encoding == BlockEncoding::BC1)
+					{
+						EncodeBC1Block(texels, block);
+					}
+					else
+					{
+						EncodeBC7Block(texels, block);
+					}
+				}
+			}
+		});
+		return encoded;
+	}
+}
+//-----------------------------------------------------------------------------
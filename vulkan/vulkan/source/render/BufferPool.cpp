@@ -0,0 +1,410 @@
+//-----------------------------------------------------------------------------
+#include "render/BufferPool.h"
+#include <algorithm>
+#include <stdexcept>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+	//-----------------------------------------------------------------------------
+	BufferPool::BufferPool(VkDevice device, MemoryTypeFinder findMemoryType, const BufferPoolDesc& desc)
+		: Device(device)
+		, FindMemoryType(findMemoryType)
+		, Desc(desc)
+		, RetiredRanges(std::max(desc.FramesInFlight, 1u))
+		, RetiredBlocks(std::max(desc.FramesInFlight, 1u))
+	{
+		if (Desc.MaxBlocks == 1)
+		{
+			CreateBlock(Desc.BlockSize);
+		}
+	}
+	//-----------------------------------------------------------------------------
+	BufferPool::~BufferPool()
+	{
+		for (const auto& block : Blocks)
+		{
+			DestroyBlock(*block);
+		}
+	}
+	//-----------------------------------------------------------------------------
+	BufferAllocation BufferPool::Allocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		std::lock_guard<std::mutex> lock(Lock);
+
+		alignment = std::max<VkDeviceSize>(alignment, 1);
+		uint32_t blockId;
+		VkDeviceSize offset;
+		if (!Place(size, alignment, nullptr, blockId, offset))
+		{
+			if (Desc.MaxBlocks > 0 && Blocks.size() >= Desc.MaxBlocks)
+			{
+				throw std::runtime_error("buffer pool is full!");
+			}
+			Block& block = CreateBlock(std::max(Desc.BlockSize, AlignUp(size, alignment)));
+			block.Ranges.Allocate(size, alignment, offset);
+			blockId = block.Id;
+		}
+		FindBlock(blockId)->Live++;
+
+		BufferAllocation handle;
+		if (!FreeHandles.empty())
+		{
+			handle = FreeHandles.back();
+			FreeHandles.pop_back();
+		}
+		else
+		{
+			handle = static_cast<BufferAllocation>(Allocations.size());
+			Allocations.emplace_back();
+		}
+
+		Allocation& allocation	= Allocations[handle];
+		allocation.BlockId		= blockId;
+		allocation.Offset		= offset;
+		allocation.Size			= size;
+		allocation.Alignment	= alignment;
+		allocation.Live			= true;
+		return handle;
+	}
+	//-----------------------------------------------------------------------------
+	void BufferPool::Free(BufferAllocation handle)
+	{
+		std::lock_guard<std::mutex> lock(Lock);
+
+		Allocation& allocation = Allocations.at(handle);
+		if (!allocation.Live)
+		{
+			throw std::runtime_error("buffer pool allocation freed twice!");
+		}
+		RetiredRanges[FrameSlot].push_back({ allocation.BlockId, allocation.Offset, allocation.Size });
+		FindBlock(allocation.BlockId)->Live--;
+		allocation.Live = false;
+		FreeHandles.push_back(handle);
+	}
+	//-----------------------------------------------------------------------------
+	const BufferRange BufferPool::Resolve(BufferAllocation handle) const
+	{
+		std::lock_guard<std::mutex> lock(Lock);
+
+		const Allocation& allocation = Allocations.at(handle);
+		const Block* block = FindBlock(allocation.BlockId);
+
+		BufferRange range;
+		range.Buffer	= block->Buffer;
+		range.Offset	= allocation.Offset;
+		range.Size		= allocation.Size;
+		range.Mapped	= block->Mapped != nullptr ? block->Mapped + allocation.Offset : nullptr;
+		return range;
+	}
+	//-----------------------------------------------------------------------------
+	VkBuffer BufferPool::GetBuffer() const
+	{
+		if (Desc.MaxBlocks != 1)
+		{
+			throw std::runtime_error("buffer pool has more than one block!");
+		}
+		return Blocks.front()->Buffer;
+	}
+	//-----------------------------------------------------------------------------
+	void BufferPool::BeginFrame(uint32_t frameSlot)
+	{
+		std::lock_guard<std::mutex> lock(Lock);
+
+		FrameSlot = frameSlot % RetiredRanges.size();
+		for (const RetiredRange& range : RetiredRanges[FrameSlot])
+		{
+			// Gone if its block was released in the meantime
+			Block* block = FindBlock(range.BlockId);
+			if (block != nullptr)
+			{
+				block->Ranges.Free(range.Offset, range.Size);
+			}
+		}
+		RetiredRanges[FrameSlot].clear();
+
+		for (uint32_t id : RetiredBlocks[FrameSlot])
+		{
+			auto found = std::find_if(Blocks.begin(), Blocks.end(), [id](const std::unique_ptr<Block>& block) { return block->Id == id; });
+			DestroyBlock(**found);
+			Blocks.erase(found);
+		}
+		RetiredBlocks[FrameSlot].clear();
+	}
+	//-----------------------------------------------------------------------------
+	void BufferPool::Defragment(VkCommandBuffer commandBuffer)
+	{
+		std::lock_guard<std::mutex> lock(Lock);
+
+		Stats.MovedBytes = 0;
+		std::vector<PendingCopy> copies;
+
+		// An evacuation spans as many frames as the byte budget makes it take
+		Block* source = EvacuatingBlock != 0 ? FindBlock(EvacuatingBlock) : FindEvacuationCandidate();
+		if (source != nullptr)
+		{
+			source->Releasing	= true;
+			EvacuatingBlock		= source->Id;
+			for (Allocation& allocation : Allocations)
+			{
+				if (!allocation.Live || allocation.BlockId != source->Id)
+				{
+					continue;
+				}
+				if (Stats.MovedBytes > 0 && Stats.MovedBytes + allocation.Size > Desc.DefragBytesPerFrame)
+				{
+					break;
+				}
+
+				uint32_t blockId;
+				VkDeviceSize offset;
+				if (!Place(allocation.Size, allocation.Alignment, source, blockId, offset))
+				{
+					// Too fragmented elsewhere, the block stays in use
+					source->Releasing	= false;
+					EvacuatingBlock		= 0;
+					break;
+				}
+				Move(allocation, *source, *FindBlock(blockId), offset, copies);
+			}
+
+			if (source->Live == 0)
+			{
+				RetiredBlocks[FrameSlot].push_back(source->Id);
+				EvacuatingBlock = 0;
+				Stats.BlocksReleased++;
+			}
+		}
+		else
+		{
+			// Nothing to release, compact the most fragmented block instead
+			Block* target = nullptr;
+			for (const auto& block : Blocks)
+			{
+				if (!block->Releasing && block->Ranges.GetFreeRangeCount() > 1 && (target == nullptr || block->Ranges.GetFreeRangeCount() > target->Ranges.GetFreeRangeCount()))
+				{
+					target = block.get();
+				}
+			}
+
+			while (target != nullptr)
+			{
+				Allocation* last = nullptr;
+				for (Allocation& allocation : Allocations)
+				{
+					if (allocation.Live && allocation.BlockId == target->Id && (last == nullptr || allocation.Offset > last->Offset))
+					{
+						last = &allocation;
+					}
+				}
+
+				VkDeviceSize offset;
+				if (last == nullptr || Stats.MovedBytes + last->Size > Desc.DefragBytesPerFrame ||
+					!target->Ranges.AllocateBelow(last->Size, last->Alignment, last->Offset, offset))
+				{
+					break;
+				}
+				Move(*last, *target, *target, offset, copies);
+			}
+		}
+
+		if (copies.empty())
+		{
+			return;
+		}
+
+		// Earlier copies and uploads into the sources are done before reading them
+		VkMemoryBarrier barrier = {};
+		barrier.sType			= VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask	= VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask	= VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		for (const PendingCopy& copy : copies)
+		{
+			vkCmdCopyBuffer(commandBuffer, copy.Source, copy.Destination, 1, &copy.Region);
+		}
+
+		// The pool doesn't know who reads what, any later read sees the moves
+		barrier.srcAccessMask	= VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask	= VK_ACCESS_MEMORY_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+	//-----------------------------------------------------------------------------
+	const BufferPoolStats BufferPool::GetStats() const
+	{
+		std::lock_guard<std::mutex> lock(Lock);
+
+		BufferPoolStats stats	= Stats;
+		stats.Blocks			= static_cast<uint32_t>(Blocks.size());
+		stats.BlockBytes		= 0;
+		for (const auto& block : Blocks)
+		{
+			stats.BlockBytes += block->Ranges.GetSize();
+		}
+		stats.Allocations		= 0;
+		stats.UsedBytes			= 0;
+		for (const Allocation& allocation : Allocations)
+		{
+			if (allocation.Live)
+			{
+				stats.Allocations++;
+				stats.UsedBytes += allocation.Size;
+			}
+		}
+		return stats;
+	}
+	//-----------------------------------------------------------------------------
+	BufferPool::Block& BufferPool::CreateBlock(VkDeviceSize size)
+	{
+		std::unique_ptr<Block> block(new Block());
+		block->Id		= NextBlockId++;
+		block->Ranges	= RangeAllocator(size);
+
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType		= VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size			= size;
+		bufferInfo.usage		= Desc.Usage | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		bufferInfo.sharingMode	= VK_SHARING_MODE_EXCLUSIVE;
+		if (vkCreateBuffer(Device, &bufferInfo, nullptr, &block->Buffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create buffer pool block!");
+		}
+
+		VkMemoryRequirements memRequirements;
+		vkGetBufferMemoryRequirements(Device, block->Buffer, &memRequirements);
+
+		VkMemoryAllocateInfo allocInfo	= {};
+		allocInfo.sType					= VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize		= memRequirements.size;
+		allocInfo.memoryTypeIndex		= FindMemoryType(memRequirements.memoryTypeBits, Desc.MemoryProperties);
+		if (vkAllocateMemory(Device, &allocInfo, nullptr, &block->Memory) != VK_SUCCESS)
+		{
+			DestroyBlock(*block);
+			throw std::runtime_error("failed to allocate buffer pool block memory!");
+		}
+		vkBindBufferMemory(Device, block->Buffer, block->Memory, 0);
+
+		if (Desc.MemoryProperties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		{
+			void* mapped;
+			vkMapMemory(Device, block->Memory, 0, VK_WHOLE_SIZE, 0, &mapped);
+			block->Mapped = static_cast<uint8_t*>(mapped);
+		}
+
+		Blocks.push_back(std::move(block));
+		return *Blocks.back();
+	}
+	//-----------------------------------------------------------------------------
+	void BufferPool::DestroyBlock(Block& block) const
+	{
+		vkDestroyBuffer(Device, block.Buffer, nullptr);
+		// Unmapped along with it
+		vkFreeMemory(Device, block.Memory, nullptr);
+	}
+	//-----------------------------------------------------------------------------
+	BufferPool::Block* BufferPool::FindBlock(uint32_t id) const
+	{
+		for (const auto& block : Blocks)
+		{
+			if (block->Id == id)
+			{
+				return block.get();
+			}
+		}
+		return nullptr;
+	}
+	//-----------------------------------------------------------------------------
+	const bool BufferPool::Place(VkDeviceSize size, VkDeviceSize alignment, const Block* exclude, uint32_t& blockId, VkDeviceSize& offset)
+	{
+		// Fullest first, so the emptier blocks drain
+		std::vector<Block*> candidates;
+		for (const auto& block : Blocks)
+		{
+			if (block.get() != exclude && !block->Releasing)
+			{
+				candidates.push_back(block.get());
+			}
+		}
+		std::sort(candidates.begin(), candidates.end(), [](const Block* a, const Block* b) { return a->Ranges.GetUsed() > b->Ranges.GetUsed(); });
+
+		for (Block* block : candidates)
+		{
+			if (block->Ranges.Allocate(size, alignment, offset))
+			{
+				blockId = block->Id;
+				return true;
+			}
+		}
+		return false;
+	}
+	//-----------------------------------------------------------------------------
+	void BufferPool::Move(Allocation& allocation, Block& from, Block& to, VkDeviceSize offset, std::vector<PendingCopy>& copies)
+	{
+		VkBufferCopy region = {};
+		region.srcOffset	= allocation.Offset;
+		region.dstOffset	= offset;
+		region.size			= allocation.Size;
+		copies.push_back({ from.Buffer, to.Buffer, region });
+
+		// Frames in flight still read the old range
+		RetiredRanges[FrameSlot].push_back({ from.Id, allocation.Offset, allocation.Size });
+		from.Live--;
+		to.Live++;
+		allocation.BlockId	= to.Id;
+		allocation.Offset	= offset;
+
+		Stats.MovedBytes += allocation.Size;
+		Stats.Moves++;
+	}
+	//-----------------------------------------------------------------------------
+	BufferPool::Block* BufferPool::FindEvacuationCandidate() const
+	{
+		// Live bytes per block; Ranges.GetUsed also counts retired ranges
+		std::vector<VkDeviceSize> live(Blocks.size(), 0);
+		for (const Allocation& allocation : Allocations)
+		{
+			if (allocation.Live)
+			{
+				for (size_t i = 0; i < Blocks.size(); i++)
+				{
+					if (Blocks[i]->Id == allocation.BlockId)
+					{
+						live[i] += allocation.Size;
+					}
+				}
+			}
+		}
+
+		Block* candidate = nullptr;
+		VkDeviceSize candidateLive = 0;
+		VkDeviceSize freeBytes = 0;
+		uint32_t usable = 0;
+		for (size_t i = 0; i < Blocks.size(); i++)
+		{
+			if (Blocks[i]->Releasing)
+			{
+				continue;
+			}
+			usable++;
+			freeBytes += Blocks[i]->Ranges.GetSize() - Blocks[i]->Ranges.GetUsed();
+			if (candidate == nullptr || live[i] < candidateLive)
+			{
+				candidate		= Blocks[i].get();
+				candidateLive	= live[i];
+			}
+		}
+
+		// The last block is kept, and the others need room for what it holds
+		if (usable < 2)
+		{
+			return nullptr;
+		}
+		VkDeviceSize candidateFree = candidate->Ranges.GetSize() - candidate->Ranges.GetUsed();
+		return candidateLive <= freeBytes - candidateFree ? candidate : nullptr;
+	}
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,241 @@
+//-----------------------------------------------------------------------------
+#include "render/ComputeQueue.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	static VkBufferMemoryBarrier MakeBufferBarrier(VkBuffer buffer, uint32_t srcFamily, uint32_t dstFamily, VkAccessFlags srcAccess, VkAccessFlags dstAccess)
+	{
+		VkBufferMemoryBarrier barrier = {};
+		barrier.sType				= VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask		= srcAccess;
+		barrier.dstAccessMask		= dstAccess;
+		barrier.srcQueueFamilyIndex	= srcFamily;
+		barrier.dstQueueFamilyIndex	= dstFamily;
+		barrier.buffer				= buffer;
+		barrier.offset				= 0;
+		barrier.size				= VK_WHOLE_SIZE;
+		return barrier;
+	}
+	//-----------------------------------------------------------------------------
+	static VkImageMemoryBarrier MakeImageBarrier(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t srcFamily, uint32_t dstFamily, VkAccessFlags srcAccess, VkAccessFlags dstAccess)
+	{
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType							= VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout						= oldLayout;
+		barrier.newLayout						= newLayout;
+		barrier.srcAccessMask					= srcAccess;
+		barrier.dstAccessMask					= dstAccess;
+		barrier.srcQueueFamilyIndex				= srcFamily;
+		barrier.dstQueueFamilyIndex				= dstFamily;
+		barrier.image							= image;
+		barrier.subresourceRange.aspectMask		= VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel	= 0;
+		barrier.subresourceRange.levelCount		= VK_REMAINING_MIP_LEVELS;
+		barrier.subresourceRange.baseArrayLayer	= 0;
+		barrier.subresourceRange.layerCount		= VK_REMAINING_ARRAY_LAYERS;
+		return barrier;
+	}
+	//-----------------------------------------------------------------------------
+	ComputeQueue::ComputeQueue(VkDevice device, VkQueue queue, uint32_t family, uint32_t graphicsFamily, uint32_t framesInFlight, TimelineSync* timelines)
+		: Device(device)
+		, Queue(queue)
+		, Family(family)
+		, GraphicsFamily(graphicsFamily)
+		, Timelines(timelines)
+	{
+		framesInFlight = std::max(framesInFlight, 1u);
+
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType				= VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags				= VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolInfo.queueFamilyIndex	= Family;
+		if (vkCreateCommandPool(Device, &poolInfo, nullptr, &CommandPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create compute command pool!");
+		}
+
+		CommandBuffers.resize(framesInFlight);
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType					= VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool			= CommandPool;
+		allocInfo.level					= VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount	= framesInFlight;
+		if (vkAllocateCommandBuffers(Device, &allocInfo, CommandBuffers.data()) != VK_SUCCESS)
+		{
+			vkDestroyCommandPool(Device, CommandPool, nullptr);
+			throw std::runtime_error("failed to allocate compute command buffers!");
+		}
+
+		if (Timelines != nullptr)
+		{
+			SlotValues.assign(framesInFlight, 0);
+			return;
+		}
+
+		VkSemaphoreCreateInfo semaphoreInfo = {};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+		Fences.assign(framesInFlight, VK_NULL_HANDLE);
+		Finished.assign(framesInFlight, VK_NULL_HANDLE);
+		for (uint32_t i = 0; i < framesInFlight; i++)
+		{
+			if (vkCreateFence(Device, &fenceInfo, nullptr, &Fences[i]) != VK_SUCCESS ||
+				vkCreateSemaphore(Device, &semaphoreInfo, nullptr, &Finished[i]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create compute sync objects!");
+			}
+		}
+	}
+	//-----------------------------------------------------------------------------
+	ComputeQueue::~ComputeQueue()
+	{
+		WaitIdle();
+		for (VkFence fence : Fences)
+		{
+			vkDestroyFence(Device, fence, nullptr);
+		}
+		for (VkSemaphore semaphore : Finished)
+		{
+			vkDestroySemaphore(Device, semaphore, nullptr);
+		}
+		// Frees the command buffers along with it
+		vkDestroyCommandPool(Device, CommandPool, nullptr);
+	}
+	//-----------------------------------------------------------------------------
+	VkCommandBuffer ComputeQueue::Begin(uint32_t frameSlot)
+	{
+		FrameSlot = frameSlot % CommandBuffers.size();
+		if (Timelines != nullptr)
+		{
+			Timelines->Wait(QueueTimeline::Compute, SlotValues[FrameSlot]);
+		}
+		else
+		{
+			vkWaitForFences(Device, 1, &Fences[FrameSlot], VK_TRUE, std::numeric_limits<uint64_t>::max());
+		}
+
+		VkCommandBuffer commandBuffer = CommandBuffers[FrameSlot];
+		vkResetCommandBuffer(commandBuffer, 0);
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to begin compute command buffer!");
+		}
+		return commandBuffer;
+	}
+	//-----------------------------------------------------------------------------
+	const QueueHandoff ComputeQueue::Submit(const std::vector<QueueHandoff>& waits, VkPipelineStageFlags consumerStage)
+	{
+		VkCommandBuffer commandBuffer = CommandBuffers[FrameSlot];
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to record compute command buffer!");
+		}
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType				= VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount	= 1;
+		submitInfo.pCommandBuffers		= &commandBuffer;
+
+		QueueHandoff handoff;
+		handoff.Stage = consumerStage;
+		VkResult result;
+		if (Timelines != nullptr)
+		{
+			TimelineSubmit timelineSubmit;
+			for (const auto& wait : waits)
+			{
+				timelineSubmit.WaitSemaphore(wait.Semaphore, wait.Value, wait.Stage);
+			}
+			handoff.Semaphore	= Timelines->GetSemaphore(QueueTimeline::Compute);
+			handoff.Value		= Timelines->Advance(QueueTimeline::Compute);
+			timelineSubmit.SignalTimeline(*Timelines, QueueTimeline::Compute, handoff.Value);
+			timelineSubmit.Apply(submitInfo);
+			result = vkQueueSubmit(Queue, 1, &submitInfo, VK_NULL_HANDLE);
+			SlotValues[FrameSlot] = handoff.Value;
+		}
+		else
+		{
+			std::vector<VkSemaphore> waitSemaphores;
+			std::vector<VkPipelineStageFlags> waitStages;
+			for (const auto& wait : waits)
+			{
+				waitSemaphores.push_back(wait.Semaphore);
+				waitStages.push_back(wait.Stage);
+			}
+			handoff.Semaphore = Finished[FrameSlot];
+
+			submitInfo.waitSemaphoreCount	= static_cast<uint32_t>(waitSemaphores.size());
+			submitInfo.pWaitSemaphores		= waitSemaphores.data();
+			submitInfo.pWaitDstStageMask	= waitStages.data();
+			submitInfo.signalSemaphoreCount	= 1;
+			submitInfo.pSignalSemaphores	= &handoff.Semaphore;
+
+			vkResetFences(Device, 1, &Fences[FrameSlot]);
+			result = vkQueueSubmit(Queue, 1, &submitInfo, Fences[FrameSlot]);
+		}
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to submit compute command buffer!");
+		}
+		return handoff;
+	}
+	//-----------------------------------------------------------------------------
+	void ComputeQueue::WaitIdle() const
+	{
+		vkQueueWaitIdle(Queue);
+	}
+	//-----------------------------------------------------------------------------
+	void ComputeQueue::ReleaseBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, uint32_t srcFamily, uint32_t dstFamily, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess)
+	{
+		if (srcFamily == dstFamily)
+		{
+			return;
+		}
+		// The destination half of the barrier is ignored on the releasing queue
+		VkBufferMemoryBarrier barrier = MakeBufferBarrier(buffer, srcFamily, dstFamily, srcAccess, 0);
+		vkCmdPipelineBarrier(commandBuffer, srcStage, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+	//-----------------------------------------------------------------------------
+	void ComputeQueue::AcquireBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, uint32_t srcFamily, uint32_t dstFamily, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+	{
+		if (srcFamily == dstFamily)
+		{
+			return;
+		}
+		// And the source half on the acquiring one, the semaphore covers it.
+		// Its wait only blocks dstStage, the barrier has to start there too.
+		VkBufferMemoryBarrier barrier = MakeBufferBarrier(buffer, srcFamily, dstFamily, 0, dstAccess);
+		vkCmdPipelineBarrier(commandBuffer, dstStage, dstStage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+	//-----------------------------------------------------------------------------
+	void ComputeQueue::ReleaseImage(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t srcFamily, uint32_t dstFamily, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess)
+	{
+		if (srcFamily == dstFamily)
+		{
+			return;
+		}
+		VkImageMemoryBarrier barrier = MakeImageBarrier(image, oldLayout, newLayout, srcFamily, dstFamily, srcAccess, 0);
+		vkCmdPipelineBarrier(commandBuffer, srcStage, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+	//-----------------------------------------------------------------------------
+	void ComputeQueue::AcquireImage(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t srcFamily, uint32_t dstFamily, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+	{
+		if (srcFamily == dstFamily)
+		{
+			return;
+		}
+		VkImageMemoryBarrier barrier = MakeImageBarrier(image, oldLayout, newLayout, srcFamily, dstFamily, 0, dstAccess);
+		vkCmdPipelineBarrier(commandBuffer, dstStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+}
+//-----------------------------------------------------------------------------
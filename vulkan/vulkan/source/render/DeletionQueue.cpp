@@ -0,0 +1,126 @@
+//-----------------------------------------------------------------------------
+#include "render/DeletionQueue.h"
+#include <algorithm>
+#include <limits>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	DeletionQueue::DeletionQueue(VkDevice device, uint32_t framesInFlight)
+		: Device(device)
+		, SubmittedFrames(std::max(framesInFlight, 1u), 0)
+	{
+	}
+	//-----------------------------------------------------------------------------
+	DeletionQueue::~DeletionQueue()
+	{
+		Flush();
+	}
+	//-----------------------------------------------------------------------------
+	void DeletionQueue::Retire(DestroyFunction destroy)
+	{
+		std::lock_guard<std::mutex> lock(Lock);
+		Entries.push_back({ Frame, std::move(destroy) });
+	}
+	//-----------------------------------------------------------------------------
+	void DeletionQueue::RetireBuffer(VkBuffer buffer)
+	{
+		VkDevice device = Device;
+		Retire([device, buffer]() { vkDestroyBuffer(device, buffer, nullptr); });
+	}
+	//-----------------------------------------------------------------------------
+	void DeletionQueue::RetireImage(VkImage image)
+	{
+		VkDevice device = Device;
+		Retire([device, image]() { vkDestroyImage(device, image, nullptr); });
+	}
+	//-----------------------------------------------------------------------------
+	void DeletionQueue::RetireImageView(VkImageView view)
+	{
+		VkDevice device = Device;
+		Retire([device, view]() { vkDestroyImageView(device, view, nullptr); });
+	}
+	//-----------------------------------------------------------------------------
+	void DeletionQueue::RetirePipeline(VkPipeline pipeline)
+	{
+		VkDevice device = Device;
+		Retire([device, pipeline]() { vkDestroyPipeline(device, pipeline, nullptr); });
+	}
+	//-----------------------------------------------------------------------------
+	void DeletionQueue::RetireFramebuffer(VkFramebuffer framebuffer)
+	{
+		VkDevice device = Device;
+		Retire([device, framebuffer]() { vkDestroyFramebuffer(device, framebuffer, nullptr); });
+	}
+	//-----------------------------------------------------------------------------
+	void DeletionQueue::RetireRenderPass(VkRenderPass renderPass)
+	{
+		VkDevice device = Device;
+		Retire([device, renderPass]() { vkDestroyRenderPass(device, renderPass, nullptr); });
+	}
+	//-----------------------------------------------------------------------------
+	void DeletionQueue::RetireSwapchain(VkSwapchainKHR swapchain)
+	{
+		VkDevice device = Device;
+		Retire([device, swapchain]() { vkDestroySwapchainKHR(device, swapchain, nullptr); });
+	}
+	//-----------------------------------------------------------------------------
+	void DeletionQueue::BeginFrame(uint32_t frameSlot)
+	{
+		uint64_t completed;
+		{
+			std::lock_guard<std::mutex> lock(Lock);
+			completed = SubmittedFrames[frameSlot % SubmittedFrames.size()];
+		}
+		Collect(completed);
+	}
+	//-----------------------------------------------------------------------------
+	void DeletionQueue::EndFrame(uint32_t frameSlot)
+	{
+		std::lock_guard<std::mutex> lock(Lock);
+		SubmittedFrames[frameSlot % SubmittedFrames.size()] = Frame++;
+	}
+	//-----------------------------------------------------------------------------
+	void DeletionQueue::Flush()
+	{
+		// Until it stays empty, destroy functions may retire more
+		for (;;)
+		{
+			{
+				std::lock_guard<std::mutex> lock(Lock);
+				if (Entries.empty())
+				{
+					return;
+				}
+			}
+			Collect(std::numeric_limits<uint64_t>::max());
+		}
+	}
+	//-----------------------------------------------------------------------------
+	const DeletionQueueStats DeletionQueue::GetStats() const
+	{
+		std::lock_guard<std::mutex> lock(Lock);
+		DeletionQueueStats stats;
+		stats.Pending	= static_cast<uint32_t>(Entries.size());
+		stats.Destroyed	= Destroyed;
+		return stats;
+	}
+	//-----------------------------------------------------------------------------
+	void DeletionQueue::Collect(uint64_t frame)
+	{
+		std::vector<DestroyFunction> expired;
+		{
+			std::lock_guard<std::mutex> lock(Lock);
+			while (!Entries.empty() && Entries.front().Frame <= frame)
+			{
+				expired.push_back(std::move(Entries.front().Destroy));
+				Entries.pop_front();
+			}
+			Destroyed += expired.size();
+		}
+		for (const auto& destroy : expired)
+		{
+			destroy();
+		}
+	}
+}
+//-----------------------------------------------------------------------------
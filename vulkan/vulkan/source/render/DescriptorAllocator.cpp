@@ -0,0 +1,288 @@
+//-----------------------------------------------------------------------------
+#include "render/DescriptorAllocator.h"
+#include "render/Hash.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	DescriptorAllocator::DescriptorAllocator(VkDevice device, uint32_t initialSetsPerPool, uint32_t maxSetsPerPool)
+		: Device(device)
+		, SetsPerPool(initialSetsPerPool)
+		, MaxSetsPerPool(maxSetsPerPool)
+	{
+	}
+	//-----------------------------------------------------------------------------
+	DescriptorAllocator::~DescriptorAllocator()
+	{
+		for (auto pool : UsedPools)
+		{
+			vkDestroyDescriptorPool(Device, pool, nullptr);
+		}
+		for (auto pool : FreePools)
+		{
+			vkDestroyDescriptorPool(Device, pool, nullptr);
+		}
+	}
+	//-----------------------------------------------------------------------------
+	void DescriptorAllocator::RegisterLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+	{
+		for (const auto& binding : bindings)
+		{
+			DescriptorTotals[binding.descriptorType] += binding.descriptorCount;
+		}
+		LayoutCount++;
+	}
+	//-----------------------------------------------------------------------------
+	const std::vector<PoolSizeRatio> DescriptorAllocator::GetRatios() const
+	{
+		std::vector<PoolSizeRatio> ratios;
+		for (const auto& total : DescriptorTotals)
+		{
+			ratios.push_back({ total.first, static_cast<float>(total.second) / static_cast<float>(std::max(1u, LayoutCount)) });
+		}
+
+		if (ratios.empty())
+		{
+			// Nothing registered yet, a generic mix
+			ratios = {
+				{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f },
+				{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2.0f },
+				{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0.5f }
+			};
+		}
+		return ratios;
+	}
+	//-----------------------------------------------------------------------------
+	VkDescriptorSet DescriptorAllocator::Allocate(VkDescriptorSetLayout layout)
+	{
+		if (CurrentPool == VK_NULL_HANDLE)
+		{
+			CurrentPool = GrabPool();
+			UsedPools.push_back(CurrentPool);
+		}
+
+		VkDescriptorSetAllocateInfo allocInfo	= {};
+		allocInfo.sType							= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool				= CurrentPool;
+		allocInfo.descriptorSetCount			= 1;
+		allocInfo.pSetLayouts					= &layout;
+
+		VkDescriptorSet set = VK_NULL_HANDLE;
+		VkResult result = vkAllocateDescriptorSets(Device, &allocInfo, &set);
+		if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+		{
+			// Current pool is full, it stays in UsedPools until the next Reset()
+			CurrentPool = GrabPool();
+			UsedPools.push_back(CurrentPool);
+			allocInfo.descriptorPool = CurrentPool;
+			result = vkAllocateDescriptorSets(Device, &allocInfo, &set);
+		}
+
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to allocate descriptor set!");
+		}
+		Stats.SetsAllocated++;
+		return set;
+	}
+	//-----------------------------------------------------------------------------
+	void DescriptorAllocator::Reset()
+	{
+		for (auto pool : UsedPools)
+		{
+			vkResetDescriptorPool(Device, pool, 0);
+			FreePools.push_back(pool);
+			Stats.PoolResets++;
+		}
+		UsedPools.clear();
+		CurrentPool = VK_NULL_HANDLE;
+		Stats.SetsAllocated = 0;
+	}
+	//-----------------------------------------------------------------------------
+	VkDescriptorPool DescriptorAllocator::CreatePool(uint32_t setCount)
+	{
+		std::vector<VkDescriptorPoolSize> poolSizes;
+		for (const auto& ratio : GetRatios())
+		{
+			uint32_t count = static_cast<uint32_t>(std::ceil(ratio.Ratio * static_cast<float>(setCount)));
+			poolSizes.push_back({ ratio.Type, std::max(1u, count) });
+		}
+
+		VkDescriptorPoolCreateInfo poolInfo	= {};
+		poolInfo.sType						= VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.maxSets					= setCount;
+		poolInfo.poolSizeCount				= static_cast<uint32_t>(poolSizes.size());
+		poolInfo.pPoolSizes					= poolSizes.data();
+
+		VkDescriptorPool pool;
+		if (vkCreateDescriptorPool(Device, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create descriptor pool!");
+		}
+		Stats.Pools++;
+		return pool;
+	}
+	//-----------------------------------------------------------------------------
+	VkDescriptorPool DescriptorAllocator::GrabPool()
+	{
+		if (!FreePools.empty())
+		{
+			VkDescriptorPool pool = FreePools.back();
+			FreePools.pop_back();
+			return pool;
+		}
+
+		// Each new pool is bigger, a busy frame ends up needing few of them
+		VkDescriptorPool pool = CreatePool(SetsPerPool);
+		SetsPerPool = std::min(MaxSetsPerPool, SetsPerPool + SetsPerPool / 2);
+		return pool;
+	}
+	//-----------------------------------------------------------------------------
+	DescriptorBindings& DescriptorBindings::Buffer(uint32_t binding, VkDescriptorType type, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+	{
+		Entry entry			= {};
+		entry.Binding		= binding;
+		entry.Type			= type;
+		entry.BufferInfo	= { buffer, offset, range };
+		entry.IsImage		= false;
+		Entries.push_back(entry);
+		return *this;
+	}
+	//-----------------------------------------------------------------------------
+	DescriptorBindings& DescriptorBindings::Image(uint32_t binding, VkDescriptorType type, VkImageView view, VkSampler sampler, VkImageLayout layout)
+	{
+		Entry entry			= {};
+		entry.Binding		= binding;
+		entry.Type			= type;
+		entry.ImageInfo		= { sampler, view, layout };
+		entry.IsImage		= true;
+		Entries.push_back(entry);
+		return *this;
+	}
+	//-----------------------------------------------------------------------------
+	const size_t DescriptorBindings::Hash() const
+	{
+		size_t seed = Entries.size();
+		for (const auto& entry : Entries)
+		{
+			HashCombine(seed, entry.Binding);
+			HashCombine(seed, static_cast<size_t>(entry.Type));
+			if (entry.IsImage)
+			{
+				HashCombine(seed, HashHandle(entry.ImageInfo.imageView));
+				HashCombine(seed, HashHandle(entry.ImageInfo.sampler));
+				HashCombine(seed, static_cast<size_t>(entry.ImageInfo.imageLayout));
+			}
+			else
+			{
+				HashCombine(seed, HashHandle(entry.BufferInfo.buffer));
+				HashCombine(seed, std::hash<uint64_t>()(entry.BufferInfo.offset));
+				HashCombine(seed, std::hash<uint64_t>()(entry.BufferInfo.range));
+			}
+		}
+		return seed;
+	}
+	//-----------------------------------------------------------------------------
+	bool DescriptorBindings::operator==(const DescriptorBindings& other) const
+	{
+		if (Entries.size() != other.Entries.size())
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < Entries.size(); i++)
+		{
+			const Entry& a = Entries[i];
+			const Entry& b = other.Entries[i];
+			if (a.Binding != b.Binding || a.Type != b.Type || a.IsImage != b.IsImage)
+			{
+				return false;
+			}
+			if (a.IsImage)
+			{
+				if (a.ImageInfo.imageView != b.ImageInfo.imageView || a.ImageInfo.sampler != b.ImageInfo.sampler || a.ImageInfo.imageLayout != b.ImageInfo.imageLayout)
+				{
+					return false;
+				}
+			}
+			else if (a.BufferInfo.buffer != b.BufferInfo.buffer || a.BufferInfo.offset != b.BufferInfo.offset || a.BufferInfo.range != b.BufferInfo.range)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	//-----------------------------------------------------------------------------
+	size_t DescriptorSetCache::KeyHash::operator()(const Key& key) const
+	{
+		size_t seed = key.Bindings.Hash();
+		HashCombine(seed, HashHandle(key.Layout));
+		return seed;
+	}
+	//-----------------------------------------------------------------------------
+	DescriptorSetCache::DescriptorSetCache(VkDevice device, DescriptorAllocator& allocator)
+		: Device(device)
+		, Allocator(allocator)
+	{
+	}
+	//-----------------------------------------------------------------------------
+	VkDescriptorSet DescriptorSetCache::Get(VkDescriptorSetLayout layout, const DescriptorBindings& bindings)
+	{
+		Key key = { layout, bindings };
+		auto found = Sets.find(key);
+		if (found != Sets.end())
+		{
+			Stats.Hits++;
+			return found->second;
+		}
+		Stats.Misses++;
+
+		VkDescriptorSet set = Allocator.Allocate(layout);
+
+		std::vector<VkWriteDescriptorSet> writes;
+		writes.reserve(bindings.Entries.size());
+		for (const auto& entry : bindings.Entries)
+		{
+			VkWriteDescriptorSet write	= {};
+			write.sType					= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet				= set;
+			write.dstBinding			= entry.Binding;
+			write.dstArrayElement		= 0;
+			write.descriptorType		= entry.Type;
+			write.descriptorCount		= 1;
+			if (entry.IsImage)
+			{
+				write.pImageInfo = &entry.ImageInfo;
+			}
+			else
+			{
+				write.pBufferInfo = &entry.BufferInfo;
+			}
+			writes.push_back(write);
+		}
+		vkUpdateDescriptorSets(Device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+		Sets.emplace(key, set);
+		return set;
+	}
+	//-----------------------------------------------------------------------------
+	void DescriptorSetCache::BeginFrame()
+	{
+		if (Allocator.HasGrown())
+		{
+			Sets.clear();
+			Allocator.Reset();
+		}
+	}
+	//-----------------------------------------------------------------------------
+	void DescriptorSetCache::Clear()
+	{
+		Sets.clear();
+		Allocator.Reset();
+		Stats = DescriptorCacheStats();
+	}
+}
+//-----------------------------------------------------------------------------
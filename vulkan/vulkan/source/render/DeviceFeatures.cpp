@@ -0,0 +1,46 @@
+//-----------------------------------------------------------------------------
+#include "render/DeviceFeatures.h"
+#include <cstring>
+#include <vector>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	const bool QueryPromotedFeatures(VkPhysicalDevice physicalDevice, uint32_t instanceApiVersion, const char* extensionName, void* features, bool& needsExtension)
+	{
+		// vkGetPhysicalDeviceFeatures2 is 1.1 core
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		if (instanceApiVersion < VK_API_VERSION_1_1 || properties.apiVersion < VK_API_VERSION_1_1)
+		{
+			return false;
+		}
+
+		uint32_t extensionCount;
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+		bool hasExtension = false;
+		for (const auto& extension : availableExtensions)
+		{
+			hasExtension = hasExtension || strcmp(extension.extensionName, extensionName) == 0;
+		}
+
+		bool hasCore = false;
+#ifdef VK_API_VERSION_1_2
+		hasCore = instanceApiVersion >= VK_API_VERSION_1_2 && properties.apiVersion >= VK_API_VERSION_1_2;
+#endif
+		if (!hasExtension && !hasCore)
+		{
+			return false;
+		}
+		needsExtension = !hasCore;
+
+		VkPhysicalDeviceFeatures2 features2 = {};
+		features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features2.pNext = features;
+		vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+		return true;
+	}
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,486 @@
+//-----------------------------------------------------------------------------
+#include "render/DeviceSelector.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	static const VkDeviceSize BenchmarkBytes = 64 * 1024 * 1024;
+	//-----------------------------------------------------------------------------
+	static const char* GetTypeName(VkPhysicalDeviceType type)
+	{
+		switch (type)
+		{
+		case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:		return "discrete";
+		case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:	return "integrated";
+		case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:		return "virtual";
+		case VK_PHYSICAL_DEVICE_TYPE_CPU:				return "cpu";
+		default:										return "other";
+		}
+	}
+	//-----------------------------------------------------------------------------
+	static const std::string ToHex(const uint8_t* bytes, size_t count)
+	{
+		std::string hex;
+		char digits[3];
+		for (size_t i = 0; i < count; i++)
+		{
+			snprintf(digits, sizeof(digits), "%02x", bytes[i]);
+			hex += digits;
+		}
+		return hex;
+	}
+	//-----------------------------------------------------------------------------
+	static const uint32_t FindFamily(const std::vector<VkQueueFamilyProperties>& families, VkQueueFlags required, VkQueueFlags avoided)
+	{
+		for (uint32_t i = 0; i < families.size(); i++)
+		{
+			if (families[i].queueCount > 0 && families[i].timestampValidBits > 0 &&
+				(families[i].queueFlags & required) == required && (families[i].queueFlags & avoided) == 0)
+			{
+				return i;
+			}
+		}
+		return std::numeric_limits<uint32_t>::max();
+	}
+	//-----------------------------------------------------------------------------
+	DeviceSelector::DeviceSelector(VkInstance instance, const DeviceSelectorDesc& desc, DeviceSuitability isSuitable)
+		: Desc(desc)
+	{
+		uint32_t deviceCount = 0;
+		vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+		if (deviceCount == 0)
+		{
+			throw std::runtime_error("failed to find GPUs with Vulkan Support");
+		}
+		std::vector<VkPhysicalDevice> devices(deviceCount);
+		vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+
+		std::vector<std::pair<std::string, DeviceBenchmark>> cache;
+		if (Desc.Benchmark)
+		{
+			LoadCache(cache);
+		}
+		bool cacheChanged = false;
+
+		for (uint32_t i = 0; i < deviceCount; i++)
+		{
+			DeviceCandidate candidate;
+			candidate.Device	= devices[i];
+			candidate.Index		= i;
+			Describe(candidate);
+			candidate.Suitable	= isSuitable(devices[i]);
+
+			if (Desc.Benchmark && candidate.Suitable)
+			{
+				auto cached = std::find_if(cache.begin(), cache.end(),
+					[&candidate](const std::pair<std::string, DeviceBenchmark>& entry) { return entry.first == candidate.Key; });
+				if (cached != cache.end())
+				{
+					candidate.Benchmark			= cached->second;
+					candidate.Benchmark.Cached	= true;
+				}
+				else
+				{
+					candidate.Benchmark = RunBenchmark(devices[i]);
+					cache.push_back({ candidate.Key, candidate.Benchmark });
+					cacheChanged = true;
+				}
+			}
+			candidate.Score = candidate.Suitable ? Score(devices[i], candidate) : 0;
+			Candidates.push_back(candidate);
+		}
+
+		if (cacheChanged)
+		{
+			SaveCache(cache);
+		}
+	}
+	//-----------------------------------------------------------------------------
+	const DeviceCandidate* DeviceSelector::FindOverride() const
+	{
+		if (Desc.Override.empty())
+		{
+			return nullptr;
+		}
+		bool isIndex = std::all_of(Desc.Override.begin(), Desc.Override.end(), [](char c) { return isdigit(static_cast<unsigned char>(c)) != 0; });
+		for (const auto& candidate : Candidates)
+		{
+			bool matches = isIndex ? candidate.Index == strtoul(Desc.Override.c_str(), nullptr, 10) : candidate.Name.find(Desc.Override) != std::string::npos;
+			if (matches && candidate.Suitable)
+			{
+				return &candidate;
+			}
+		}
+		return nullptr;
+	}
+	//-----------------------------------------------------------------------------
+	const DeviceCandidate& DeviceSelector::Select() const
+	{
+		const DeviceCandidate* overridden = FindOverride();
+		if (overridden != nullptr)
+		{
+			return *overridden;
+		}
+
+		const DeviceCandidate* best = nullptr;
+		for (const auto& candidate : Candidates)
+		{
+			if (candidate.Suitable && (best == nullptr || candidate.Score > best->Score))
+			{
+				best = &candidate;
+			}
+		}
+		if (best == nullptr)
+		{
+			throw std::runtime_error("failed to find a suitable GPU!");
+		}
+		return *best;
+	}
+	//-----------------------------------------------------------------------------
+	void DeviceSelector::Print(std::ostream& out) const
+	{
+		const DeviceCandidate& selected = Select();
+		if (!Desc.Override.empty() && FindOverride() == nullptr)
+		{
+			out << "Device: no suitable device matches " << Desc.Override << ", picking by score" << std::endl;
+		}
+		for (const auto& candidate : Candidates)
+		{
+			out << (&candidate == &selected ? "* " : "  ") << "[" << candidate.Index << "] " << candidate.Name
+				<< " (" << GetTypeName(candidate.Type) << ", " << candidate.DeviceLocalBytes / (1024 * 1024) << " MB)";
+			if (!candidate.Suitable)
+			{
+				out << " unsuitable" << std::endl;
+				continue;
+			}
+			out << " score " << candidate.Score;
+			if (candidate.Benchmark.FillBandwidth > 0.0f || candidate.Benchmark.CopyBandwidth > 0.0f)
+			{
+				out << ", fill " << candidate.Benchmark.FillBandwidth << " GB/s, copy " << candidate.Benchmark.CopyBandwidth << " GB/s"
+					<< (candidate.Benchmark.Cached ? " (cached)" : "");
+			}
+			out << std::endl;
+		}
+	}
+	//-----------------------------------------------------------------------------
+	const int64_t DeviceSelector::Score(VkPhysicalDevice device, const DeviceCandidate& candidate)
+	{
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(device, &properties);
+		VkPhysicalDeviceFeatures features;
+		vkGetPhysicalDeviceFeatures(device, &features);
+
+		// Type dominates: a small discrete GPU still beats a big integrated
+		// one, and anything beats rendering on the CPU
+		int64_t tier = 0;
+		switch (candidate.Type)
+		{
+		case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:		tier = 4;	break;
+		case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:	tier = 3;	break;
+		case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:		tier = 2;	break;
+		case VK_PHYSICAL_DEVICE_TYPE_CPU:				tier = 0;	break;
+		default:										tier = 1;	break;
+		}
+
+		// Everything below only ranks devices of one type
+		int64_t score = 0;
+
+		// 1 per MB up to 32 GB. Integrated GPUs report shared system memory,
+		// the type above already keeps them behind.
+		score += static_cast<int64_t>(std::min<VkDeviceSize>(candidate.DeviceLocalBytes / (1024 * 1024), 32 * 1024));
+
+		score += candidate.AsyncCompute ? 2000 : 0;
+		score += candidate.DedicatedTransfer ? 1000 : 0;
+
+		// Streamed textures are BCn, mips are sampled anisotropically
+		score += features.textureCompressionBC ? 4000 : 0;
+		score += features.samplerAnisotropy ? 1000 : 0;
+		score += features.multiDrawIndirect ? 500 : 0;
+		score += properties.apiVersion >= VK_API_VERSION_1_1 ? 1000 : 0;
+
+		score += properties.limits.maxImageDimension2D / 16;
+		score += properties.limits.maxComputeSharedMemorySize / 1024;
+		score += properties.limits.maxPerStageDescriptorSampledImages >= 65536 ? 500 : 0;
+
+		// 100 per GB/s
+		score += static_cast<int64_t>((candidate.Benchmark.FillBandwidth + candidate.Benchmark.CopyBandwidth) * 100.0f);
+
+		// Clamped below the gap between two types, so no amount of memory or
+		// bandwidth lifts a device into the next one
+		const int64_t tierGap = 1000000;
+		return tier * tierGap + std::max<int64_t>(0, std::min<int64_t>(score, tierGap - 1));
+	}
+	//-----------------------------------------------------------------------------
+	void DeviceSelector::Describe(DeviceCandidate& candidate) const
+	{
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(candidate.Device, &properties);
+		candidate.Name	= properties.deviceName;
+		candidate.Type	= properties.deviceType;
+
+		// deviceUUID is 1.1, the ids can collide between two identical cards.
+		// The driver version is part of both, an update re-runs the benchmark.
+		std::ostringstream key;
+		if (Desc.InstanceApiVersion >= VK_API_VERSION_1_1 && properties.apiVersion >= VK_API_VERSION_1_1)
+		{
+			VkPhysicalDeviceIDProperties id = {};
+			id.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+			VkPhysicalDeviceProperties2 properties2 = {};
+			properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+			properties2.pNext = &id;
+			vkGetPhysicalDeviceProperties2(candidate.Device, &properties2);
+			key << ToHex(id.deviceUUID, VK_UUID_SIZE);
+		}
+		else
+		{
+			key << std::hex << properties.vendorID << ":" << properties.deviceID;
+		}
+		key << std::hex << "-" << properties.driverVersion;
+		candidate.Key = key.str();
+
+		VkPhysicalDeviceMemoryProperties memory;
+		vkGetPhysicalDeviceMemoryProperties(candidate.Device, &memory);
+		for (uint32_t i = 0; i < memory.memoryHeapCount; i++)
+		{
+			if (memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+			{
+				candidate.DeviceLocalBytes = std::max(candidate.DeviceLocalBytes, memory.memoryHeaps[i].size);
+			}
+		}
+
+		uint32_t familyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(candidate.Device, &familyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> families(familyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(candidate.Device, &familyCount, families.data());
+		for (const auto& family : families)
+		{
+			bool graphics	= (family.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+			bool compute	= (family.queueFlags & VK_QUEUE_COMPUTE_BIT) != 0;
+			candidate.AsyncCompute		= candidate.AsyncCompute || (compute && !graphics);
+			candidate.DedicatedTransfer	= candidate.DedicatedTransfer || ((family.queueFlags & VK_QUEUE_TRANSFER_BIT) && !compute && !graphics);
+		}
+	}
+	//-----------------------------------------------------------------------------
+	const DeviceBenchmark DeviceSelector::RunBenchmark(VkPhysicalDevice physicalDevice)
+	{
+		DeviceBenchmark benchmark;
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		uint32_t familyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> families(familyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+
+		// Where the renderer would run them: async compute and a DMA queue
+		// when there are some
+		const uint32_t none = std::numeric_limits<uint32_t>::max();
+		uint32_t computeFamily = FindFamily(families, VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT);
+		if (computeFamily == none)
+		{
+			computeFamily = FindFamily(families, VK_QUEUE_COMPUTE_BIT, 0);
+		}
+		uint32_t transferFamily = FindFamily(families, VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+		if (transferFamily == none)
+		{
+			transferFamily = computeFamily;
+		}
+		if (computeFamily == none || properties.limits.timestampPeriod <= 0.0f)
+		{
+			return benchmark;
+		}
+
+		float queuePriority = 1.0f;
+		std::vector<VkDeviceQueueCreateInfo> queueInfos;
+		for (uint32_t family : { computeFamily, transferFamily })
+		{
+			if (!queueInfos.empty() && queueInfos[0].queueFamilyIndex == family)
+			{
+				continue;
+			}
+			VkDeviceQueueCreateInfo queueInfo = {};
+			queueInfo.sType				= VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+			queueInfo.queueFamilyIndex	= family;
+			queueInfo.queueCount		= 1;
+			queueInfo.pQueuePriorities	= &queuePriority;
+			queueInfos.push_back(queueInfo);
+		}
+
+		VkDeviceCreateInfo deviceInfo = {};
+		deviceInfo.sType					= VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		deviceInfo.queueCreateInfoCount		= static_cast<uint32_t>(queueInfos.size());
+		deviceInfo.pQueueCreateInfos		= queueInfos.data();
+		VkDevice device;
+		if (vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &device) != VK_SUCCESS)
+		{
+			return benchmark;
+		}
+
+		// Two device local buffers, filled then copied one into the other
+		VkBuffer buffers[2] = { VK_NULL_HANDLE, VK_NULL_HANDLE };
+		VkDeviceMemory memory[2] = { VK_NULL_HANDLE, VK_NULL_HANDLE };
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+		bool created = true;
+		for (uint32_t i = 0; i < 2 && created; i++)
+		{
+			VkBufferCreateInfo bufferInfo = {};
+			bufferInfo.sType		= VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferInfo.size			= BenchmarkBytes;
+			bufferInfo.usage		= VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+			bufferInfo.sharingMode	= VK_SHARING_MODE_EXCLUSIVE;
+			created = vkCreateBuffer(device, &bufferInfo, nullptr, &buffers[i]) == VK_SUCCESS;
+			if (!created)
+			{
+				break;
+			}
+
+			VkMemoryRequirements requirements;
+			vkGetBufferMemoryRequirements(device, buffers[i], &requirements);
+			uint32_t typeIndex = none;
+			for (uint32_t type = 0; type < memoryProperties.memoryTypeCount; type++)
+			{
+				bool allowed = (requirements.memoryTypeBits & (1u << type)) != 0;
+				if (allowed && (typeIndex == none || (memoryProperties.memoryTypes[type].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)))
+				{
+					typeIndex = type;
+					if (memoryProperties.memoryTypes[type].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+					{
+						break;
+					}
+				}
+			}
+
+			VkMemoryAllocateInfo allocInfo = {};
+			allocInfo.sType				= VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocInfo.allocationSize	= requirements.size;
+			allocInfo.memoryTypeIndex	= typeIndex;
+			created = typeIndex != none &&
+				vkAllocateMemory(device, &allocInfo, nullptr, &memory[i]) == VK_SUCCESS &&
+				vkBindBufferMemory(device, buffers[i], memory[i], 0) == VK_SUCCESS;
+		}
+
+		// Seconds between two timestamps of a one-off submission on family
+		auto timeOnFamily = [&](uint32_t family, const std::function<void(VkCommandBuffer)>& record) -> double
+		{
+			VkQueue queue;
+			vkGetDeviceQueue(device, family, 0, &queue);
+
+			VkCommandPoolCreateInfo poolInfo = {};
+			poolInfo.sType				= VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.queueFamilyIndex	= family;
+			VkCommandPool pool;
+			if (vkCreateCommandPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+			{
+				return 0.0;
+			}
+			VkQueryPoolCreateInfo queryInfo = {};
+			queryInfo.sType			= VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			queryInfo.queryType		= VK_QUERY_TYPE_TIMESTAMP;
+			queryInfo.queryCount	= 2;
+			VkQueryPool queries;
+			if (vkCreateQueryPool(device, &queryInfo, nullptr, &queries) != VK_SUCCESS)
+			{
+				vkDestroyCommandPool(device, pool, nullptr);
+				return 0.0;
+			}
+
+			VkCommandBufferAllocateInfo allocInfo = {};
+			allocInfo.sType					= VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool			= pool;
+			allocInfo.level					= VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandBufferCount	= 1;
+			VkCommandBuffer commandBuffer;
+			vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
+
+			VkCommandBufferBeginInfo beginInfo = {};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			vkBeginCommandBuffer(commandBuffer, &beginInfo);
+			vkCmdResetQueryPool(commandBuffer, queries, 0, 2);
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queries, 0);
+			record(commandBuffer);
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queries, 1);
+			vkEndCommandBuffer(commandBuffer);
+
+			VkSubmitInfo submitInfo = {};
+			submitInfo.sType				= VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.commandBufferCount	= 1;
+			submitInfo.pCommandBuffers		= &commandBuffer;
+			double seconds = 0.0;
+			uint64_t timestamps[2];
+			if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) == VK_SUCCESS && vkQueueWaitIdle(queue) == VK_SUCCESS &&
+				vkGetQueryPoolResults(device, queries, 0, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) == VK_SUCCESS)
+			{
+				// Only the valid low bits count, they may wrap between the two
+				uint32_t validBits	= families[family].timestampValidBits;
+				uint64_t mask		= validBits >= 64 ? std::numeric_limits<uint64_t>::max() : (uint64_t(1) << validBits) - 1;
+				uint64_t ticks		= (timestamps[1] - timestamps[0]) & mask;
+				seconds = ticks * static_cast<double>(properties.limits.timestampPeriod) * 1e-9;
+			}
+			vkDestroyQueryPool(device, queries, nullptr);
+			vkDestroyCommandPool(device, pool, nullptr);
+			return seconds;
+		};
+
+		if (created)
+		{
+			// The first pass also pages the memory in, keep the second
+			double fillSeconds = 0.0;
+			for (uint32_t pass = 0; pass < 2; pass++)
+			{
+				fillSeconds = timeOnFamily(computeFamily, [&](VkCommandBuffer commandBuffer)
+				{
+					vkCmdFillBuffer(commandBuffer, buffers[0], 0, VK_WHOLE_SIZE, 0x3f800000);
+				});
+			}
+			double copySeconds = timeOnFamily(transferFamily, [&](VkCommandBuffer commandBuffer)
+			{
+				VkBufferCopy region = {};
+				region.size = BenchmarkBytes;
+				vkCmdCopyBuffer(commandBuffer, buffers[0], buffers[1], 1, &region);
+			});
+			benchmark.FillBandwidth = fillSeconds > 0.0 ? static_cast<float>(BenchmarkBytes / fillSeconds * 1e-9) : 0.0f;
+			// Read and written
+			benchmark.CopyBandwidth = copySeconds > 0.0 ? static_cast<float>(2 * BenchmarkBytes / copySeconds * 1e-9) : 0.0f;
+		}
+
+		for (uint32_t i = 0; i < 2; i++)
+		{
+			vkDestroyBuffer(device, buffers[i], nullptr);
+			vkFreeMemory(device, memory[i], nullptr);
+		}
+		vkDestroyDevice(device, nullptr);
+		return benchmark;
+	}
+	//-----------------------------------------------------------------------------
+	void DeviceSelector::LoadCache(std::vector<std::pair<std::string, DeviceBenchmark>>& cache) const
+	{
+		// One "key fill copy" line per device
+		std::ifstream file(Desc.CachePath);
+		std::string key;
+		DeviceBenchmark benchmark;
+		while (file >> key >> benchmark.FillBandwidth >> benchmark.CopyBandwidth)
+		{
+			cache.push_back({ key, benchmark });
+		}
+	}
+	//-----------------------------------------------------------------------------
+	void DeviceSelector::SaveCache(const std::vector<std::pair<std::string, DeviceBenchmark>>& cache) const
+	{
+		// A cache that can't be written only costs another benchmark
+		std::ofstream file(Desc.CachePath, std::ios::trunc);
+		for (const auto& entry : cache)
+		{
+			file << entry.first << " " << entry.second.FillBandwidth << " " << entry.second.CopyBandwidth << "\n";
+		}
+	}
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,225 @@
+//-----------------------------------------------------------------------------
+#include "render/DrawQueue.h"
+#include <algorithm>
+#include <stdexcept>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	uint32_t DrawKey::QuantizeDepth(float viewDepth, float nearPlane, float farPlane, bool invert)
+	{
+		const uint32_t maxDepth = (1u << DepthBits) - 1;
+		float normalized = (viewDepth - nearPlane) / (farPlane - nearPlane);
+		normalized = std::min(1.0f, std::max(0.0f, normalized));
+
+		uint32_t depth = static_cast<uint32_t>(normalized * static_cast<float>(maxDepth));
+		return invert ? maxDepth - depth : depth;
+	}
+	//-----------------------------------------------------------------------------
+	const uint32_t DrawQueue::RegisterPipeline(const PipelineBinding& pipeline)
+	{
+		if (Pipelines.size() >= (1u << DrawKey::PipelineBits))
+		{
+			throw std::runtime_error("too many pipelines for the draw key!");
+		}
+		Pipelines.push_back(pipeline);
+		return static_cast<uint32_t>(Pipelines.size() - 1);
+	}
+	//-----------------------------------------------------------------------------
+	const uint32_t DrawQueue::RegisterDescriptorSet(VkDescriptorSet set)
+	{
+		if (DescriptorSets.size() >= (1u << DrawKey::SetBits))
+		{
+			throw std::runtime_error("too many descriptor sets for the draw key!");
+		}
+		DescriptorSets.push_back(set);
+		return static_cast<uint32_t>(DescriptorSets.size() - 1);
+	}
+	//-----------------------------------------------------------------------------
+	const uint32_t DrawQueue::RegisterMesh(const MeshBinding& mesh)
+	{
+		if (Meshes.size() >= (1u << DrawKey::MeshBits))
+		{
+			throw std::runtime_error("too many meshes for the draw key!");
+		}
+		Meshes.push_back(mesh);
+		return static_cast<uint32_t>(Meshes.size() - 1);
+	}
+	//-----------------------------------------------------------------------------
+	void DrawQueue::Submit(const DrawItem& draw)
+	{
+		Submit(draw, nullptr, 0);
+	}
+	//-----------------------------------------------------------------------------
+	void DrawQueue::Submit(const DrawItem& draw, const void* pushConstants, uint32_t size)
+	{
+		DrawItem item = draw;
+		item.PushConstantOffset	= static_cast<uint32_t>(PushConstantData.size());
+		item.PushConstantSize	= size;
+		if (size > 0)
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(pushConstants);
+			PushConstantData.insert(PushConstantData.end(), bytes, bytes + size);
+		}
+
+		Order.push_back({ item.Key, static_cast<uint32_t>(Draws.size()) });
+		Draws.push_back(item);
+	}
+	//-----------------------------------------------------------------------------
+	// LSD radix sort, one byte per pass. All eight histograms are built in a
+	// single read of the keys, and a pass whose byte is the same for every key
+	// is skipped, which is most of them when only a few fields vary.
+	void DrawQueue::Sort()
+	{
+		const size_t count = Order.size();
+		if (count < 2)
+		{
+			return;
+		}
+
+		uint32_t histograms[8][256] = {};
+		for (const auto& entry : Order)
+		{
+			for (uint32_t byte = 0; byte < 8; byte++)
+			{
+				histograms[byte][(entry.Key >> (byte * 8)) & 0xff]++;
+			}
+		}
+
+		Scratch.resize(count);
+		for (uint32_t byte = 0; byte < 8; byte++)
+		{
+			uint32_t* histogram = histograms[byte];
+			if (histogram[(Order[0].Key >> (byte * 8)) & 0xff] == count)
+			{
+				continue;
+			}
+
+			uint32_t offset = 0;
+			for (uint32_t bucket = 0; bucket < 256; bucket++)
+			{
+				uint32_t bucketCount = histogram[bucket];
+				histogram[bucket] = offset;
+				offset += bucketCount;
+			}
+
+			for (const auto& entry : Order)
+			{
+				Scratch[histogram[(entry.Key >> (byte * 8)) & 0xff]++] = entry;
+			}
+			Order.swap(Scratch);
+		}
+	}
+	//-----------------------------------------------------------------------------
+	const DrawQueueStats DrawQueue::Record(VkCommandBuffer commandBuffer, uint32_t pass) const
+	{
+		DrawQueueStats stats;
+
+		uint32_t boundPipeline = ~0u;
+		uint32_t boundSet = ~0u;
+		VkPipelineLayout boundLayout = VK_NULL_HANDLE;
+		VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+		VkDeviceSize boundVertexOffset = 0;
+		VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+		VkDeviceSize boundIndexOffset = 0;
+		VkIndexType boundIndexType = VK_INDEX_TYPE_UINT16;
+
+		for (const auto& entry : Order)
+		{
+			if (pass != ~0u && DrawKey::GetPass(entry.Key) != pass)
+			{
+				continue;
+			}
+			const DrawItem& draw = Draws[entry.Index];
+
+			uint32_t pipelineId = DrawKey::GetPipeline(entry.Key);
+			const PipelineBinding& pipeline = Pipelines.at(pipelineId);
+			if (pipelineId != boundPipeline)
+			{
+				vkCmdBindPipeline(commandBuffer, pipeline.BindPoint, pipeline.Pipeline);
+				boundPipeline = pipelineId;
+				stats.PipelineBinds++;
+
+				// Sets bound against another layout may have been disturbed
+				if (pipeline.Layout != boundLayout)
+				{
+					boundLayout = pipeline.Layout;
+					boundSet = ~0u;
+				}
+			}
+			else
+			{
+				stats.SkippedBinds++;
+			}
+
+			uint32_t setId = DrawKey::GetSet(entry.Key);
+			if (setId != 0)
+			{
+				if (setId != boundSet)
+				{
+					VkDescriptorSet set = DescriptorSets.at(setId);
+					vkCmdBindDescriptorSets(commandBuffer, pipeline.BindPoint, pipeline.Layout, 0, 1, &set, 0, nullptr);
+					boundSet = setId;
+					stats.DescriptorSetBinds++;
+				}
+				else
+				{
+					stats.SkippedBinds++;
+				}
+			}
+
+			// Compared on the buffers rather than the mesh id: meshes sharing a
+			// buffer only differ by their draw offsets
+			const MeshBinding& mesh = Meshes.at(DrawKey::GetMesh(entry.Key));
+			if (mesh.VertexBuffer != boundVertexBuffer || mesh.VertexOffset != boundVertexOffset)
+			{
+				vkCmdBindVertexBuffers(commandBuffer, 0, 1, &mesh.VertexBuffer, &mesh.VertexOffset);
+				boundVertexBuffer = mesh.VertexBuffer;
+				boundVertexOffset = mesh.VertexOffset;
+				stats.VertexBufferBinds++;
+			}
+			else
+			{
+				stats.SkippedBinds++;
+			}
+
+			if (mesh.IndexBuffer != boundIndexBuffer || mesh.IndexOffset != boundIndexOffset || mesh.IndexType != boundIndexType)
+			{
+				vkCmdBindIndexBuffer(commandBuffer, mesh.IndexBuffer, mesh.IndexOffset, mesh.IndexType);
+				boundIndexBuffer = mesh.IndexBuffer;
+				boundIndexOffset = mesh.IndexOffset;
+				boundIndexType = mesh.IndexType;
+				stats.IndexBufferBinds++;
+			}
+			else
+			{
+				stats.SkippedBinds++;
+			}
+
+			if (draw.PushConstantSize > 0)
+			{
+				vkCmdPushConstants(commandBuffer, pipeline.Layout, pipeline.PushConstantStages, 0, draw.PushConstantSize, &PushConstantData[draw.PushConstantOffset]);
+				stats.PushConstantUpdates++;
+			}
+
+			vkCmdDrawIndexed(commandBuffer, draw.IndexCount, draw.InstanceCount, draw.FirstIndex, draw.VertexOffset, draw.FirstInstance);
+			stats.Draws++;
+		}
+		return stats;
+	}
+	//-----------------------------------------------------------------------------
+	void DrawQueue::Clear()
+	{
+		Draws.clear();
+		PushConstantData.clear();
+		Order.clear();
+	}
+	//-----------------------------------------------------------------------------
+	void DrawQueue::Reset()
+	{
+		Clear();
+		Pipelines.clear();
+		DescriptorSets.assign(1, VK_NULL_HANDLE);
+		Meshes.clear();
+	}
+}
+//-----------------------------------------------------------------------------
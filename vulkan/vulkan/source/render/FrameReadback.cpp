@@ -0,0 +1,160 @@
+//-----------------------------------------------------------------------------
+#include "render/FrameReadback.h"
+#include <algorithm>
+#include <stdexcept>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	static const bool IsBgra(VkFormat format)
+	{
+		return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+	}
+	//-----------------------------------------------------------------------------
+	FrameReadback::FrameReadback(VkDevice device, const MemoryTypeSelector& memoryTypes, uint32_t framesInFlight)
+		: Device(device)
+		, MemoryTypes(memoryTypes)
+		, Slots(std::max(framesInFlight, 1u))
+	{
+	}
+	//-----------------------------------------------------------------------------
+	FrameReadback::~FrameReadback()
+	{
+		for (auto& slot : Slots)
+		{
+			Release(slot);
+		}
+	}
+	//-----------------------------------------------------------------------------
+	const bool FrameReadback::IsFormatSupported(VkFormat format)
+	{
+		return IsBgra(format) || format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB;
+	}
+	//-----------------------------------------------------------------------------
+	void FrameReadback::Record(VkCommandBuffer commandBuffer, uint32_t frameSlot, VkImage image, VkFormat format, VkExtent2D extent, uint64_t frame)
+	{
+		if (!IsFormatSupported(format))
+		{
+			throw std::runtime_error("unsupported readback format!");
+		}
+
+		// The slot's previous copy is done, its buffer can be replaced
+		Slot& slot = Slots[frameSlot % Slots.size()];
+		VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+		if (slot.Size < size)
+		{
+			Release(slot);
+			Allocate(slot, size);
+		}
+
+		VkBufferImageCopy region = {};
+		region.bufferOffset						= 0;
+		// Tightly packed
+		region.bufferRowLength					= 0;
+		region.bufferImageHeight				= 0;
+		region.imageSubresource.aspectMask		= VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel		= 0;
+		region.imageSubresource.baseArrayLayer	= 0;
+		region.imageSubresource.layerCount		= 1;
+		region.imageOffset						= { 0, 0, 0 };
+		region.imageExtent						= { extent.width, extent.height, 1 };
+		vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.Buffer, 1, &region);
+
+		// Visible to the host once the fence signals
+		VkBufferMemoryBarrier barrier = {};
+		barrier.sType				= VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask		= VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask		= VK_ACCESS_HOST_READ_BIT;
+		barrier.srcQueueFamilyIndex	= VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex	= VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer				= slot.Buffer;
+		barrier.offset				= 0;
+		barrier.size				= size;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+		slot.Format		= format;
+		slot.Extent		= extent;
+		slot.Frame		= frame;
+		slot.Pending	= true;
+		Stats.Recorded++;
+	}
+	//-----------------------------------------------------------------------------
+	const bool FrameReadback::Collect(uint32_t frameSlot, RgbaImage& image, uint64_t& frame)
+	{
+		Slot& slot = Slots[frameSlot % Slots.size()];
+		if (!slot.Pending)
+		{
+			return false;
+		}
+		slot.Pending = false;
+
+		if (!slot.Coherent)
+		{
+			VkMappedMemoryRange range = {};
+			range.sType		= VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+			range.memory	= slot.Memory;
+			range.offset	= 0;
+			range.size		= VK_WHOLE_SIZE;
+			vkInvalidateMappedMemoryRanges(Device, 1, &range);
+		}
+
+		image.Width		= slot.Extent.width;
+		image.Height	= slot.Extent.height;
+		size_t size = static_cast<size_t>(image.Width) * image.Height * 4;
+		image.Texels.assign(slot.Mapped, slot.Mapped + size);
+		if (IsBgra(slot.Format))
+		{
+			for (size_t i = 0; i < size; i += 4)
+			{
+				std::swap(image.Texels[i], image.Texels[i + 2]);
+			}
+		}
+		frame = slot.Frame;
+		Stats.Collected++;
+		return true;
+	}
+	//-----------------------------------------------------------------------------
+	void FrameReadback::Allocate(Slot& slot, VkDeviceSize size)
+	{
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType		= VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size			= size;
+		bufferInfo.usage		= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		bufferInfo.sharingMode	= VK_SHARING_MODE_EXCLUSIVE;
+		if (vkCreateBuffer(Device, &bufferInfo, nullptr, &slot.Buffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create readback buffer!");
+		}
+
+		VkMemoryRequirements memRequirements;
+		vkGetBufferMemoryRequirements(Device, slot.Buffer, &memRequirements);
+
+		// Cached when there is such a type, reading uncached memory back is slow
+		uint32_t typeIndex = MemoryTypes.Select(memRequirements.memoryTypeBits, MemoryRequest::Readback());
+		VkMemoryAllocateInfo allocInfo	= {};
+		allocInfo.sType					= VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize		= memRequirements.size;
+		allocInfo.memoryTypeIndex		= typeIndex;
+		if (vkAllocateMemory(Device, &allocInfo, nullptr, &slot.Memory) != VK_SUCCESS)
+		{
+			vkDestroyBuffer(Device, slot.Buffer, nullptr);
+			slot.Buffer = VK_NULL_HANDLE;
+			throw std::runtime_error("failed to allocate readback memory!");
+		}
+		vkBindBufferMemory(Device, slot.Buffer, slot.Memory, 0);
+
+		void* mapped;
+		vkMapMemory(Device, slot.Memory, 0, VK_WHOLE_SIZE, 0, &mapped);
+		slot.Mapped		= static_cast<uint8_t*>(mapped);
+		slot.Size		= size;
+		slot.Coherent	= (MemoryTypes.GetProperties().memoryTypes[typeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+	}
+	//-----------------------------------------------------------------------------
+	void FrameReadback::Release(Slot& slot)
+	{
+		vkDestroyBuffer(Device, slot.Buffer, nullptr);
+		// Unmapped along with it
+		vkFreeMemory(Device, slot.Memory, nullptr);
+		slot = Slot();
+	}
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,123 @@
+//-----------------------------------------------------------------------------
+#include "render/GeometryPool.h"
+#include <stdexcept>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	GeometryPool::GeometryPool(VkDevice device, MemoryTypeFinder findMemoryType, const GeometryPoolDesc& desc)
+		: Desc(desc)
+		, IndexSize(desc.IndexType == VK_INDEX_TYPE_UINT16 ? 2 : 4)
+	{
+		if (Desc.VertexStride == 0)
+		{
+			throw std::runtime_error("geometry pool needs a vertex stride!");
+		}
+
+		BufferPoolDesc vertexDesc;
+		vertexDesc.Usage				= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+		vertexDesc.MemoryProperties		= Desc.MemoryProperties;
+		vertexDesc.BlockSize			= Desc.VertexBytes;
+		vertexDesc.MaxBlocks			= 1;
+		vertexDesc.FramesInFlight		= Desc.FramesInFlight;
+		vertexDesc.DefragBytesPerFrame	= Desc.DefragBytesPerFrame;
+		Vertices.reset(new BufferPool(device, findMemoryType, vertexDesc));
+
+		BufferPoolDesc indexDesc	= vertexDesc;
+		indexDesc.Usage				= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+		indexDesc.BlockSize			= Desc.IndexBytes;
+		Indices.reset(new BufferPool(device, findMemoryType, indexDesc));
+	}
+	//-----------------------------------------------------------------------------
+	MeshHandle GeometryPool::AddMesh(uint32_t vertexCount, uint32_t indexCount)
+	{
+		Mesh mesh;
+		mesh.VertexCount	= vertexCount;
+		mesh.IndexCount		= indexCount;
+		// Aligned to whole elements, offsets are counted in vertices and indices
+		mesh.Vertices		= Vertices->Allocate(VkDeviceSize(vertexCount) * Desc.VertexStride, Desc.VertexStride);
+		try
+		{
+			mesh.Indices	= Indices->Allocate(VkDeviceSize(indexCount) * IndexSize, IndexSize);
+		}
+		catch (...)
+		{
+			Vertices->Free(mesh.Vertices);
+			throw;
+		}
+
+		std::lock_guard<std::mutex> lock(Lock);
+		MeshHandle handle;
+		if (!FreeHandles.empty())
+		{
+			handle = FreeHandles.back();
+			FreeHandles.pop_back();
+			Meshes[handle] = mesh;
+		}
+		else
+		{
+			handle = static_cast<MeshHandle>(Meshes.size());
+			Meshes.push_back(mesh);
+		}
+		return handle;
+	}
+	//-----------------------------------------------------------------------------
+	void GeometryPool::RemoveMesh(MeshHandle handle)
+	{
+		Mesh mesh;
+		{
+			std::lock_guard<std::mutex> lock(Lock);
+			mesh = Meshes.at(handle);
+			if (mesh.Vertices == InvalidBufferAllocation)
+			{
+				throw std::runtime_error("mesh removed twice!");
+			}
+			Meshes[handle] = Mesh();
+			FreeHandles.push_back(handle);
+		}
+		Vertices->Free(mesh.Vertices);
+		Indices->Free(mesh.Indices);
+	}
+	//-----------------------------------------------------------------------------
+	const MeshRange GeometryPool::GetMesh(MeshHandle handle) const
+	{
+		Mesh mesh;
+		{
+			std::lock_guard<std::mutex> lock(Lock);
+			mesh = Meshes.at(handle);
+		}
+
+		MeshRange range;
+		range.Vertices		= Vertices->Resolve(mesh.Vertices);
+		range.Indices		= Indices->Resolve(mesh.Indices);
+		range.VertexOffset	= static_cast<int32_t>(range.Vertices.Offset / Desc.VertexStride);
+		range.VertexCount	= mesh.VertexCount;
+		range.FirstIndex	= static_cast<uint32_t>(range.Indices.Offset / IndexSize);
+		range.IndexCount	= mesh.IndexCount;
+		return range;
+	}
+	//-----------------------------------------------------------------------------
+	void GeometryPool::BeginFrame(uint32_t frameSlot)
+	{
+		Vertices->BeginFrame(frameSlot);
+		Indices->BeginFrame(frameSlot);
+	}
+	//-----------------------------------------------------------------------------
+	void GeometryPool::Defragment(VkCommandBuffer commandBuffer)
+	{
+		Vertices->Defragment(commandBuffer);
+		Indices->Defragment(commandBuffer);
+	}
+	//-----------------------------------------------------------------------------
+	const GeometryPoolStats GeometryPool::GetStats() const
+	{
+		GeometryPoolStats stats;
+		{
+			std::lock_guard<std::mutex> lock(Lock);
+			stats.Meshes = static_cast<uint32_t>(Meshes.size() - FreeHandles.size());
+		}
+		stats.Vertices	= Vertices->GetStats();
+		stats.Indices	= Indices->GetStats();
+		return stats;
+	}
+}
+//-----------------------------------------------------------------------------
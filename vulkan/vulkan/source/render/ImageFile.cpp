@@ -0,0 +1,241 @@
+//-----------------------------------------------------------------------------
+#include "render/ImageFile.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	static const bool EndsWith(const std::string& text, const std::string& suffix)
+	{
+		return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+	}
+	//-----------------------------------------------------------------------------
+	static const uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+	{
+		static uint32_t table[256] = {};
+		if (table[1] == 0)
+		{
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t value = i;
+				for (uint32_t bit = 0; bit < 8; bit++)
+				{
+					value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+				}
+				table[i] = value;
+			}
+		}
+		crc = ~crc;
+		for (size_t i = 0; i < size; i++)
+		{
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return ~crc;
+	}
+	//-----------------------------------------------------------------------------
+	static void PutBigEndian(std::vector<uint8_t>& out, uint32_t value)
+	{
+		out.push_back(static_cast<uint8_t>(value >> 24));
+		out.push_back(static_cast<uint8_t>(value >> 16));
+		out.push_back(static_cast<uint8_t>(value >> 8));
+		out.push_back(static_cast<uint8_t>(value));
+	}
+	//-----------------------------------------------------------------------------
+	static void PutChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data)
+	{
+		PutBigEndian(out, static_cast<uint32_t>(data.size()));
+		size_t start = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data.begin(), data.end());
+		PutBigEndian(out, Crc32(out.data() + start, out.size() - start));
+	}
+	//-----------------------------------------------------------------------------
+	static const std::vector<uint8_t> EncodePng(const RgbaImage& image)
+	{
+		// Rows with filter type 0 in front, then zlib with stored deflate
+		// blocks: bigger files, but no compressor to carry around
+		std::vector<uint8_t> raw;
+		size_t rowBytes = static_cast<size_t>(image.Width) * 4;
+		raw.reserve((rowBytes + 1) * image.Height);
+		for (uint32_t y = 0; y < image.Height; y++)
+		{
+			raw.push_back(0);
+			raw.insert(raw.end(), image.Texels.begin() + y * rowBytes, image.Texels.begin() + (y + 1) * rowBytes);
+		}
+
+		std::vector<uint8_t> zlib = { 0x78, 0x01 };
+		size_t offset = 0;
+		do
+		{
+			size_t blockSize = std::min<size_t>(raw.size() - offset, 65535);
+			bool last = offset + blockSize == raw.size();
+			zlib.push_back(last ? 1 : 0);
+			zlib.push_back(static_cast<uint8_t>(blockSize));
+			zlib.push_back(static_cast<uint8_t>(blockSize >> 8));
+			zlib.push_back(static_cast<uint8_t>(~blockSize));
+			zlib.push_back(static_cast<uint8_t>(~blockSize >> 8));
+			zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+			offset += blockSize;
+		} while (offset < raw.size());
+
+		uint32_t a = 1;
+		uint32_t b = 0;
+		for (uint8_t value : raw)
+		{
+			a = (a + value) % 65521;
+			b = (b + a) % 65521;
+		}
+		PutBigEndian(zlib, (b << 16) | a);
+
+		std::vector<uint8_t> header;
+		PutBigEndian(header, image.Width);
+		PutBigEndian(header, image.Height);
+		// 8 bit RGBA, deflate, adaptive filtering, not interlaced
+		header.insert(header.end(), { 8, 6, 0, 0, 0 });
+
+		std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		PutChunk(png, "IHDR", header);
+		PutChunk(png, "IDAT", zlib);
+		PutChunk(png, "IEND", {});
+		return png;
+	}
+	//-----------------------------------------------------------------------------
+	static const std::vector<uint8_t> EncodePpm(const RgbaImage& image)
+	{
+		std::string header = "P6\n" + std::to_string(image.Width) + " " + std::to_string(image.Height) + "\n255\n";
+		std::vector<uint8_t> ppm(header.begin(), header.end());
+		ppm.reserve(header.size() + static_cast<size_t>(image.Width) * image.Height * 3);
+		for (size_t i = 0; i < image.Texels.size(); i += 4)
+		{
+			ppm.insert(ppm.end(), image.Texels.begin() + i, image.Texels.begin() + i + 3);
+		}
+		return ppm;
+	}
+	//-----------------------------------------------------------------------------
+	void WriteImage(const std::string& path, const RgbaImage& image)
+	{
+		if (image.Texels.size() != static_cast<size_t>(image.Width) * image.Height * 4)
+		{
+			throw std::runtime_error("image size does not match its texels!");
+		}
+
+		std::vector<uint8_t> data;
+		if (EndsWith(path, ".png"))
+		{
+			data = EncodePng(image);
+		}
+		else if (EndsWith(path, ".ppm"))
+		{
+			data = EncodePpm(image);
+		}
+		else
+		{
+			throw std::runtime_error("unknown image extension " + path + "!");
+		}
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(data.data()), data.size());
+		if (!file)
+		{
+			throw std::runtime_error("failed to write " + path + "!");
+		}
+	}
+	//-----------------------------------------------------------------------------
+	const RgbaImage ReadPpm(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open())
+		{
+			throw std::runtime_error("failed to open " + path + "!");
+		}
+
+		// Header fields are separated by whitespace and may be followed by
+		// comments, then a single whitespace before the texels
+		std::string fields[4];
+		for (auto& field : fields)
+		{
+			char c;
+			while (file.get(c))
+			{
+				if (c == '#')
+				{
+					file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+				}
+				else if (!isspace(static_cast<unsigned char>(c)))
+				{
+					field += c;
+				}
+				else if (!field.empty())
+				{
+					break;
+				}
+			}
+		}
+
+		RgbaImage image;
+		image.Width		= static_cast<uint32_t>(strtoul(fields[1].c_str(), nullptr, 10));
+		image.Height	= static_cast<uint32_t>(strtoul(fields[2].c_str(), nullptr, 10));
+		if (fields[0] != "P6" || fields[3] != "255" || image.Width == 0 || image.Height == 0)
+		{
+			throw std::runtime_error(path + " is not an 8 bit binary PPM!");
+		}
+
+		size_t pixels = static_cast<size_t>(image.Width) * image.Height;
+		std::vector<uint8_t> rgb(pixels * 3);
+		if (!file.read(reinterpret_cast<char*>(rgb.data()), rgb.size()))
+		{
+			throw std::runtime_error(path + " is truncated!");
+		}
+		image.Texels.resize(pixels * 4);
+		for (size_t i = 0; i < pixels; i++)
+		{
+			image.Texels[i * 4 + 0] = rgb[i * 3 + 0];
+			image.Texels[i * 4 + 1] = rgb[i * 3 + 1];
+			image.Texels[i * 4 + 2] = rgb[i * 3 + 2];
+			image.Texels[i * 4 + 3] = 255;
+		}
+		return image;
+	}
+	//-----------------------------------------------------------------------------
+	const ImageDifference CompareImages(const RgbaImage& image, const RgbaImage& golden, uint32_t pixelThreshold)
+	{
+		ImageDifference difference;
+		if (image.Width != golden.Width || image.Height != golden.Height)
+		{
+			difference.SizeMismatch			= true;
+			difference.MeanAbsoluteError	= 255.0f;
+			difference.MaxDelta				= 255;
+			return difference;
+		}
+
+		uint64_t absoluteSum = 0;
+		uint64_t squaredSum = 0;
+		size_t pixels = static_cast<size_t>(image.Width) * image.Height;
+		for (size_t i = 0; i < pixels; i++)
+		{
+			uint32_t pixelDelta = 0;
+			for (size_t channel = 0; channel < 3; channel++)
+			{
+				uint32_t delta = static_cast<uint32_t>(std::abs(image.Texels[i * 4 + channel] - golden.Texels[i * 4 + channel]));
+				absoluteSum	+= delta;
+				squaredSum	+= delta * delta;
+				pixelDelta	= std::max(pixelDelta, delta);
+			}
+			difference.MaxDelta = std::max(difference.MaxDelta, pixelDelta);
+			difference.DifferingPixels += pixelDelta > pixelThreshold ? 1 : 0;
+		}
+
+		double samples = static_cast<double>(pixels) * 3.0;
+		double meanSquared = pixels > 0 ? squaredSum / samples : 0.0;
+		difference.MeanAbsoluteError = pixels > 0 ? static_cast<float>(absoluteSum / samples) : 0.0f;
+		difference.Psnr = meanSquared > 0.0 ? static_cast<float>(10.0 * std::log10(255.0 * 255.0 / meanSquared)) : std::numeric_limits<float>::infinity();
+		return difference;
+	}
+}
+//-----------------------------------------------------------------------------
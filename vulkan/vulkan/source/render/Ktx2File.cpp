@@ -0,0 +1,241 @@
+//-----------------------------------------------------------------------------
+#include "render/Ktx2File.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	static const uint8_t Ktx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+	//-----------------------------------------------------------------------------
+	// Layout of the fixed part of the file, everything little endian
+	struct Ktx2Header
+	{
+		uint8_t Identifier[12];
+		uint32_t VkFormat;
+		uint32_t TypeSize;
+		uint32_t PixelWidth;
+		uint32_t PixelHeight;
+		uint32_t PixelDepth;
+		uint32_t LayerCount;
+		uint32_t FaceCount;
+		uint32_t LevelCount;
+		uint32_t SupercompressionScheme;
+		uint32_t DfdByteOffset;
+		uint32_t DfdByteLength;
+		uint32_t KvdByteOffset;
+		uint32_t KvdByteLength;
+		uint64_t SgdByteOffset;
+		uint64_t SgdByteLength;
+	};
+	//-----------------------------------------------------------------------------
+	struct Ktx2LevelIndex
+	{
+		uint64_t ByteOffset;
+		uint64_t ByteLength;
+		uint64_t UncompressedByteLength;
+	};
+	//-----------------------------------------------------------------------------
+	static const uint32_t GetFormatBlockSize(VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+		case VK_FORMAT_BC4_SNORM_BLOCK:
+			return 8;
+		case VK_FORMAT_BC2_UNORM_BLOCK:
+		case VK_FORMAT_BC2_SRGB_BLOCK:
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC5_SNORM_BLOCK:
+		case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+		case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+	//-----------------------------------------------------------------------------
+	// Khronos Data Format basic descriptor, one sample covering the whole block
+	static std::vector<uint32_t> MakeBlockFormatDescriptor(VkFormat format)
+	{
+		const uint32_t ModelBC1A	= 128;
+		const uint32_t ModelBC7		= 136;
+		const uint32_t PrimariesBT709	= 1;
+		const uint32_t TransferLinear	= 1;
+		const uint32_t TransferSRGB		= 2;
+
+		uint32_t model		= 0;
+		uint32_t transfer	= TransferLinear;
+		switch (format)
+		{
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:	transfer = TransferSRGB;	// fall through
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:	model = ModelBC1A;		break;
+		case VK_FORMAT_BC7_SRGB_BLOCK:		transfer = TransferSRGB;	// fall through
+		case VK_FORMAT_BC7_UNORM_BLOCK:		model = ModelBC7;		break;
+		default:
+			throw std::runtime_error("KTX2: no data format descriptor for this format!");
+		}
+
+		uint32_t blockBits = GetFormatBlockSize(format) * 8;
+		std::vector<uint32_t> dfd;
+		dfd.push_back(4 + 24 + 16);							// total size
+		dfd.push_back(0);									// vendor 0, basic descriptor type 0
+		dfd.push_back(2 | ((24 + 16) << 16));				// version 2, block size
+		dfd.push_back(model | (PrimariesBT709 << 8) | (transfer << 16));
+		dfd.push_back(3 | (3 << 8));						// 4x4x1x1 texels, stored minus one
+		dfd.push_back(GetFormatBlockSize(format));			// bytes in plane 0
+		dfd.push_back(0);
+		dfd.push_back((blockBits - 1) << 16);				// bit offset 0, channel 0 (color)
+		dfd.push_back(0);									// sample position
+		dfd.push_back(0);									// lower
+		dfd.push_back(~0u);									// upper
+		return dfd;
+	}
+	//-----------------------------------------------------------------------------
+	static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+	//-----------------------------------------------------------------------------
+	const bool Ktx2File::IsBlockCompressed(VkFormat format)
+	{
+		return GetFormatBlockSize(format) != 0;
+	}
+	//-----------------------------------------------------------------------------
+	Ktx2File::Ktx2File(const std::string& path)
+		: Path(path)
+	{
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+		{
+			throw std::runtime_error("failed to open " + path + "!");
+		}
+		uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+		file.seekg(0);
+
+		Ktx2Header header;
+		if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || memcmp(header.Identifier, Ktx2Identifier, sizeof(Ktx2Identifier)) != 0)
+		{
+			throw std::runtime_error(path + " is not a KTX2 file!");
+		}
+
+		Format		= static_cast<VkFormat>(header.VkFormat);
+		BlockSize	= GetFormatBlockSize(Format);
+		BlockExtent	= 4;
+		if (Format == VK_FORMAT_R8G8B8A8_UNORM || Format == VK_FORMAT_R8G8B8A8_SRGB)
+		{
+			BlockSize	= 4;
+			BlockExtent	= 1;
+		}
+		if (BlockSize == 0)
+		{
+			throw std::runtime_error(path + " is neither block compressed nor RGBA8!");
+		}
+		if (header.SupercompressionScheme != 0)
+		{
+			throw std::runtime_error(path + " is supercompressed!");
+		}
+		if (header.PixelWidth == 0 || header.PixelHeight == 0 || header.PixelDepth > 1 || header.LayerCount > 1 || header.FaceCount != 1)
+		{
+			throw std::runtime_error(path + " is not a single 2D texture!");
+		}
+
+		// levelCount 0 asks the loader to build the chain, there is only the base level in the file
+		uint32_t levelCount = std::max(header.LevelCount, 1u);
+		std::vector<Ktx2LevelIndex> index(levelCount);
+		if (!file.read(reinterpret_cast<char*>(index.data()), index.size() * sizeof(Ktx2LevelIndex)))
+		{
+			throw std::runtime_error(path + " has a truncated level index!");
+		}
+
+		for (uint32_t level = 0; level < levelCount; level++)
+		{
+			Ktx2Level entry;
+			entry.ByteOffset	= index[level].ByteOffset;
+			entry.ByteLength	= index[level].ByteLength;
+			entry.Width			= std::max(header.PixelWidth >> level, 1u);
+			entry.Height		= std::max(header.PixelHeight >> level, 1u);
+
+			uint64_t blocksX	= (entry.Width + BlockExtent - 1) / BlockExtent;
+			uint64_t blocksY	= (entry.Height + BlockExtent - 1) / BlockExtent;
+			uint64_t expected	= blocksX * blocksY * BlockSize;
+			if (entry.ByteLength != expected || entry.ByteOffset + entry.ByteLength > fileSize)
+			{
+				throw std::runtime_error(path + " has a broken level " + std::to_string(level) + "!");
+			}
+			Levels.push_back(entry);
+		}
+	}
+	//-----------------------------------------------------------------------------
+	void Ktx2File::Write(const std::string& path, VkFormat format, uint32_t width, uint32_t height, const std::vector<std::vector<char>>& levels)
+	{
+		std::vector<uint32_t> dfd = MakeBlockFormatDescriptor(format);
+
+		Ktx2Header header = {};
+		memcpy(header.Identifier, Ktx2Identifier, sizeof(Ktx2Identifier));
+		header.VkFormat					= format;
+		header.TypeSize					= 1;
+		header.PixelWidth				= width;
+		header.PixelHeight				= height;
+		header.FaceCount				= 1;
+		header.LevelCount				= static_cast<uint32_t>(levels.size());
+		header.DfdByteOffset			= static_cast<uint32_t>(sizeof(Ktx2Header) + levels.size() * sizeof(Ktx2LevelIndex));
+		header.DfdByteLength			= static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+
+		// The spec stores the smallest level first, each aligned to the block size
+		std::vector<Ktx2LevelIndex> index(levels.size());
+		uint64_t offset = header.DfdByteOffset + header.DfdByteLength;
+		for (size_t level = levels.size(); level-- > 0;)
+		{
+			offset = AlignUp(offset, GetFormatBlockSize(format));
+			index[level].ByteOffset				= offset;
+			index[level].ByteLength				= levels[level].size();
+			index[level].UncompressedByteLength	= levels[level].size();
+			offset += levels[level].size();
+		}
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			throw std::runtime_error("failed to create " + path + "!");
+		}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(Ktx2LevelIndex));
+		file.write(reinterpret_cast<const char*>(dfd.data()), dfd.size() * sizeof(uint32_t));
+		for (size_t level = levels.size(); level-- > 0;)
+		{
+			static const char padding[16] = {};
+			uint64_t position = static_cast<uint64_t>(file.tellp());
+			file.write(padding, static_cast<std::streamsize>(index[level].ByteOffset - position));
+			file.write(levels[level].data(), levels[level].size());
+		}
+		if (!file)
+		{
+			throw std::runtime_error("failed to write " + path + "!");
+		}
+	}
+	//-----------------------------------------------------------------------------
+	std::vector<char> Ktx2File::ReadLevel(uint32_t level) const
+	{
+		const Ktx2Level& entry = Levels.at(level);
+
+		// A stream per read, the file object can be shared between jobs
+		std::ifstream file(Path, std::ios::binary);
+		std::vector<char> data(static_cast<size_t>(entry.ByteLength));
+		if (!file.is_open() || !file.seekg(static_cast<std::streamoff>(entry.ByteOffset)) || !file.read(data.data(), data.size()))
+		{
+			throw std::runtime_error("failed to read level " + std::to_string(level) + " of " + Path + "!");
+		}
+		return data;
+	}
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,166 @@
+//-----------------------------------------------------------------------------
+#include "render/LayoutCache.h"
+#include "render/Hash.h"
+#include <algorithm>
+#include <stdexcept>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	bool LayoutCache::SetLayoutKey::operator==(const SetLayoutKey& other) const
+	{
+		if (Flags != other.Flags || Bindings.size() != other.Bindings.size())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < Bindings.size(); i++)
+		{
+			const VkDescriptorSetLayoutBinding& a = Bindings[i];
+			const VkDescriptorSetLayoutBinding& b = other.Bindings[i];
+			if (a.binding != b.binding || a.descriptorType != b.descriptorType || a.descriptorCount != b.descriptorCount || a.stageFlags != b.stageFlags)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	//-----------------------------------------------------------------------------
+	size_t LayoutCache::SetLayoutKeyHash::operator()(const SetLayoutKey& key) const
+	{
+		size_t seed = key.Bindings.size();
+		HashCombine(seed, key.Flags);
+		for (const auto& binding : key.Bindings)
+		{
+			HashCombine(seed, binding.binding);
+			HashCombine(seed, static_cast<size_t>(binding.descriptorType));
+			HashCombine(seed, binding.descriptorCount);
+			HashCombine(seed, binding.stageFlags);
+		}
+		return seed;
+	}
+	//-----------------------------------------------------------------------------
+	bool LayoutCache::PipelineLayoutKey::operator==(const PipelineLayoutKey& other) const
+	{
+		if (SetLayouts != other.SetLayouts || PushConstants.size() != other.PushConstants.size())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < PushConstants.size(); i++)
+		{
+			const VkPushConstantRange& a = PushConstants[i];
+			const VkPushConstantRange& b = other.PushConstants[i];
+			if (a.stageFlags != b.stageFlags || a.offset != b.offset || a.size != b.size)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	//-----------------------------------------------------------------------------
+	size_t LayoutCache::PipelineLayoutKeyHash::operator()(const PipelineLayoutKey& key) const
+	{
+		size_t seed = key.SetLayouts.size();
+		for (auto layout : key.SetLayouts)
+		{
+			HashCombine(seed, HashHandle(layout));
+		}
+		for (const auto& range : key.PushConstants)
+		{
+			HashCombine(seed, range.stageFlags);
+			HashCombine(seed, range.offset);
+			HashCombine(seed, range.size);
+		}
+		return seed;
+	}
+	//-----------------------------------------------------------------------------
+	LayoutCache::LayoutCache(VkDevice device)
+		: Device(device)
+	{
+	}
+	//-----------------------------------------------------------------------------
+	LayoutCache::~LayoutCache()
+	{
+		for (const auto& layout : PipelineLayouts)
+		{
+			vkDestroyPipelineLayout(Device, layout.second, nullptr);
+		}
+		for (const auto& layout : SetLayouts)
+		{
+			vkDestroyDescriptorSetLayout(Device, layout.second, nullptr);
+		}
+	}
+	//-----------------------------------------------------------------------------
+	VkDescriptorSetLayout LayoutCache::GetDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, VkDescriptorSetLayoutCreateFlags flags)
+	{
+		// Normalized so the same interface declared in a different order hits
+		SetLayoutKey key = { flags, bindings };
+		std::sort(key.Bindings.begin(), key.Bindings.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) { return a.binding < b.binding; });
+		for (const auto& binding : key.Bindings)
+		{
+			if (binding.pImmutableSamplers != nullptr)
+			{
+				throw std::runtime_error("layout cache does not support immutable samplers!");
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(Lock);
+		auto found = SetLayouts.find(key);
+		if (found != SetLayouts.end())
+		{
+			Stats.Hits++;
+			return found->second;
+		}
+		Stats.Misses++;
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo	= {};
+		layoutInfo.sType							= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.flags							= flags;
+		layoutInfo.bindingCount						= static_cast<uint32_t>(key.Bindings.size());
+		layoutInfo.pBindings						= key.Bindings.data();
+
+		VkDescriptorSetLayout layout;
+		if (vkCreateDescriptorSetLayout(Device, &layoutInfo, nullptr, &layout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create descriptor set layout!");
+		}
+		SetLayouts.emplace(key, layout);
+		Stats.DescriptorSetLayouts++;
+		return layout;
+	}
+	//-----------------------------------------------------------------------------
+	VkPipelineLayout LayoutCache::GetPipelineLayout(const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstants)
+	{
+		PipelineLayoutKey key = { setLayouts, pushConstants };
+
+		std::lock_guard<std::mutex> lock(Lock);
+		auto found = PipelineLayouts.find(key);
+		if (found != PipelineLayouts.end())
+		{
+			Stats.Hits++;
+			return found->second;
+		}
+		Stats.Misses++;
+
+		VkPipelineLayoutCreateInfo layoutInfo	= {};
+		layoutInfo.sType						= VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layoutInfo.setLayoutCount				= static_cast<uint32_t>(key.SetLayouts.size());
+		layoutInfo.pSetLayouts					= key.SetLayouts.data();
+		layoutInfo.pushConstantRangeCount		= static_cast<uint32_t>(key.PushConstants.size());
+		layoutInfo.pPushConstantRanges			= key.PushConstants.data();
+
+		VkPipelineLayout layout;
+		if (vkCreatePipelineLayout(Device, &layoutInfo, nullptr, &layout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create pipeline layout");
+		}
+		PipelineLayouts.emplace(key, layout);
+		Stats.PipelineLayouts++;
+		return layout;
+	}
+	//-----------------------------------------------------------------------------
+	const LayoutCacheStats LayoutCache::GetStats() const
+	{
+		std::lock_guard<std::mutex> lock(Lock);
+		return Stats;
+	}
+}
+//-----------------------------------------------------------------------------
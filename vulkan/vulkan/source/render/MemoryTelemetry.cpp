@@ -0,0 +1,177 @@
+//-----------------------------------------------------------------------------
+#include "render/MemoryTelemetry.h"
+#include <cstring>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	const float MemoryTelemetry::FallbackBudgetShare = 0.8f;
+	//-----------------------------------------------------------------------------
+	static const uint32_t CategoryCount = static_cast<uint32_t>(MemoryCategory::Count);
+	//-----------------------------------------------------------------------------
+	MemoryTelemetry::MemoryTelemetry(VkPhysicalDevice physicalDevice, const MemoryTypeSelector& memoryTypes, bool budgetEnabled)
+		: PhysicalDevice(physicalDevice)
+		, MemoryTypes(memoryTypes)
+		, BudgetEnabled(budgetEnabled)
+	{
+		const VkPhysicalDeviceMemoryProperties& properties = MemoryTypes.GetProperties();
+		TrackedHeaps.resize(properties.memoryHeapCount);
+		ExternalHeaps.resize(properties.memoryHeapCount);
+		Heaps.resize(properties.memoryHeapCount);
+		for (uint32_t i = 0; i < properties.memoryHeapCount; i++)
+		{
+			Heaps[i].Size			= properties.memoryHeaps[i].size;
+			Heaps[i].DeviceLocal	= (properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+		}
+
+		uint32_t typeIndex;
+		if (MemoryTypes.Find(~0u, MemoryRequest::DeviceLocal(), typeIndex))
+		{
+			DeviceLocalHeap = MemoryTypes.GetHeapIndex(typeIndex);
+		}
+		Update();
+	}
+	//-----------------------------------------------------------------------------
+	const bool MemoryTelemetry::IsBudgetSupported(VkPhysicalDevice physicalDevice, uint32_t instanceApiVersion)
+	{
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		if (instanceApiVersion < VK_API_VERSION_1_1 || properties.apiVersion < VK_API_VERSION_1_1)
+		{
+			return false;
+		}
+
+		uint32_t extensionCount;
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+		for (const auto& extension : availableExtensions)
+		{
+			if (strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+	//-----------------------------------------------------------------------------
+	const MemoryCategory MemoryTelemetry::GetCategory(VkBufferUsageFlags usage)
+	{
+		if (usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)
+		{
+			return MemoryCategory::Vertex;
+		}
+		if (usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT)
+		{
+			return MemoryCategory::Index;
+		}
+		if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+		{
+			return MemoryCategory::Uniform;
+		}
+		if (usage == VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+		{
+			return MemoryCategory::Staging;
+		}
+		return MemoryCategory::Other;
+	}
+	//-----------------------------------------------------------------------------
+	const char* MemoryTelemetry::GetCategoryName(MemoryCategory category)
+	{
+		switch (category)
+		{
+		case MemoryCategory::Vertex:	return "vertex";
+		case MemoryCategory::Index:		return "index";
+		case MemoryCategory::Uniform:	return "uniform";
+		case MemoryCategory::Staging:	return "staging";
+		case MemoryCategory::Texture:	return "texture";
+		default:						return "other";
+		}
+	}
+	//-----------------------------------------------------------------------------
+	void MemoryTelemetry::OnAllocate(VkDeviceMemory memory, MemoryCategory category, uint32_t typeIndex, VkDeviceSize size)
+	{
+		uint32_t heapIndex = MemoryTypes.GetHeapIndex(typeIndex);
+		std::lock_guard<std::mutex> lock(TrackedLock);
+		Allocations[memory] = { category, heapIndex, size };
+		TrackedHeaps[heapIndex].Tracked[static_cast<uint32_t>(category)] += size;
+	}
+	//-----------------------------------------------------------------------------
+	void MemoryTelemetry::OnFree(VkDeviceMemory memory)
+	{
+		std::lock_guard<std::mutex> lock(TrackedLock);
+		auto found = Allocations.find(memory);
+		if (found == Allocations.end())
+		{
+			return;
+		}
+		TrackedHeaps[found->second.HeapIndex].Tracked[static_cast<uint32_t>(found->second.Category)] -= found->second.Size;
+		Allocations.erase(found);
+	}
+	//-----------------------------------------------------------------------------
+	void MemoryTelemetry::SetExternal(MemoryCategory category, uint32_t heapIndex, VkDeviceSize size)
+	{
+		std::lock_guard<std::mutex> lock(TrackedLock);
+		ExternalHeaps[heapIndex].Tracked[static_cast<uint32_t>(category)] = size;
+	}
+	//-----------------------------------------------------------------------------
+	void MemoryTelemetry::Update()
+	{
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {};
+		budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+		if (BudgetEnabled)
+		{
+			VkPhysicalDeviceMemoryProperties2 properties2 = {};
+			properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+			properties2.pNext = &budget;
+			vkGetPhysicalDeviceMemoryProperties2(PhysicalDevice, &properties2);
+		}
+
+		std::lock_guard<std::mutex> lock(TrackedLock);
+		for (uint32_t i = 0; i < Heaps.size(); i++)
+		{
+			MemoryHeapReport& heap = Heaps[i];
+			VkDeviceSize tracked = 0;
+			for (uint32_t category = 0; category < CategoryCount; category++)
+			{
+				heap.Tracked[category] = TrackedHeaps[i].Tracked[category] + ExternalHeaps[i].Tracked[category];
+				tracked += heap.Tracked[category];
+			}
+
+			if (BudgetEnabled)
+			{
+				heap.Budget	= budget.heapBudget[i];
+				heap.Usage	= budget.heapUsage[i];
+			}
+			else
+			{
+				heap.Budget	= static_cast<VkDeviceSize>(heap.Size * FallbackBudgetShare);
+				heap.Usage	= tracked;
+			}
+		}
+	}
+	//-----------------------------------------------------------------------------
+	const VkDeviceSize MemoryTelemetry::GetHeadroom(uint32_t heapIndex) const
+	{
+		const MemoryHeapReport& heap = Heaps[heapIndex];
+		return heap.Usage < heap.Budget ? heap.Budget - heap.Usage : 0;
+	}
+	//-----------------------------------------------------------------------------
+	void MemoryTelemetry::PrintReport(std::ostream& out) const
+	{
+		for (uint32_t i = 0; i < Heaps.size(); i++)
+		{
+			const MemoryHeapReport& heap = Heaps[i];
+			out << "Heap " << i << (heap.DeviceLocal ? " (device local): " : ": ")
+				<< (heap.Usage >> 20) << " / " << (heap.Budget >> 20) << " MB" << (BudgetEnabled ? "" : " (estimated)");
+			for (uint32_t category = 0; category < CategoryCount; category++)
+			{
+				if (heap.Tracked[category] > 0)
+				{
+					out << ", " << GetCategoryName(static_cast<MemoryCategory>(category)) << " " << (heap.Tracked[category] >> 10) << " KB";
+				}
+			}
+			out << std::endl;
+		}
+	}
+}
+//-----------------------------------------------------------------------------
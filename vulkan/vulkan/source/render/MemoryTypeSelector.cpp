@@ -0,0 +1,128 @@
+//-----------------------------------------------------------------------------
+#include "render/MemoryTypeSelector.h"
+#include <stdexcept>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	static uint32_t CountBits(uint32_t bits)
+	{
+		uint32_t count = 0;
+		for (; bits != 0; bits &= bits - 1)
+		{
+			count++;
+		}
+		return count;
+	}
+	//-----------------------------------------------------------------------------
+	const MemoryRequest MemoryRequest::DeviceLocal()
+	{
+		MemoryRequest request;
+		request.Required	= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		// Leave the mappable device memory to the buffers that need it
+		request.Avoided		= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		return request;
+	}
+	//-----------------------------------------------------------------------------
+	const MemoryRequest MemoryRequest::Staging()
+	{
+		MemoryRequest request;
+		request.Required	= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		// Write combined system memory, the BAR is too small to burn on copies
+		request.Avoided		= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+		return request;
+	}
+	//-----------------------------------------------------------------------------
+	const MemoryRequest MemoryRequest::DirectUpload()
+	{
+		MemoryRequest request;
+		request.Required	= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		// Cached reads are not needed and make the GPU snoop on some parts
+		request.Avoided		= VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+		return request;
+	}
+	//-----------------------------------------------------------------------------
+	const MemoryRequest MemoryRequest::Readback()
+	{
+		MemoryRequest request;
+		request.Required	= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		// Uncached reads from the CPU are an order of magnitude slower
+		request.Preferred	= VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+		return request;
+	}
+	//-----------------------------------------------------------------------------
+	const MemoryRequest MemoryRequest::Exactly(VkMemoryPropertyFlags properties)
+	{
+		MemoryRequest request;
+		request.Required	= properties;
+		request.Avoided		= ~properties & (VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+		return request;
+	}
+	//-----------------------------------------------------------------------------
+	MemoryTypeSelector::MemoryTypeSelector(VkPhysicalDevice physicalDevice)
+	{
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &Properties);
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+
+		// Integrated parts allocate device local memory from system memory,
+		// whether or not every such type is mappable; that is not a BAR
+		UnifiedMemory = deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU;
+
+		// Only a discrete GPU has a BAR to speak of
+		if (deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+		{
+			const VkMemoryPropertyFlags mappableVram = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+			for (uint32_t i = 0; i < Properties.memoryTypeCount; i++)
+			{
+				const VkMemoryType& type = Properties.memoryTypes[i];
+				if ((type.propertyFlags & mappableVram) == mappableVram && Properties.memoryHeaps[type.heapIndex].size > LegacyBarSize)
+				{
+					ResizableBar = true;
+				}
+			}
+		}
+
+		uint32_t typeIndex;
+		DirectUploadAvailable = Find(~0u, MemoryRequest::DirectUpload(), typeIndex);
+	}
+	//-----------------------------------------------------------------------------
+	const bool MemoryTypeSelector::Find(uint32_t typeFilter, const MemoryRequest& request, uint32_t& typeIndex) const
+	{
+		// Never handed out unless asked for, they need special handling
+		const VkMemoryPropertyFlags special = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT | VK_MEMORY_PROPERTY_PROTECTED_BIT;
+
+		bool found = false;
+		uint32_t bestScore = 0;
+		VkDeviceSize bestHeapSize = 0;
+		for (uint32_t i = 0; i < Properties.memoryTypeCount; i++)
+		{
+			VkMemoryPropertyFlags flags = Properties.memoryTypes[i].propertyFlags;
+			if ((typeFilter & (1u << i)) == 0 || (flags & request.Required) != request.Required || (flags & special & ~request.Required) != 0)
+			{
+				continue;
+			}
+
+			uint32_t score = CountBits(flags & request.Preferred) + CountBits(~flags & request.Avoided);
+			VkDeviceSize heapSize = Properties.memoryHeaps[Properties.memoryTypes[i].heapIndex].size;
+			if (!found || score > bestScore || (score == bestScore && heapSize > bestHeapSize))
+			{
+				found			= true;
+				typeIndex		= i;
+				bestScore		= score;
+				bestHeapSize	= heapSize;
+			}
+		}
+		return found;
+	}
+	//-----------------------------------------------------------------------------
+	const uint32_t MemoryTypeSelector::Select(uint32_t typeFilter, const MemoryRequest& request) const
+	{
+		uint32_t typeIndex;
+		if (!Find(typeFilter, request, typeIndex))
+		{
+			throw std::runtime_error("Failed to find suitable memory type");
+		}
+		return typeIndex;
+	}
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,243 @@
+//-----------------------------------------------------------------------------
+#include "render/MipGenerator.h"
+#include "render/ShaderReflection.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	// Texels of level 0 one group reduces, per side
+	static const uint32_t TileSize = 64;
+	//-----------------------------------------------------------------------------
+	static VkImageMemoryBarrier MakeBarrier(VkImage image, uint32_t baseLevel, uint32_t levelCount, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccess, VkAccessFlags dstAccess)
+	{
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType							= VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout						= oldLayout;
+		barrier.newLayout						= newLayout;
+		barrier.srcAccessMask					= srcAccess;
+		barrier.dstAccessMask					= dstAccess;
+		barrier.srcQueueFamilyIndex				= VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex				= VK_QUEUE_FAMILY_IGNORED;
+		barrier.image							= image;
+		barrier.subresourceRange.aspectMask		= VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel	= baseLevel;
+		barrier.subresourceRange.levelCount		= levelCount;
+		barrier.subresourceRange.baseArrayLayer	= 0;
+		barrier.subresourceRange.layerCount		= 1;
+		return barrier;
+	}
+	//-----------------------------------------------------------------------------
+	static VkBufferMemoryBarrier MakeBufferBarrier(VkBuffer buffer, VkAccessFlags srcAccess, VkAccessFlags dstAccess)
+	{
+		VkBufferMemoryBarrier barrier = {};
+		barrier.sType				= VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask		= srcAccess;
+		barrier.dstAccessMask		= dstAccess;
+		barrier.srcQueueFamilyIndex	= VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex	= VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer				= buffer;
+		barrier.offset				= 0;
+		barrier.size				= VK_WHOLE_SIZE;
+		return barrier;
+	}
+	//-----------------------------------------------------------------------------
+	MipGenerator::MipGenerator(VkDevice device, LayoutCache& layouts, const std::vector<char>& shaderCode, MemoryTypeFinder findMemoryType, VkPipelineCache cache)
+		: Device(device)
+		, Descriptors(device, 16)
+	{
+		ShaderReflection reflection = ShaderReflection::FromSpirv(shaderCode);
+		const DescriptorSetReflection* set = reflection.FindSet(0);
+		if (reflection.Stages != VK_SHADER_STAGE_COMPUTE_BIT || set == nullptr || set->Bindings.size() != 3 ||
+			set->Bindings[1].descriptorCount != MaxGeneratedLevels || reflection.PushConstants.size() != 1 ||
+			reflection.PushConstants[0].size != sizeof(MipConstants))
+		{
+			throw std::runtime_error("mip generation shader does not match MipGenerator!");
+		}
+		SetLayout		= layouts.GetDescriptorSetLayout(set->Bindings);
+		PipelineLayout	= layouts.GetPipelineLayout({ SetLayout }, reflection.PushConstants);
+		Descriptors.RegisterLayout(set->Bindings);
+
+		VkShaderModuleCreateInfo moduleInfo = {};
+		moduleInfo.sType	= VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		moduleInfo.codeSize	= shaderCode.size();
+		moduleInfo.pCode	= reinterpret_cast<const uint32_t*>(shaderCode.data());
+		if (vkCreateShaderModule(Device, &moduleInfo, nullptr, &Module) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create mip generation shader module!");
+		}
+
+		VkComputePipelineCreateInfo pipelineInfo = {};
+		pipelineInfo.sType			= VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage.sType	= VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipelineInfo.stage.stage	= VK_SHADER_STAGE_COMPUTE_BIT;
+		pipelineInfo.stage.module	= Module;
+		pipelineInfo.stage.pName	= "main";
+		pipelineInfo.layout			= PipelineLayout;
+		if (vkCreateComputePipelines(Device, cache, 1, &pipelineInfo, nullptr, &Pipeline) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create mip generation pipeline!");
+		}
+
+		VkSamplerCreateInfo samplerInfo = {};
+		samplerInfo.sType			= VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter		= VK_FILTER_LINEAR;
+		samplerInfo.minFilter		= VK_FILTER_LINEAR;
+		samplerInfo.mipmapMode		= VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		samplerInfo.addressModeU	= VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV	= VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW	= VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.borderColor		= VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+		if (vkCreateSampler(Device, &samplerInfo, nullptr, &Sampler) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create mip generation sampler!");
+		}
+
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType		= VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size			= sizeof(uint32_t);
+		bufferInfo.usage		= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		bufferInfo.sharingMode	= VK_SHARING_MODE_EXCLUSIVE;
+		if (vkCreateBuffer(Device, &bufferInfo, nullptr, &CounterBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create mip generation counter!");
+		}
+
+		VkMemoryRequirements memRequirements;
+		vkGetBufferMemoryRequirements(Device, CounterBuffer, &memRequirements);
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType				= VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize	= memRequirements.size;
+		allocInfo.memoryTypeIndex	= findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		if (vkAllocateMemory(Device, &allocInfo, nullptr, &CounterMemory) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to allocate mip generation counter memory!");
+		}
+		vkBindBufferMemory(Device, CounterBuffer, CounterMemory, 0);
+	}
+	//-----------------------------------------------------------------------------
+	MipGenerator::~MipGenerator()
+	{
+		Reset();
+		vkDestroyBuffer(Device, CounterBuffer, nullptr);
+		vkFreeMemory(Device, CounterMemory, nullptr);
+		vkDestroySampler(Device, Sampler, nullptr);
+		vkDestroyPipeline(Device, Pipeline, nullptr);
+		vkDestroyShaderModule(Device, Module, nullptr);
+	}
+	//-----------------------------------------------------------------------------
+	void MipGenerator::Generate(VkCommandBuffer commandBuffer, VkImage image, VkExtent2D extent, uint32_t levelCount)
+	{
+		if (std::max(extent.width, extent.height) > MaxBaseSize)
+		{
+			throw std::runtime_error("mip generation is limited to " + std::to_string(MaxBaseSize) + " texels per side!");
+		}
+		uint32_t generated = std::min(levelCount, MaxGeneratedLevels + 1) - 1;
+
+		VkImageMemoryBarrier sourceBarrier = MakeBarrier(image, 0, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+														VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+		if (generated == 0)
+		{
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+								0, nullptr, 0, nullptr, 1, &sourceBarrier);
+			return;
+		}
+
+		VkImageView sourceView = CreateLevelView(image, 0);
+		std::vector<VkDescriptorImageInfo> levelInfos;
+		for (uint32_t level = 1; level <= MaxGeneratedLevels; level++)
+		{
+			// Slots past the chain still need a valid view, the shader never writes them
+			VkImageView view = level <= generated ? CreateLevelView(image, level) : levelInfos.back().imageView;
+			levelInfos.push_back({ VK_NULL_HANDLE, view, VK_IMAGE_LAYOUT_GENERAL });
+		}
+		VkDescriptorImageInfo sourceInfo	= { Sampler, sourceView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		VkDescriptorBufferInfo counterInfo	= { CounterBuffer, 0, VK_WHOLE_SIZE };
+
+		VkDescriptorSet set = Descriptors.Allocate(SetLayout);
+		VkWriteDescriptorSet writes[3] = {};
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			writes[i].sType				= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet			= set;
+			writes[i].dstBinding		= i;
+			writes[i].descriptorCount	= 1;
+		}
+		writes[0].descriptorType	= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[0].pImageInfo		= &sourceInfo;
+		writes[1].descriptorType	= VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		writes[1].descriptorCount	= MaxGeneratedLevels;
+		writes[1].pImageInfo		= levelInfos.data();
+		writes[2].descriptorType	= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[2].pBufferInfo		= &counterInfo;
+		vkUpdateDescriptorSets(Device, 3, writes, 0, nullptr);
+
+		// The counter may still be in use by the previous dispatch
+		VkBufferMemoryBarrier counterBarrier = MakeBufferBarrier(CounterBuffer, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+							0, nullptr, 1, &counterBarrier, 0, nullptr);
+		vkCmdFillBuffer(commandBuffer, CounterBuffer, 0, VK_WHOLE_SIZE, 0);
+
+		counterBarrier = MakeBufferBarrier(CounterBuffer, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+		VkImageMemoryBarrier imageBarriers[2] =
+		{
+			sourceBarrier,
+			MakeBarrier(image, 1, generated, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, 0, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT)
+		};
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+							0, nullptr, 1, &counterBarrier, 2, imageBarriers);
+
+		uint32_t groupsX = (extent.width + TileSize - 1) / TileSize;
+		uint32_t groupsY = (extent.height + TileSize - 1) / TileSize;
+
+		MipConstants constants;
+		constants.InvSourceSize[0]	= 1.0f / extent.width;
+		constants.InvSourceSize[1]	= 1.0f / extent.height;
+		constants.MipCount			= generated;
+		constants.GroupCount		= groupsX * groupsY;
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, Pipeline);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, PipelineLayout, 0, 1, &set, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+		vkCmdDispatch(commandBuffer, groupsX, groupsY, 1);
+
+		VkImageMemoryBarrier doneBarrier = MakeBarrier(image, 1, generated, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+														VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+							0, nullptr, 0, nullptr, 1, &doneBarrier);
+	}
+	//-----------------------------------------------------------------------------
+	void MipGenerator::Reset()
+	{
+		for (VkImageView view : Views)
+		{
+			vkDestroyImageView(Device, view, nullptr);
+		}
+		Views.clear();
+		Descriptors.Reset();
+	}
+	//-----------------------------------------------------------------------------
+	VkImageView MipGenerator::CreateLevelView(VkImage image, uint32_t level)
+	{
+		VkImageViewCreateInfo viewInfo = {};
+		viewInfo.sType								= VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image								= image;
+		viewInfo.viewType							= VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format								= VK_FORMAT_R8G8B8A8_UNORM;
+		viewInfo.subresourceRange.aspectMask		= VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel		= level;
+		viewInfo.subresourceRange.levelCount		= 1;
+		viewInfo.subresourceRange.baseArrayLayer	= 0;
+		viewInfo.subresourceRange.layerCount		= 1;
+
+		VkImageView view;
+		if (vkCreateImageView(Device, &viewInfo, nullptr, &view) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create mip level view!");
+		}
+		Views.push_back(view);
+		return view;
+	}
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,409 @@
+//-----------------------------------------------------------------------------
+#include "render/PipelineManager.h"
+#include "render/Hash.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	const size_t GraphicsPipelineDesc::Hash() const
+	{
+		size_t seed = Stages.size();
+		for (const auto& stage : Stages)
+		{
+			HashCombine(seed, static_cast<size_t>(stage.Stage));
+			HashCombine(seed, HashHandle(stage.Module));
+			for (const auto& constant : stage.Constants)
+			{
+				HashCombine(seed, constant.Id);
+				HashCombine(seed, constant.Value);
+			}
+		}
+		for (const auto& binding : VertexBindings)
+		{
+			HashCombine(seed, binding.binding);
+			HashCombine(seed, binding.stride);
+			HashCombine(seed, static_cast<size_t>(binding.inputRate));
+		}
+		for (const auto& attribute : VertexAttributes)
+		{
+			HashCombine(seed, attribute.location);
+			HashCombine(seed, attribute.binding);
+			HashCombine(seed, static_cast<size_t>(attribute.format));
+			HashCombine(seed, attribute.offset);
+		}
+		HashCombine(seed, static_cast<size_t>(Topology));
+		HashCombine(seed, static_cast<size_t>(PolygonMode));
+		HashCombine(seed, CullMode);
+		HashCombine(seed, static_cast<size_t>(FrontFace));
+		HashCombine(seed, BlendEnable ? 1 : 0);
+		HashCombine(seed, Extent.width);
+		HashCombine(seed, Extent.height);
+		HashCombine(seed, HashHandle(Layout));
+		HashCombine(seed, HashHandle(RenderPass));
+		HashCombine(seed, Subpass);
+		return seed;
+	}
+	//-----------------------------------------------------------------------------
+	bool GraphicsPipelineDesc::operator==(const GraphicsPipelineDesc& other) const
+	{
+		if (Stages.size() != other.Stages.size() || VertexBindings.size() != other.VertexBindings.size() || VertexAttributes.size() != other.VertexAttributes.size())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < Stages.size(); i++)
+		{
+			if (Stages[i].Stage != other.Stages[i].Stage || Stages[i].Module != other.Stages[i].Module || Stages[i].Constants.size() != other.Stages[i].Constants.size())
+			{
+				return false;
+			}
+			for (size_t c = 0; c < Stages[i].Constants.size(); c++)
+			{
+				if (Stages[i].Constants[c].Id != other.Stages[i].Constants[c].Id || Stages[i].Constants[c].Value != other.Stages[i].Constants[c].Value)
+				{
+					return false;
+				}
+			}
+		}
+		for (size_t i = 0; i < VertexBindings.size(); i++)
+		{
+			const VkVertexInputBindingDescription& a = VertexBindings[i];
+			const VkVertexInputBindingDescription& b = other.VertexBindings[i];
+			if (a.binding != b.binding || a.stride != b.stride || a.inputRate != b.inputRate)
+			{
+				return false;
+			}
+		}
+		for (size_t i = 0; i < VertexAttributes.size(); i++)
+		{
+			const VkVertexInputAttributeDescription& a = VertexAttributes[i];
+			const VkVertexInputAttributeDescription& b = other.VertexAttributes[i];
+			if (a.location != b.location || a.binding != b.binding || a.format != b.format || a.offset != b.offset)
+			{
+				return false;
+			}
+		}
+		return Topology == other.Topology
+			&& PolygonMode == other.PolygonMode
+			&& CullMode == other.CullMode
+			&& FrontFace == other.FrontFace
+			&& BlendEnable == other.BlendEnable
+			&& Extent.width == other.Extent.width
+			&& Extent.height == other.Extent.height
+			&& Layout == other.Layout
+			&& RenderPass == other.RenderPass
+			&& Subpass == other.Subpass;
+	}
+	//-----------------------------------------------------------------------------
+	PipelineManager::PipelineManager(VkDevice device, core::JobSystem& jobs)
+		: Device(device)
+		, Jobs(jobs)
+		, Compiled(0)
+		, Failed(0)
+		, CompileMicroseconds(0)
+	{
+		// Internally synchronized, every worker compiles through the same one
+		VkPipelineCacheCreateInfo cacheInfo	= {};
+		cacheInfo.sType						= VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+		if (vkCreatePipelineCache(Device, &cacheInfo, nullptr, &Cache) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create pipeline cache!");
+		}
+	}
+	//-----------------------------------------------------------------------------
+	PipelineManager::~PipelineManager()
+	{
+		Clear();
+		vkDestroyPipelineCache(Device, Cache, nullptr);
+	}
+	//-----------------------------------------------------------------------------
+	PipelineHandle PipelineManager::Insert(const GraphicsPipelineDesc& desc, PipelineHandle fallback, Entry*& created)
+	{
+		std::lock_guard<std::mutex> lock(Lock);
+		Stats.Requests++;
+		created = nullptr;
+
+		auto found = Lookup.find(desc);
+		if (found != Lookup.end())
+		{
+			Stats.Hits++;
+			return found->second;
+		}
+
+		PipelineHandle handle = static_cast<PipelineHandle>(Entries.size());
+		Entries.emplace_back(new Entry());
+		created = Entries.back().get();
+		created->Desc = desc;
+		created->Fallback = fallback;
+		created->Status.store(PipelineStatus::Pending, std::memory_order_relaxed);
+		Lookup.emplace(desc, handle);
+		return handle;
+	}
+	//-----------------------------------------------------------------------------
+	PipelineHandle PipelineManager::Request(const GraphicsPipelineDesc& desc, PipelineHandle fallback)
+	{
+		Entry* created;
+		PipelineHandle handle = Insert(desc, fallback, created);
+		if (created != nullptr)
+		{
+			Jobs.Run([this, created]() { Compile(*created); }, &InFlight);
+		}
+		return handle;
+	}
+	//-----------------------------------------------------------------------------
+	PipelineHandle PipelineManager::RequestNow(const GraphicsPipelineDesc& desc)
+	{
+		Entry* created;
+		PipelineHandle handle = Insert(desc, InvalidPipelineHandle, created);
+		if (created != nullptr)
+		{
+			Compile(*created);
+		}
+		else if (GetStatus(handle) == PipelineStatus::Pending)
+		{
+			// Asked for asynchronously before, now it is needed right away
+			Jobs.Wait(InFlight);
+		}
+
+		if (GetStatus(handle) != PipelineStatus::Ready)
+		{
+			throw std::runtime_error("failed to create graphics pipeline!");
+		}
+		return handle;
+	}
+	//-----------------------------------------------------------------------------
+	const PipelineManager::Entry* PipelineManager::Find(PipelineHandle handle) const
+	{
+		std::lock_guard<std::mutex> lock(Lock);
+		return handle < Entries.size() ? Entries[handle].get() : nullptr;
+	}
+	//-----------------------------------------------------------------------------
+	const PipelineStatus PipelineManager::GetStatus(PipelineHandle handle) const
+	{
+		const Entry* entry = Find(handle);
+		return entry != nullptr ? entry->Status.load(std::memory_order_acquire) : PipelineStatus::Failed;
+	}
+	//-----------------------------------------------------------------------------
+	const PipelineHandle PipelineManager::Resolve(PipelineHandle handle) const
+	{
+		const Entry* entry = Find(handle);
+		if (entry == nullptr)
+		{
+			return InvalidPipelineHandle;
+		}
+		if (entry->Status.load(std::memory_order_acquire) == PipelineStatus::Ready)
+		{
+			return handle;
+		}
+		return GetStatus(entry->Fallback) == PipelineStatus::Ready ? entry->Fallback : InvalidPipelineHandle;
+	}
+	//-----------------------------------------------------------------------------
+	VkPipeline PipelineManager::GetPipeline(PipelineHandle handle) const
+	{
+		const Entry* entry = Find(handle);
+		if (entry == nullptr || entry->Status.load(std::memory_order_acquire) != PipelineStatus::Ready)
+		{
+			return VK_NULL_HANDLE;
+		}
+		return entry->Pipeline;
+	}
+	//-----------------------------------------------------------------------------
+	void PipelineManager::WaitIdle()
+	{
+		Jobs.Wait(InFlight);
+	}
+	//-----------------------------------------------------------------------------
+	void PipelineManager::Clear()
+	{
+		VkDevice device = Device;
+		Clear([device](VkPipeline pipeline) { vkDestroyPipeline(device, pipeline, nullptr); });
+	}
+	//-----------------------------------------------------------------------------
+	void PipelineManager::Clear(const std::function<void(VkPipeline)>& retire)
+	{
+		WaitIdle();
+
+		std::lock_guard<std::mutex> lock(Lock);
+		for (const auto& entry : Entries)
+		{
+			if (entry->Pipeline != VK_NULL_HANDLE)
+			{
+				retire(entry->Pipeline);
+			}
+		}
+		Entries.clear();
+		Lookup.clear();
+	}
+	//-----------------------------------------------------------------------------
+	void PipelineManager::Forget(VkShaderModule module)
+	{
+		bool compiling = false;
+		{
+			std::lock_guard<std::mutex> lock(Lock);
+			for (auto it = Lookup.begin(); it != Lookup.end();)
+			{
+				const std::vector<PipelineShaderStage>& stages = it->first.Stages;
+				if (std::none_of(stages.begin(), stages.end(), [module](const PipelineShaderStage& stage) { return stage.Module == module; }))
+				{
+					++it;
+					continue;
+				}
+				compiling |= Entries[it->second]->Status.load(std::memory_order_acquire) == PipelineStatus::Pending;
+				it = Lookup.erase(it);
+			}
+		}
+		// Their compiles still read the module
+		if (compiling)
+		{
+			WaitIdle();
+		}
+	}
+	//-----------------------------------------------------------------------------
+	const PipelineManagerStats PipelineManager::GetStats() const
+	{
+		std::lock_guard<std::mutex> lock(Lock);
+		PipelineManagerStats stats	= Stats;
+		stats.Compiled				= Compiled.load(std::memory_order_relaxed);
+		stats.Failed				= Failed.load(std::memory_order_relaxed);
+		stats.CompileMs				= static_cast<float>(CompileMicroseconds.load(std::memory_order_relaxed)) / 1000.0f;
+		return stats;
+	}
+	//-----------------------------------------------------------------------------
+	void PipelineManager::Compile(Entry& entry)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		const GraphicsPipelineDesc& desc = entry.Desc;
+
+		// Every spec constant is 32 bits, packed back to back in the data blob
+		std::vector<std::vector<VkSpecializationMapEntry>> mapEntries(desc.Stages.size());
+		std::vector<VkSpecializationInfo> specializationInfos(desc.Stages.size());
+		std::vector<std::vector<uint32_t>> specializationData(desc.Stages.size());
+		std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+		for (size_t i = 0; i < desc.Stages.size(); i++)
+		{
+			const PipelineShaderStage& stage = desc.Stages[i];
+
+			VkPipelineShaderStageCreateInfo stageInfo	= {};
+			stageInfo.sType								= VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			stageInfo.stage								= stage.Stage;
+			stageInfo.module							= stage.Module;
+			stageInfo.pName								= "main";
+
+			if (!stage.Constants.empty())
+			{
+				for (const auto& constant : stage.Constants)
+				{
+					uint32_t offset = static_cast<uint32_t>(specializationData[i].size() * sizeof(uint32_t));
+					mapEntries[i].push_back({ constant.Id, offset, sizeof(uint32_t) });
+					specializationData[i].push_back(constant.Value);
+				}
+				VkSpecializationInfo& specialization	= specializationInfos[i];
+				specialization.mapEntryCount			= static_cast<uint32_t>(mapEntries[i].size());
+				specialization.pMapEntries				= mapEntries[i].data();
+				specialization.dataSize					= specializationData[i].size() * sizeof(uint32_t);
+				specialization.pData					= specializationData[i].data();
+				stageInfo.pSpecializationInfo			= &specialization;
+			}
+			shaderStages.push_back(stageInfo);
+		}
+
+		VkPipelineVertexInputStateCreateInfo vertexInputInfo	= {};
+		vertexInputInfo.sType									= VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+		vertexInputInfo.vertexBindingDescriptionCount			= static_cast<uint32_t>(desc.VertexBindings.size());
+		vertexInputInfo.pVertexBindingDescriptions				= desc.VertexBindings.data();
+		vertexInputInfo.vertexAttributeDescriptionCount			= static_cast<uint32_t>(desc.VertexAttributes.size());
+		vertexInputInfo.pVertexAttributeDescriptions			= desc.VertexAttributes.data();
+
+		VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo	= {};
+		inputAssemblyInfo.sType										= VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		inputAssemblyInfo.topology									= desc.Topology;
+		inputAssemblyInfo.primitiveRestartEnable					= VK_FALSE;
+
+		VkViewport viewport	= {};
+		viewport.width		= (float)desc.Extent.width;
+		viewport.height		= (float)desc.Extent.height;
+		viewport.minDepth	= 0.0f;
+		viewport.maxDepth	= 1.0f;
+
+		VkRect2D scissor	= {};
+		scissor.extent		= desc.Extent;
+
+		VkPipelineViewportStateCreateInfo viewportStateInfo	= {};
+		viewportStateInfo.sType								= VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		viewportStateInfo.viewportCount						= 1;
+		viewportStateInfo.pViewports						= &viewport;
+		viewportStateInfo.scissorCount						= 1;
+		viewportStateInfo.pScissors							= &scissor;
+
+		VkPipelineRasterizationStateCreateInfo rasterizerInfo	= {};
+		rasterizerInfo.sType									= VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		rasterizerInfo.polygonMode								= desc.PolygonMode;
+		rasterizerInfo.lineWidth								= 1.0f;
+		rasterizerInfo.cullMode									= desc.CullMode;
+		rasterizerInfo.frontFace								= desc.FrontFace;
+
+		VkPipelineMultisampleStateCreateInfo multisamplingInfo	= {};
+		multisamplingInfo.sType									= VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		multisamplingInfo.rasterizationSamples					= VK_SAMPLE_COUNT_1_BIT;
+
+		VkPipelineColorBlendAttachmentState colorBlendAttachmentState = {};
+		colorBlendAttachmentState.colorWriteMask =	  VK_COLOR_COMPONENT_R_BIT
+													| VK_COLOR_COMPONENT_G_BIT
+													| VK_COLOR_COMPONENT_B_BIT
+													| VK_COLOR_COMPONENT_A_BIT;
+		colorBlendAttachmentState.blendEnable = desc.BlendEnable ? VK_TRUE : VK_FALSE;
+		if (desc.BlendEnable)
+		{
+			colorBlendAttachmentState.srcColorBlendFactor	= VK_BLEND_FACTOR_SRC_ALPHA;
+			colorBlendAttachmentState.dstColorBlendFactor	= VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+			colorBlendAttachmentState.colorBlendOp			= VK_BLEND_OP_ADD;
+			colorBlendAttachmentState.srcAlphaBlendFactor	= VK_BLEND_FACTOR_ONE;
+			colorBlendAttachmentState.dstAlphaBlendFactor	= VK_BLEND_FACTOR_ZERO;
+			colorBlendAttachmentState.alphaBlendOp			= VK_BLEND_OP_ADD;
+		}
+
+		VkPipelineColorBlendStateCreateInfo colorBlendingInfo	= {};
+		colorBlendingInfo.sType									= VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		colorBlendingInfo.logicOp								= VK_LOGIC_OP_COPY;
+		colorBlendingInfo.attachmentCount						= 1;
+		colorBlendingInfo.pAttachments							= &colorBlendAttachmentState;
+
+		VkGraphicsPipelineCreateInfo pipelineInfo	= {};
+		pipelineInfo.sType							= VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.stageCount						= static_cast<uint32_t>(shaderStages.size());
+		pipelineInfo.pStages						= shaderStages.data();
+		pipelineInfo.pVertexInputState				= &vertexInputInfo;
+		pipelineInfo.pInputAssemblyState			= &inputAssemblyInfo;
+		pipelineInfo.pViewportState					= &viewportStateInfo;
+		pipelineInfo.pRasterizationState			= &rasterizerInfo;
+		pipelineInfo.pMultisampleState				= &multisamplingInfo;
+		pipelineInfo.pColorBlendState				= &colorBlendingInfo;
+		pipelineInfo.layout							= desc.Layout;
+		pipelineInfo.renderPass						= desc.RenderPass;
+		pipelineInfo.subpass						= desc.Subpass;
+		pipelineInfo.basePipelineHandle				= VK_NULL_HANDLE;
+
+		// Runs on a worker, failures are reported through the status instead of thrown
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		VkResult result = vkCreateGraphicsPipelines(Device, Cache, 1, &pipelineInfo, nullptr, &pipeline);
+
+		uint64_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+		CompileMicroseconds.fetch_add(elapsed, std::memory_order_relaxed);
+
+		if (result != VK_SUCCESS)
+		{
+			std::cerr << "failed to create graphics pipeline (" << result << ")" << std::endl;
+			Failed.fetch_add(1, std::memory_order_relaxed);
+			entry.Status.store(PipelineStatus::Failed, std::memory_order_release);
+			return;
+		}
+		entry.Pipeline = pipeline;
+		Compiled.fetch_add(1, std::memory_order_relaxed);
+		entry.Status.store(PipelineStatus::Ready, std::memory_order_release);
+	}
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,75 @@
+//-----------------------------------------------------------------------------
+#include "render/PresentPolicy.h"
+#include <algorithm>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	const float PresentPolicy::DefaultPowerSavingCap = 30.0f;
+	//-----------------------------------------------------------------------------
+	const bool PresentPolicy::ParseProfile(const std::string& name, PresentProfile& profile)
+	{
+		if (name == "lowest-latency")
+		{
+			profile = PresentProfile::LowestLatency;
+		}
+		else if (name == "power-saving")
+		{
+			profile = PresentProfile::PowerSaving;
+		}
+		else if (name == "fifo-relaxed")
+		{
+			profile = PresentProfile::FifoRelaxed;
+		}
+		else
+		{
+			return false;
+		}
+		return true;
+	}
+	//-----------------------------------------------------------------------------
+	const char* PresentPolicy::GetProfileName(PresentProfile profile)
+	{
+		switch (profile)
+		{
+		case PresentProfile::PowerSaving:	return "power-saving";
+		case PresentProfile::FifoRelaxed:	return "fifo-relaxed";
+		default:							return "lowest-latency";
+		}
+	}
+	//-----------------------------------------------------------------------------
+	const VkPresentModeKHR PresentPolicy::ChoosePresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) const
+	{
+		std::vector<VkPresentModeKHR> preferred;
+		switch (Profile)
+		{
+		case PresentProfile::LowestLatency:
+			preferred = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR };
+			break;
+		case PresentProfile::FifoRelaxed:
+			preferred = { VK_PRESENT_MODE_FIFO_RELAXED_KHR };
+			break;
+		case PresentProfile::PowerSaving:
+			break;
+		}
+
+		for (VkPresentModeKHR mode : preferred)
+		{
+			if (std::find(availablePresentModes.begin(), availablePresentModes.end(), mode) != availablePresentModes.end())
+			{
+				return mode;
+			}
+		}
+		return VK_PRESENT_MODE_FIFO_KHR;
+	}
+	//-----------------------------------------------------------------------------
+	const double PresentPolicy::GetFrameIntervalMs() const
+	{
+		float cap = FrameCap;
+		if (cap <= 0.0f && Profile == PresentProfile::PowerSaving)
+		{
+			cap = DefaultPowerSavingCap;
+		}
+		return cap > 0.0f ? 1000.0 / cap : 0.0;
+	}
+}
+//-----------------------------------------------------------------------------
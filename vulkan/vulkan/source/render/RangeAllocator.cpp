@@ -0,0 +1,109 @@
+//-----------------------------------------------------------------------------
+#include "render/RangeAllocator.h"
+#include <algorithm>
+#include <iterator>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+	//-----------------------------------------------------------------------------
+	RangeAllocator::RangeAllocator(VkDeviceSize size)
+		: Size(size)
+	{
+		if (size > 0)
+		{
+			FreeRanges[0] = size;
+		}
+	}
+	//-----------------------------------------------------------------------------
+	const bool RangeAllocator::Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+	{
+		alignment = std::max<VkDeviceSize>(alignment, 1);
+		auto best = FreeRanges.end();
+		for (auto it = FreeRanges.begin(); it != FreeRanges.end(); ++it)
+		{
+			VkDeviceSize aligned = AlignUp(it->first, alignment);
+			if (aligned + size <= it->first + it->second && (best == FreeRanges.end() || it->second < best->second))
+			{
+				best = it;
+			}
+		}
+		if (best == FreeRanges.end())
+		{
+			return false;
+		}
+
+		offset = AlignUp(best->first, alignment);
+		Take(best, offset, size);
+		return true;
+	}
+	//-----------------------------------------------------------------------------
+	const bool RangeAllocator::AllocateBelow(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize limit, VkDeviceSize& offset)
+	{
+		alignment = std::max<VkDeviceSize>(alignment, 1);
+		for (auto it = FreeRanges.begin(); it != FreeRanges.end() && it->first < limit; ++it)
+		{
+			VkDeviceSize aligned = AlignUp(it->first, alignment);
+			if (aligned + size <= it->first + it->second && aligned + size <= limit)
+			{
+				offset = aligned;
+				Take(it, offset, size);
+				return true;
+			}
+		}
+		return false;
+	}
+	//-----------------------------------------------------------------------------
+	void RangeAllocator::Take(std::map<VkDeviceSize, VkDeviceSize>::iterator range, VkDeviceSize offset, VkDeviceSize size)
+	{
+		VkDeviceSize rangeStart	= range->first;
+		VkDeviceSize rangeEnd	= range->first + range->second;
+		FreeRanges.erase(range);
+
+		// Alignment padding in front and the tail stay free
+		if (offset > rangeStart)
+		{
+			FreeRanges[rangeStart] = offset - rangeStart;
+		}
+		if (offset + size < rangeEnd)
+		{
+			FreeRanges[offset + size] = rangeEnd - offset - size;
+		}
+		Used += size;
+	}
+	//-----------------------------------------------------------------------------
+	void RangeAllocator::Free(VkDeviceSize offset, VkDeviceSize size)
+	{
+		Used -= size;
+		auto next = FreeRanges.lower_bound(offset);
+		if (next != FreeRanges.end() && offset + size == next->first)
+		{
+			size += next->second;
+			next = FreeRanges.erase(next);
+		}
+		if (next != FreeRanges.begin())
+		{
+			auto previous = std::prev(next);
+			if (previous->first + previous->second == offset)
+			{
+				previous->second += size;
+				return;
+			}
+		}
+		FreeRanges[offset] = size;
+	}
+	//-----------------------------------------------------------------------------
+	const VkDeviceSize RangeAllocator::GetLargestFree() const
+	{
+		VkDeviceSize largest = 0;
+		for (const auto& range : FreeRanges)
+		{
+			largest = std::max(largest, range.second);
+		}
+		return largest;
+	}
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,688 @@
+//-----------------------------------------------------------------------------
+#include "render/RenderGraph.h"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	static const VkAccessFlags WriteAccessMask = VK_ACCESS_SHADER_WRITE_BIT
+												| VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+												| VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+												| VK_ACCESS_TRANSFER_WRITE_BIT
+												| VK_ACCESS_HOST_WRITE_BIT
+												| VK_ACCESS_MEMORY_WRITE_BIT;
+	//-----------------------------------------------------------------------------
+	static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+	}
+	//-----------------------------------------------------------------------------
+	ResourceHandle PassBuilder::Create(const std::string& name, const ImageDesc& desc)
+	{
+		return Graph.CreateTransient(name, desc);
+	}
+	//-----------------------------------------------------------------------------
+	ResourceHandle PassBuilder::Read(ResourceHandle resource, ResourceUsage usage)
+	{
+		Graph.AddAccess(PassIndex, resource, usage, false);
+		return resource;
+	}
+	//-----------------------------------------------------------------------------
+	ResourceHandle PassBuilder::Write(ResourceHandle resource, ResourceUsage usage)
+	{
+		Graph.AddAccess(PassIndex, resource, usage, true);
+		return resource;
+	}
+	//-----------------------------------------------------------------------------
+	void PassBuilder::SetSideEffect()
+	{
+		Graph.Passes[PassIndex].SideEffect = true;
+	}
+	//-----------------------------------------------------------------------------
+	RenderGraph::RenderGraph(VkDevice device, MemoryTypeFinder findMemoryType)
+		: Device(device)
+		, FindMemoryType(findMemoryType)
+	{
+	}
+	//-----------------------------------------------------------------------------
+	RenderGraph::~RenderGraph()
+	{
+		ReleaseTransients();
+	}
+	//-----------------------------------------------------------------------------
+	ResourceHandle RenderGraph::ImportImage(const std::string& name, VkImage image, VkImageView view, const ImageDesc& desc, const ImageState& initialState)
+	{
+		Resource resource;
+		resource.Name		= name;
+		resource.Desc		= desc;
+		resource.Imported	= true;
+		resource.Initial	= initialState;
+		resource.Image		= image;
+		resource.View		= view;
+		Resources.push_back(resource);
+		return static_cast<ResourceHandle>(Resources.size() - 1);
+	}
+	//-----------------------------------------------------------------------------
+	void RenderGraph::AddPass(const std::string& name, SetupFunction setup, ExecuteFunction execute)
+	{
+		Pass pass;
+		pass.Name		= name;
+		pass.Execute	= execute;
+		Passes.push_back(pass);
+
+		PassBuilder builder(*this, static_cast<uint32_t>(Passes.size() - 1));
+		setup(builder);
+	}
+	//-----------------------------------------------------------------------------
+	void RenderGraph::MarkOutput(ResourceHandle resource, const ImageState& finalState)
+	{
+		Resources.at(resource).IsOutput	= true;
+		Resources.at(resource).Final	= finalState;
+	}
+	//-----------------------------------------------------------------------------
+	void RenderGraph::Compile()
+	{
+		Stats = RenderGraphStats();
+		Stats.DeclaredPasses = static_cast<uint32_t>(Passes.size());
+
+		CullPasses();
+
+		CompiledPasses.clear();
+		for (uint32_t i = 0; i < Passes.size(); i++)
+		{
+			if (!Passes[i].Culled)
+			{
+				CompiledPasses.push_back({ i, BarrierBatch() });
+			}
+		}
+		Stats.CulledPasses = Stats.DeclaredPasses - static_cast<uint32_t>(CompiledPasses.size());
+
+		ComputeLifetimes();
+		AllocateTransients();
+		BuildBarriers();
+	}
+	//-----------------------------------------------------------------------------
+	void RenderGraph::Execute(VkCommandBuffer commandBuffer) const
+	{
+		auto emit = [commandBuffer](const BarrierBatch& batch)
+		{
+			if (batch.Barriers.empty())
+			{
+				return;
+			}
+			vkCmdPipelineBarrier(commandBuffer, batch.SrcStage, batch.DstStage, 0,
+								0, nullptr, 0, nullptr,
+								static_cast<uint32_t>(batch.Barriers.size()), batch.Barriers.data());
+		};
+
+		PassContext context = { commandBuffer, this };
+		for (const auto& compiledPass : CompiledPasses)
+		{
+			emit(compiledPass.Before);
+			const Pass& pass = Passes[compiledPass.PassIndex];
+			if (pass.Execute)
+			{
+				pass.Execute(context);
+			}
+		}
+		emit(FinalBarriers);
+	}
+	//-----------------------------------------------------------------------------
+	void RenderGraph::Reset()
+	{
+		Passes.clear();
+		Resources.clear();
+		CompiledPasses.clear();
+		FinalBarriers = BarrierBatch();
+		TransientOrder.clear();
+		Stats = RenderGraphStats();
+	}
+	//-----------------------------------------------------------------------------
+	void RenderGraph::ReleaseTransients()
+	{
+		for (auto& transient : Transients)
+		{
+			vkDestroyImageView(Device, transient.View, nullptr);
+			vkDestroyImage(Device, transient.Image, nullptr);
+		}
+		Transients.clear();
+
+		for (auto& block : Blocks)
+		{
+			vkFreeMemory(Device, block.Memory, nullptr);
+		}
+		Blocks.clear();
+	}
+	//-----------------------------------------------------------------------------
+	VkImage RenderGraph::GetImage(ResourceHandle resource) const
+	{
+		return Resources.at(resource).Image;
+	}
+	//-----------------------------------------------------------------------------
+	VkImageView RenderGraph::GetImageView(ResourceHandle resource) const
+	{
+		return Resources.at(resource).View;
+	}
+	//-----------------------------------------------------------------------------
+	const ImageDesc& RenderGraph::GetDesc(ResourceHandle resource) const
+	{
+		return Resources.at(resource).Desc;
+	}
+	//-----------------------------------------------------------------------------
+	const RenderGraph::UsageInfo RenderGraph::GetUsageInfo(ResourceUsage usage)
+	{
+		switch (usage)
+		{
+		case ResourceUsage::ColorAttachment:
+			return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+					VK_ACCESS_COLOR_ATTACHMENT_READ_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+					VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT };
+		case ResourceUsage::DepthAttachment:
+			return { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+					VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+					VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT };
+		case ResourceUsage::DepthRead:
+			return { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+					VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_SHADER_READ_BIT, 0,
+					VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT };
+		case ResourceUsage::FragmentRead:
+			return { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+					VK_ACCESS_SHADER_READ_BIT, 0,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT };
+		case ResourceUsage::ComputeRead:
+			return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					VK_ACCESS_SHADER_READ_BIT, 0,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT };
+		case ResourceUsage::ComputeWrite:
+			return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+					VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT };
+		case ResourceUsage::TransferSrc:
+			return { VK_PIPELINE_STAGE_TRANSFER_BIT,
+					VK_ACCESS_TRANSFER_READ_BIT, 0,
+					VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT };
+		case ResourceUsage::TransferDst:
+			return { VK_PIPELINE_STAGE_TRANSFER_BIT,
+					0, VK_ACCESS_TRANSFER_WRITE_BIT,
+					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT };
+		}
+		throw std::runtime_error("unknown render graph resource usage!");
+	}
+	//-----------------------------------------------------------------------------
+	ResourceHandle RenderGraph::CreateTransient(const std::string& name, const ImageDesc& desc)
+	{
+		Resource resource;
+		resource.Name = name;
+		resource.Desc = desc;
+		Resources.push_back(resource);
+		return static_cast<ResourceHandle>(Resources.size() - 1);
+	}
+	//-----------------------------------------------------------------------------
+	void RenderGraph::AddAccess(uint32_t passIndex, ResourceHandle resource, ResourceUsage usage, bool isWrite)
+	{
+		if (resource >= Resources.size())
+		{
+			throw std::runtime_error("render graph pass " + Passes[passIndex].Name + " uses an unknown resource!");
+		}
+		Passes[passIndex].Accesses.push_back({ resource, usage, isWrite });
+	}
+	//-----------------------------------------------------------------------------
+	// Reference counting cull: a pass survives when something it writes is read
+	// by a surviving pass or is a graph output.
+	void RenderGraph::CullPasses()
+	{
+		for (auto& resource : Resources)
+		{
+			resource.Producers.clear();
+			resource.RefCount = resource.IsOutput ? 1 : 0;
+		}
+
+		for (uint32_t passIndex = 0; passIndex < Passes.size(); passIndex++)
+		{
+			Pass& pass = Passes[passIndex];
+			pass.Culled = false;
+			pass.RefCount = 0;
+
+			std::vector<ResourceHandle> written, read;
+			for (const auto& access : pass.Accesses)
+			{
+				std::vector<ResourceHandle>& list = access.IsWrite ? written : read;
+				if (std::find(list.begin(), list.end(), access.Resource) == list.end())
+				{
+					list.push_back(access.Resource);
+				}
+			}
+			for (ResourceHandle resource : written)
+			{
+				Resources[resource].Producers.push_back(passIndex);
+				pass.RefCount++;
+			}
+			for (ResourceHandle resource : read)
+			{
+				Resources[resource].RefCount++;
+			}
+		}
+
+		std::vector<ResourceHandle> unreferenced;
+		for (ResourceHandle i = 0; i < Resources.size(); i++)
+		{
+			if (Resources[i].RefCount == 0)
+			{
+				unreferenced.push_back(i);
+			}
+		}
+
+		while (!unreferenced.empty())
+		{
+			ResourceHandle handle = unreferenced.back();
+			unreferenced.pop_back();
+
+			for (uint32_t passIndex : Resources[handle].Producers)
+			{
+				Pass& producer = Passes[passIndex];
+				if (producer.RefCount == 0 || --producer.RefCount > 0 || producer.SideEffect)
+				{
+					continue;
+				}
+
+				producer.Culled = true;
+				for (const auto& access : producer.Accesses)
+				{
+					if (!access.IsWrite && Resources[access.Resource].RefCount > 0 && --Resources[access.Resource].RefCount == 0)
+					{
+						unreferenced.push_back(access.Resource);
+					}
+				}
+			}
+		}
+
+		// Passes that write nothing at all only survive as side effects
+		for (auto& pass : Passes)
+		{
+			if (pass.RefCount == 0 && !pass.SideEffect)
+			{
+				pass.Culled = true;
+			}
+		}
+	}
+	//-----------------------------------------------------------------------------
+	void RenderGraph::ComputeLifetimes()
+	{
+		for (auto& resource : Resources)
+		{
+			resource.FirstUse	= ~0u;
+			resource.LastUse	= 0;
+			resource.Usage		= resource.Desc.ExtraUsage;
+		}
+
+		for (uint32_t order = 0; order < CompiledPasses.size(); order++)
+		{
+			for (const auto& access : Passes[CompiledPasses[order].PassIndex].Accesses)
+			{
+				Resource& resource	= Resources[access.Resource];
+				resource.FirstUse	= std::min(resource.FirstUse, order);
+				resource.LastUse	= std::max(resource.LastUse, order);
+				resource.Usage		|= GetUsageInfo(access.Usage).ImageUsage;
+			}
+		}
+	}
+	//-----------------------------------------------------------------------------
+	const bool RenderGraph::TransientLayoutMatches() const
+	{
+		if (Transients.size() != TransientOrder.size())
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < Transients.size(); i++)
+		{
+			const TransientImage& transient = Transients[i];
+			const Resource& resource = Resources[TransientOrder[i]];
+			if (transient.Desc.Format != resource.Desc.Format ||
+				transient.Desc.Extent.width != resource.Desc.Extent.width ||
+				transient.Desc.Extent.height != resource.Desc.Extent.height ||
+				transient.Desc.Aspect != resource.Desc.Aspect ||
+				transient.Desc.MipLevels != resource.Desc.MipLevels ||
+				transient.Usage != resource.Usage ||
+				transient.FirstUse != resource.FirstUse ||
+				transient.LastUse != resource.LastUse)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	//-----------------------------------------------------------------------------
+	void RenderGraph::AllocateTransients()
+	{
+		TransientOrder.clear();
+		for (ResourceHandle i = 0; i < Resources.size(); i++)
+		{
+			if (!Resources[i].Imported && Resources[i].FirstUse != ~0u)
+			{
+				TransientOrder.push_back(i);
+			}
+		}
+
+		if (!TransientLayoutMatches())
+		{
+			ReleaseTransients();
+
+			std::vector<VkMemoryRequirements> requirements(TransientOrder.size());
+			for (size_t i = 0; i < TransientOrder.size(); i++)
+			{
+				const Resource& resource = Resources[TransientOrder[i]];
+
+				VkImageCreateInfo imageInfo	= {};
+				imageInfo.sType				= VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+				imageInfo.imageType			= VK_IMAGE_TYPE_2D;
+				imageInfo.format			= resource.Desc.Format;
+				imageInfo.extent			= { resource.Desc.Extent.width, resource.Desc.Extent.height, 1 };
+				imageInfo.mipLevels			= resource.Desc.MipLevels;
+				imageInfo.arrayLayers		= 1;
+				imageInfo.samples			= VK_SAMPLE_COUNT_1_BIT;
+				imageInfo.tiling			= VK_IMAGE_TILING_OPTIMAL;
+				imageInfo.usage				= resource.Usage;
+				imageInfo.sharingMode		= VK_SHARING_MODE_EXCLUSIVE;
+				imageInfo.initialLayout		= VK_IMAGE_LAYOUT_UNDEFINED;
+
+				TransientImage transient	= {};
+				transient.Desc				= resource.Desc;
+				transient.Usage				= resource.Usage;
+				transient.FirstUse			= resource.FirstUse;
+				transient.LastUse			= resource.LastUse;
+				if (vkCreateImage(Device, &imageInfo, nullptr, &transient.Image) != VK_SUCCESS)
+				{
+					throw std::runtime_error("failed to create transient image " + resource.Name + "!");
+				}
+				vkGetImageMemoryRequirements(Device, transient.Image, &requirements[i]);
+				transient.Size = requirements[i].size;
+				Transients.push_back(transient);
+			}
+
+			// Biggest first, each one goes to the lowest offset that does not
+			// collide with a transient alive at the same time
+			std::vector<size_t> placementOrder(Transients.size());
+			std::iota(placementOrder.begin(), placementOrder.end(), size_t(0));
+			std::sort(placementOrder.begin(), placementOrder.end(), [&](size_t a, size_t b)
+			{
+				return requirements[a].size > requirements[b].size;
+			});
+
+			std::vector<size_t> placed;
+			for (size_t index : placementOrder)
+			{
+				TransientImage& transient = Transients[index];
+				uint32_t memoryType = FindMemoryType(requirements[index].memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+				uint32_t blockIndex = 0;
+				while (blockIndex < Blocks.size() && Blocks[blockIndex].MemoryTypeIndex != memoryType)
+				{
+					blockIndex++;
+				}
+				if (blockIndex == Blocks.size())
+				{
+					Blocks.push_back({ memoryType, 0, VK_NULL_HANDLE });
+				}
+
+				std::vector<size_t> conflicts;
+				for (size_t other : placed)
+				{
+					const TransientImage& otherTransient = Transients[other];
+					bool overlapInTime = !(otherTransient.LastUse < transient.FirstUse || transient.LastUse < otherTransient.FirstUse);
+					if (otherTransient.Block == blockIndex && overlapInTime)
+					{
+						conflicts.push_back(other);
+					}
+				}
+
+				std::vector<VkDeviceSize> candidates(1, 0);
+				for (size_t other : conflicts)
+				{
+					candidates.push_back(AlignUp(Transients[other].Offset + Transients[other].Size, requirements[index].alignment));
+				}
+				std::sort(candidates.begin(), candidates.end());
+
+				VkDeviceSize offset = 0;
+				for (VkDeviceSize candidate : candidates)
+				{
+					bool fits = true;
+					for (size_t other : conflicts)
+					{
+						const TransientImage& otherTransient = Transients[other];
+						if (candidate < otherTransient.Offset + otherTransient.Size && otherTransient.Offset < candidate + transient.Size)
+						{
+							fits = false;
+							break;
+						}
+					}
+					if (fits)
+					{
+						offset = candidate;
+						break;
+					}
+				}
+
+				transient.Block		= blockIndex;
+				transient.Offset	= offset;
+				Blocks[blockIndex].Size = std::max(Blocks[blockIndex].Size, offset + transient.Size);
+				placed.push_back(index);
+			}
+
+			for (auto& block : Blocks)
+			{
+				VkMemoryAllocateInfo allocInfo	= {};
+				allocInfo.sType					= VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+				allocInfo.allocationSize		= block.Size;
+				allocInfo.memoryTypeIndex		= block.MemoryTypeIndex;
+				if (vkAllocateMemory(Device, &allocInfo, nullptr, &block.Memory) != VK_SUCCESS)
+				{
+					throw std::runtime_error("failed to allocate transient attachment memory!");
+				}
+			}
+
+			for (size_t i = 0; i < Transients.size(); i++)
+			{
+				TransientImage& transient = Transients[i];
+				vkBindImageMemory(Device, transient.Image, Blocks[transient.Block].Memory, transient.Offset);
+
+				VkImageViewCreateInfo viewInfo				= {};
+				viewInfo.sType								= VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+				viewInfo.image								= transient.Image;
+				viewInfo.viewType							= VK_IMAGE_VIEW_TYPE_2D;
+				viewInfo.format								= transient.Desc.Format;
+				viewInfo.subresourceRange.aspectMask		= transient.Desc.Aspect;
+				viewInfo.subresourceRange.baseMipLevel		= 0;
+				viewInfo.subresourceRange.levelCount		= transient.Desc.MipLevels;
+				viewInfo.subresourceRange.baseArrayLayer	= 0;
+				viewInfo.subresourceRange.layerCount		= 1;
+				if (vkCreateImageView(Device, &viewInfo, nullptr, &transient.View) != VK_SUCCESS)
+				{
+					throw std::runtime_error("failed to create transient image view!");
+				}
+			}
+		}
+
+		for (size_t i = 0; i < TransientOrder.size(); i++)
+		{
+			Resource& resource		= Resources[TransientOrder[i]];
+			resource.Image			= Transients[i].Image;
+			resource.View			= Transients[i].View;
+			resource.TransientSlot	= static_cast<uint32_t>(i);
+			resource.AliasPredecessors.clear();
+			Stats.TransientBytes	+= Transients[i].Size;
+		}
+
+		// Whoever used the same bytes earlier in the frame has to be finished
+		// before the next occupant writes them
+		for (size_t i = 0; i < Transients.size(); i++)
+		{
+			for (size_t j = 0; j < Transients.size(); j++)
+			{
+				const TransientImage& a = Transients[i];
+				const TransientImage& b = Transients[j];
+				bool sharesMemory = a.Block == b.Block && a.Offset < b.Offset + b.Size && b.Offset < a.Offset + a.Size;
+				if (i != j && sharesMemory && b.LastUse < a.FirstUse)
+				{
+					Resources[TransientOrder[i]].AliasPredecessors.push_back(TransientOrder[j]);
+				}
+			}
+		}
+
+		Stats.TransientImages = static_cast<uint32_t>(Transients.size());
+		for (const auto& block : Blocks)
+		{
+			Stats.AllocatedBytes += block.Size;
+		}
+	}
+	//-----------------------------------------------------------------------------
+	void RenderGraph::BuildBarriers()
+	{
+		for (auto& resource : Resources)
+		{
+			resource.State = TrackedState();
+			if (resource.Imported)
+			{
+				resource.State.Layout		= resource.Initial.Layout;
+				resource.State.WriteStage	= resource.Initial.Stage;
+				resource.State.WriteAccess	= resource.Initial.Access & WriteAccessMask;
+				resource.State.Touched		= true;
+			}
+		}
+
+		for (auto& compiledPass : CompiledPasses)
+		{
+			const Pass& pass = Passes[compiledPass.PassIndex];
+
+			// One transition per image and pass, merging every access to it
+			std::vector<ResourceHandle> handled;
+			for (const auto& access : pass.Accesses)
+			{
+				if (std::find(handled.begin(), handled.end(), access.Resource) != handled.end())
+				{
+					continue;
+				}
+				handled.push_back(access.Resource);
+
+				UsageInfo merged = GetUsageInfo(access.Usage);
+				VkAccessFlags accessMask = merged.ReadAccess | (access.IsWrite ? merged.WriteAccess : 0);
+				bool isWrite = access.IsWrite;
+				for (const auto& other : pass.Accesses)
+				{
+					if (&other == &access || other.Resource != access.Resource)
+					{
+						continue;
+					}
+					UsageInfo info = GetUsageInfo(other.Usage);
+					if (info.Layout != merged.Layout)
+					{
+						throw std::runtime_error("render graph pass " + pass.Name + " needs two layouts for " + Resources[access.Resource].Name + "!");
+					}
+					merged.Stage	|= info.Stage;
+					accessMask		|= info.ReadAccess | (other.IsWrite ? info.WriteAccess : 0);
+					isWrite			= isWrite || other.IsWrite;
+				}
+
+				Transition(Resources[access.Resource], merged.Layout, merged.Stage, accessMask, isWrite, compiledPass.Before);
+			}
+		}
+
+		FinalBarriers = BarrierBatch();
+		for (auto& resource : Resources)
+		{
+			if (resource.IsOutput && resource.State.Touched)
+			{
+				Transition(resource, resource.Final.Layout, resource.Final.Stage, resource.Final.Access, false, FinalBarriers);
+			}
+		}
+	}
+	//-----------------------------------------------------------------------------
+	void RenderGraph::Transition(Resource& resource, VkImageLayout newLayout, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess, bool isWrite, BarrierBatch& batch)
+	{
+		TrackedState& state = resource.State;
+		if (!state.Touched)
+		{
+			// First use of a transient: contents are garbage, but the memory may
+			// still be in use by whatever was aliased on it before
+			state = TrackedState();
+			for (ResourceHandle predecessor : resource.AliasPredecessors)
+			{
+				const TrackedState& previous = Resources[predecessor].State;
+				state.WriteStage	|= previous.WriteStage | previous.ReadStages;
+				state.WriteAccess	|= previous.WriteAccess;
+			}
+			state.Touched = true;
+		}
+
+		bool layoutChange = state.Layout != newLayout;
+		bool needBarrier = layoutChange;
+		VkPipelineStageFlags srcStage = state.WriteStage;
+		VkAccessFlags srcAccess = state.WriteAccess;
+
+		if (isWrite)
+		{
+			// WAW and WAR. Reads since the last write already made it visible,
+			// so only an execution dependency on them is left.
+			if (state.ReadStages != 0)
+			{
+				srcStage	= state.ReadStages;
+				srcAccess	= 0;
+			}
+			needBarrier = needBarrier || srcStage != 0;
+		}
+		else
+		{
+			// RAW, unless an earlier read in the same layout already waited for
+			// the write at this stage
+			bool covered = (state.ReadStages & dstStage) == dstStage && (state.ReadAccess & dstAccess) == dstAccess;
+			needBarrier = needBarrier || (state.WriteStage != 0 && !covered);
+		}
+
+		if (needBarrier)
+		{
+			VkImageMemoryBarrier barrier			= {};
+			barrier.sType							= VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcAccessMask					= srcAccess;
+			barrier.dstAccessMask					= dstAccess;
+			barrier.oldLayout						= state.Layout;
+			barrier.newLayout						= newLayout;
+			barrier.srcQueueFamilyIndex				= VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex				= VK_QUEUE_FAMILY_IGNORED;
+			barrier.image							= resource.Image;
+			barrier.subresourceRange.aspectMask		= resource.Desc.Aspect;
+			barrier.subresourceRange.baseMipLevel	= 0;
+			barrier.subresourceRange.levelCount		= resource.Desc.MipLevels;
+			barrier.subresourceRange.baseArrayLayer	= 0;
+			barrier.subresourceRange.layerCount		= 1;
+
+			batch.Barriers.push_back(barrier);
+			batch.SrcStage |= srcStage != 0 ? srcStage : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			batch.DstStage |= dstStage;
+			Stats.Barriers++;
+		}
+
+		if (isWrite)
+		{
+			state.WriteStage	= dstStage;
+			state.WriteAccess	= dstAccess & WriteAccessMask;
+			state.ReadStages	= 0;
+			state.ReadAccess	= 0;
+		}
+		else if (layoutChange)
+		{
+			// The transition itself is a write later readers must chain on
+			state.WriteStage	= dstStage;
+			state.WriteAccess	= 0;
+			state.ReadStages	= dstStage;
+			state.ReadAccess	= dstAccess;
+		}
+		else
+		{
+			state.ReadStages	|= dstStage;
+			state.ReadAccess	|= dstAccess;
+		}
+		state.Layout = newLayout;
+	}
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,102 @@
+//-----------------------------------------------------------------------------
+#include "render/ShaderPermutation.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	ShaderPermutation::ShaderPermutation(const PermutationTable& table)
+		: Table(&table)
+	{
+		for (const auto& option : table.GetOptions())
+		{
+			Values.push_back(option.Default);
+		}
+	}
+	//-----------------------------------------------------------------------------
+	ShaderPermutation& ShaderPermutation::Set(const std::string& name, uint32_t value)
+	{
+		int32_t index = Table->FindOption(name);
+		if (index < 0)
+		{
+			throw std::runtime_error("unknown shader option " + name + "!");
+		}
+		Values[index] = value;
+		return *this;
+	}
+	//-----------------------------------------------------------------------------
+	const uint32_t ShaderPermutation::Get(const std::string& name) const
+	{
+		int32_t index = Table->FindOption(name);
+		if (index < 0)
+		{
+			throw std::runtime_error("unknown shader option " + name + "!");
+		}
+		return Values[index];
+	}
+	//-----------------------------------------------------------------------------
+	PermutationTable::PermutationTable(std::initializer_list<PermutationOption> options)
+		: Options(options)
+	{
+		for (size_t i = 0; i < Options.size(); i++)
+		{
+			for (size_t j = i + 1; j < Options.size(); j++)
+			{
+				bool sharedStage = (Options[i].Stages & Options[j].Stages) != 0;
+				if (Options[i].Name == Options[j].Name || (sharedStage && Options[i].ConstantId == Options[j].ConstantId))
+				{
+					throw std::runtime_error("shader option " + Options[j].Name + " is declared twice!");
+				}
+			}
+		}
+	}
+	//-----------------------------------------------------------------------------
+	ShaderPermutation PermutationTable::MakePermutation() const
+	{
+		return ShaderPermutation(*this);
+	}
+	//-----------------------------------------------------------------------------
+	void PermutationTable::Apply(const ShaderPermutation& permutation, GraphicsPipelineDesc& desc) const
+	{
+		if (permutation.Table != this)
+		{
+			throw std::runtime_error("shader permutation belongs to another table!");
+		}
+
+		for (auto& stage : desc.Stages)
+		{
+			stage.Constants.clear();
+			for (size_t i = 0; i < Options.size(); i++)
+			{
+				if (Options[i].Stages & stage.Stage)
+				{
+					stage.Constants.push_back({ Options[i].ConstantId, permutation.Values[i] });
+				}
+			}
+			// Same permutation, same key, whatever the declaration order
+			std::sort(stage.Constants.begin(), stage.Constants.end(),
+				[](const SpecializationConstant& a, const SpecializationConstant& b) { return a.Id < b.Id; });
+		}
+	}
+	//-----------------------------------------------------------------------------
+	const int32_t PermutationTable::FindOption(const std::string& name) const
+	{
+		for (size_t i = 0; i < Options.size(); i++)
+		{
+			if (Options[i].Name == name)
+			{
+				return static_cast<int32_t>(i);
+			}
+		}
+		return -1;
+	}
+	//-----------------------------------------------------------------------------
+	const uint32_t FloatBits(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,484 @@
+//-----------------------------------------------------------------------------
+#include "render/ShaderReflection.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	// The subset of the SPIR-V spec the reader looks at
+	static const uint32_t SpirvMagic = 0x07230203;
+
+	enum SpirvOp : uint32_t
+	{
+		OpEntryPoint		= 15,
+		OpTypeInt			= 21,
+		OpTypeFloat			= 22,
+		OpTypeVector		= 23,
+		OpTypeMatrix		= 24,
+		OpTypeImage			= 25,
+		OpTypeSampler		= 26,
+		OpTypeSampledImage	= 27,
+		OpTypeArray			= 28,
+		OpTypeRuntimeArray	= 29,
+		OpTypeStruct		= 30,
+		OpTypePointer		= 32,
+		OpConstant			= 43,
+		OpVariable			= 59,
+		OpDecorate			= 71,
+		OpMemberDecorate	= 72
+	};
+
+	enum SpirvDecoration : uint32_t
+	{
+		DecorationBufferBlock	= 3,
+		DecorationArrayStride	= 6,
+		DecorationMatrixStride	= 7,
+		DecorationBuiltIn		= 11,
+		DecorationLocation		= 30,
+		DecorationBinding		= 33,
+		DecorationDescriptorSet	= 34,
+		DecorationOffset		= 35
+	};
+
+	enum SpirvStorageClass : uint32_t
+	{
+		StorageUniformConstant	= 0,
+		StorageInput			= 1,
+		StorageUniform			= 2,
+		StoragePushConstant		= 9,
+		StorageBuffer			= 12
+	};
+
+	enum SpirvDim : uint32_t
+	{
+		DimBuffer		= 5,
+		DimSubpassData	= 6
+	};
+	//-----------------------------------------------------------------------------
+	// Everything known about one result id. Words holds the defining
+	// instruction without its opcode word.
+	struct SpirvId
+	{
+		uint32_t Op				= 0;
+		std::vector<uint32_t> Words;
+		uint32_t Set			= ~0u;
+		uint32_t Binding		= ~0u;
+		uint32_t Location		= ~0u;
+		uint32_t ArrayStride	= 0;
+		bool BuiltIn			= false;
+		bool BufferBlock		= false;
+		std::vector<uint32_t> MemberOffsets;
+		std::vector<uint32_t> MemberMatrixStrides;
+	};
+	//-----------------------------------------------------------------------------
+	static const SpirvId& GetId(const std::vector<SpirvId>& ids, uint32_t id)
+	{
+		if (id >= ids.size() || ids[id].Op == 0)
+		{
+			throw std::runtime_error("SPIR-V reflection: undefined id " + std::to_string(id) + "!");
+		}
+		return ids[id];
+	}
+	//-----------------------------------------------------------------------------
+	static void SetMemberDecoration(std::vector<uint32_t>& values, uint32_t member, uint32_t value)
+	{
+		if (values.size() <= member)
+		{
+			values.resize(member + 1, 0);
+		}
+		values[member] = value;
+	}
+	//-----------------------------------------------------------------------------
+	static const uint32_t GetArrayLength(const std::vector<SpirvId>& ids, const SpirvId& arrayType)
+	{
+		const SpirvId& length = GetId(ids, arrayType.Words[2]);
+		if (length.Op != OpConstant)
+		{
+			throw std::runtime_error("SPIR-V reflection: array length is not a constant (specialization constants are not supported)!");
+		}
+		return length.Words[2];
+	}
+	//-----------------------------------------------------------------------------
+	// Size in bytes as laid out in a block, matrixStride comes from the member
+	// decoration of the enclosing struct
+	static const uint32_t GetTypeSize(const std::vector<SpirvId>& ids, uint32_t typeId, uint32_t matrixStride)
+	{
+		const SpirvId& type = GetId(ids, typeId);
+		switch (type.Op)
+		{
+		case OpTypeInt:
+		case OpTypeFloat:
+			return type.Words[1] / 8;
+		case OpTypeVector:
+			return type.Words[2] * GetTypeSize(ids, type.Words[1], 0);
+		case OpTypeMatrix:
+			return type.Words[2] * (matrixStride != 0 ? matrixStride : GetTypeSize(ids, type.Words[1], 0));
+		case OpTypeArray:
+		{
+			uint32_t stride = type.ArrayStride != 0 ? type.ArrayStride : GetTypeSize(ids, type.Words[1], matrixStride);
+			return GetArrayLength(ids, type) * stride;
+		}
+		case OpTypeRuntimeArray:
+			return 0;
+		case OpTypeStruct:
+		{
+			// Words: result, then one type per member
+			uint32_t size = 0;
+			for (size_t member = 1; member < type.Words.size(); member++)
+			{
+				size_t index = member - 1;
+				uint32_t offset = index < type.MemberOffsets.size() ? type.MemberOffsets[index] : 0;
+				uint32_t stride = index < type.MemberMatrixStrides.size() ? type.MemberMatrixStrides[index] : 0;
+				size = std::max(size, offset + GetTypeSize(ids, type.Words[member], stride));
+			}
+			return size;
+		}
+		default:
+			throw std::runtime_error("SPIR-V reflection: unsupported type in block!");
+		}
+	}
+	//-----------------------------------------------------------------------------
+	static VkFormat GetVertexFormat(const std::vector<SpirvId>& ids, uint32_t typeId)
+	{
+		const SpirvId* type = &GetId(ids, typeId);
+		uint32_t components = 1;
+		if (type->Op == OpTypeVector)
+		{
+			components = type->Words[2];
+			type = &GetId(ids, type->Words[1]);
+		}
+		if ((type->Op != OpTypeFloat && type->Op != OpTypeInt) || type->Words[1] != 32 || components < 1 || components > 4)
+		{
+			return VK_FORMAT_UNDEFINED;
+		}
+
+		static const VkFormat floatFormats[4]	= { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+		static const VkFormat sintFormats[4]	= { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+		static const VkFormat uintFormats[4]	= { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+		if (type->Op == OpTypeFloat)
+		{
+			return floatFormats[components - 1];
+		}
+		return type->Words[2] != 0 ? sintFormats[components - 1] : uintFormats[components - 1];
+	}
+	//-----------------------------------------------------------------------------
+	static VkDescriptorType GetDescriptorType(const std::vector<SpirvId>& ids, uint32_t typeId, uint32_t storageClass, uint32_t& count)
+	{
+		count = 1;
+		const SpirvId* type = &GetId(ids, typeId);
+		// Arrays of descriptors, a runtime array is left unsized
+		while (type->Op == OpTypeArray || type->Op == OpTypeRuntimeArray)
+		{
+			count = type->Op == OpTypeArray ? count * GetArrayLength(ids, *type) : 0;
+			type = &GetId(ids, type->Words[1]);
+		}
+
+		if (storageClass == StorageBuffer)
+		{
+			return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		}
+		if (storageClass == StorageUniform)
+		{
+			// SPIR-V 1.0 spells storage buffers as BufferBlock in the Uniform class
+			return type->BufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		}
+
+		switch (type->Op)
+		{
+		case OpTypeSampler:
+			return VK_DESCRIPTOR_TYPE_SAMPLER;
+		case OpTypeSampledImage:
+		{
+			const SpirvId& image = GetId(ids, type->Words[1]);
+			return image.Words[2] == DimBuffer ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		}
+		case OpTypeImage:
+		{
+			// Words: result, sampled type, dim, depth, arrayed, ms, sampled
+			bool storage = type->Words[6] == 2;
+			if (type->Words[2] == DimBuffer)
+			{
+				return storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+			}
+			if (type->Words[2] == DimSubpassData)
+			{
+				return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+			}
+			return storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		}
+		default:
+			throw std::runtime_error("SPIR-V reflection: unsupported descriptor type!");
+		}
+	}
+	//-----------------------------------------------------------------------------
+	static VkShaderStageFlagBits GetStage(uint32_t executionModel)
+	{
+		switch (executionModel)
+		{
+		case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+		case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+		case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+		case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+		case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+		case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+		default:
+			throw std::runtime_error("SPIR-V reflection: unsupported execution model!");
+		}
+	}
+	//-----------------------------------------------------------------------------
+	static void AddBinding(std::vector<DescriptorSetReflection>& sets, uint32_t set, const VkDescriptorSetLayoutBinding& binding)
+	{
+		auto found = std::find_if(sets.begin(), sets.end(), [set](const DescriptorSetReflection& s) { return s.Set == set; });
+		if (found == sets.end())
+		{
+			sets.push_back({ set, {} });
+			found = sets.end() - 1;
+		}
+
+		for (auto& existing : found->Bindings)
+		{
+			if (existing.binding != binding.binding)
+			{
+				continue;
+			}
+			if (existing.descriptorType != binding.descriptorType)
+			{
+				throw std::runtime_error("SPIR-V reflection: set " + std::to_string(set) + " binding " + std::to_string(binding.binding) + " is declared with different types!");
+			}
+			existing.stageFlags |= binding.stageFlags;
+			existing.descriptorCount = (existing.descriptorCount == 0 || binding.descriptorCount == 0) ? 0 : std::max(existing.descriptorCount, binding.descriptorCount);
+			return;
+		}
+		found->Bindings.push_back(binding);
+	}
+	//-----------------------------------------------------------------------------
+	static void SortSets(std::vector<DescriptorSetReflection>& sets)
+	{
+		std::sort(sets.begin(), sets.end(), [](const DescriptorSetReflection& a, const DescriptorSetReflection& b) { return a.Set < b.Set; });
+		for (auto& set : sets)
+		{
+			std::sort(set.Bindings.begin(), set.Bindings.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) { return a.binding < b.binding; });
+		}
+	}
+	//-----------------------------------------------------------------------------
+	ShaderReflection ShaderReflection::FromSpirv(const std::vector<char>& code)
+	{
+		if (code.size() < 5 * sizeof(uint32_t) || code.size() % sizeof(uint32_t) != 0)
+		{
+			throw std::runtime_error("SPIR-V reflection: module is truncated!");
+		}
+		// The file buffer has no alignment guarantee
+		std::vector<uint32_t> words(code.size() / sizeof(uint32_t));
+		memcpy(words.data(), code.data(), code.size());
+		if (words[0] != SpirvMagic)
+		{
+			throw std::runtime_error("SPIR-V reflection: bad magic number!");
+		}
+
+		std::vector<SpirvId> ids(words[3]);
+		std::vector<uint32_t> variables;
+		ShaderReflection reflection;
+
+		for (size_t i = 5; i < words.size();)
+		{
+			uint32_t wordCount = words[i] >> 16;
+			uint32_t op = words[i] & 0xffff;
+			if (wordCount == 0 || i + wordCount > words.size())
+			{
+				throw std::runtime_error("SPIR-V reflection: malformed instruction!");
+			}
+			const uint32_t* operands = &words[i + 1];
+			uint32_t operandCount = wordCount - 1;
+
+			switch (op)
+			{
+			case OpEntryPoint:
+				reflection.Stages |= GetStage(operands[0]);
+				break;
+			case OpTypeInt:
+			case OpTypeFloat:
+			case OpTypeVector:
+			case OpTypeMatrix:
+			case OpTypeImage:
+			case OpTypeSampler:
+			case OpTypeSampledImage:
+			case OpTypeArray:
+			case OpTypeRuntimeArray:
+			case OpTypeStruct:
+			case OpTypePointer:
+			case OpConstant:
+			case OpVariable:
+			{
+				// Types define their id first, constants and variables after the result type
+				uint32_t result = (op == OpConstant || op == OpVariable) ? operands[1] : operands[0];
+				if (result >= ids.size())
+				{
+					throw std::runtime_error("SPIR-V reflection: id out of bounds!");
+				}
+				ids[result].Op = op;
+				ids[result].Words.assign(operands, operands + operandCount);
+				if (op == OpVariable)
+				{
+					variables.push_back(result);
+				}
+				break;
+			}
+			case OpDecorate:
+			{
+				if (operands[0] >= ids.size())
+				{
+					throw std::runtime_error("SPIR-V reflection: id out of bounds!");
+				}
+				SpirvId& target = ids[operands[0]];
+				uint32_t value = operandCount > 2 ? operands[2] : 0;
+				switch (operands[1])
+				{
+				case DecorationBufferBlock:		target.BufferBlock = true; break;
+				case DecorationArrayStride:		target.ArrayStride = value; break;
+				case DecorationBuiltIn:			target.BuiltIn = true; break;
+				case DecorationLocation:		target.Location = value; break;
+				case DecorationBinding:			target.Binding = value; break;
+				case DecorationDescriptorSet:	target.Set = value; break;
+				}
+				break;
+			}
+			case OpMemberDecorate:
+			{
+				if (operands[0] >= ids.size() || operandCount < 4)
+				{
+					break;
+				}
+				SpirvId& target = ids[operands[0]];
+				if (operands[2] == DecorationOffset)
+				{
+					SetMemberDecoration(target.MemberOffsets, operands[1], operands[3]);
+				}
+				else if (operands[2] == DecorationMatrixStride)
+				{
+					SetMemberDecoration(target.MemberMatrixStrides, operands[1], operands[3]);
+				}
+				break;
+			}
+			}
+			i += wordCount;
+		}
+
+		if (reflection.Stages == 0)
+		{
+			throw std::runtime_error("SPIR-V reflection: module has no entry point!");
+		}
+
+		for (uint32_t id : variables)
+		{
+			const SpirvId& variable = ids[id];
+			uint32_t storageClass = variable.Words[2];
+			const SpirvId& pointer = GetId(ids, variable.Words[0]);
+			uint32_t typeId = pointer.Words[2];
+
+			switch (storageClass)
+			{
+			case StorageUniformConstant:
+			case StorageUniform:
+			case StorageBuffer:
+			{
+				if (variable.Set == ~0u || variable.Binding == ~0u)
+				{
+					throw std::runtime_error("SPIR-V reflection: resource without set / binding decoration!");
+				}
+				VkDescriptorSetLayoutBinding binding = {};
+				binding.binding			= variable.Binding;
+				binding.descriptorType	= GetDescriptorType(ids, typeId, storageClass, binding.descriptorCount);
+				binding.stageFlags		= reflection.Stages;
+				AddBinding(reflection.Sets, variable.Set, binding);
+				break;
+			}
+			case StoragePushConstant:
+			{
+				const SpirvId& block = GetId(ids, typeId);
+				uint32_t begin = block.MemberOffsets.empty() ? 0 : *std::min_element(block.MemberOffsets.begin(), block.MemberOffsets.end());
+				uint32_t end = GetTypeSize(ids, typeId, 0);
+
+				VkPushConstantRange range = {};
+				range.stageFlags	= reflection.Stages;
+				range.offset		= begin;
+				// Ranges are counted in whole words
+				range.size			= ((end + 3) & ~3u) - begin;
+				reflection.PushConstants.push_back(range);
+				break;
+			}
+			case StorageInput:
+			{
+				if ((reflection.Stages & VK_SHADER_STAGE_VERTEX_BIT) == 0 || variable.BuiltIn || variable.Location == ~0u)
+				{
+					break;
+				}
+				VkVertexInputAttributeDescription input = {};
+				input.location	= variable.Location;
+				input.format	= GetVertexFormat(ids, typeId);
+				reflection.VertexInputs.push_back(input);
+				break;
+			}
+			}
+		}
+
+		SortSets(reflection.Sets);
+		std::sort(reflection.VertexInputs.begin(), reflection.VertexInputs.end(),
+			[](const VkVertexInputAttributeDescription& a, const VkVertexInputAttributeDescription& b) { return a.location < b.location; });
+		return reflection;
+	}
+	//-----------------------------------------------------------------------------
+	ShaderReflection ShaderReflection::Merge(const std::vector<ShaderReflection>& stages)
+	{
+		ShaderReflection merged;
+		VkPushConstantRange pushConstants = {};
+		for (const auto& stage : stages)
+		{
+			merged.Stages |= stage.Stages;
+			for (const auto& set : stage.Sets)
+			{
+				for (const auto& binding : set.Bindings)
+				{
+					AddBinding(merged.Sets, set.Set, binding);
+				}
+			}
+			for (const auto& range : stage.PushConstants)
+			{
+				uint32_t end = std::max(pushConstants.offset + pushConstants.size, range.offset + range.size);
+				pushConstants.offset = pushConstants.stageFlags == 0 ? range.offset : std::min(pushConstants.offset, range.offset);
+				pushConstants.size = end - pushConstants.offset;
+				pushConstants.stageFlags |= range.stageFlags;
+			}
+			if (stage.Stages & VK_SHADER_STAGE_VERTEX_BIT)
+			{
+				merged.VertexInputs = stage.VertexInputs;
+			}
+		}
+
+		if (pushConstants.stageFlags != 0)
+		{
+			merged.PushConstants.push_back(pushConstants);
+		}
+		SortSets(merged.Sets);
+		return merged;
+	}
+	//-----------------------------------------------------------------------------
+	const DescriptorSetReflection* ShaderReflection::FindSet(uint32_t set) const
+	{
+		for (const auto& reflected : Sets)
+		{
+			if (reflected.Set == set)
+			{
+				return &reflected;
+			}
+		}
+		return nullptr;
+	}
+	//-----------------------------------------------------------------------------
+	const uint32_t ShaderReflection::GetSetCount() const
+	{
+		return Sets.empty() ? 0 : Sets.back().Set + 1;
+	}
+}
+//-----------------------------------------------------------------------------
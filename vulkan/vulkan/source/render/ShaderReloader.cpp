@@ -0,0 +1,119 @@
+//-----------------------------------------------------------------------------
+#include "render/ShaderReloader.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	static const bool ReadBinaryFile(const std::string& path, std::vector<char>& data)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open())
+		{
+			return false;
+		}
+		data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		return !data.empty();
+	}
+	//-----------------------------------------------------------------------------
+	ShaderReloader::ShaderReloader(core::JobSystem& jobs, const std::string& directory, const std::vector<ShaderSourceFile>& files)
+		: Jobs(jobs)
+		, Directory(directory)
+		, Files(files)
+	{
+		std::vector<std::string> sources;
+		for (const auto& file : Files)
+		{
+			sources.push_back(file.Source);
+		}
+
+		Watcher.reset(new core::FileWatcher(Directory, sources, [this](const std::string& source)
+		{
+			for (const auto& file : Files)
+			{
+				if (file.Source == source)
+				{
+					ShaderSourceFile changed = file;
+					Jobs.Run([this, changed]() { Compile(changed); }, &InFlight);
+				}
+			}
+		}));
+	}
+	//-----------------------------------------------------------------------------
+	ShaderReloader::~ShaderReloader()
+	{
+		Watcher.reset();
+		Jobs.Wait(InFlight);
+	}
+	//-----------------------------------------------------------------------------
+	std::vector<ReloadedShader> ShaderReloader::TakeReloaded()
+	{
+		std::lock_guard<std::mutex> lock(ReloadedLock);
+		std::vector<ReloadedShader> reloaded;
+		reloaded.swap(Reloaded);
+		return reloaded;
+	}
+	//-----------------------------------------------------------------------------
+	const std::string ShaderReloader::GetCompilerPath()
+	{
+#if defined(_WIN32)
+		const char* sdk = getenv("VK_SDK_PATH");
+		return sdk != nullptr ? std::string(sdk) + "\\Bin32\\glslangValidator.exe" : "glslangValidator.exe";
+#else
+		const char* sdk = getenv("VULKAN_SDK");
+		return sdk != nullptr ? std::string(sdk) + "/bin/glslangValidator" : "glslangValidator";
+#endif
+	}
+	//-----------------------------------------------------------------------------
+	void ShaderReloader::Compile(const ShaderSourceFile& file)
+	{
+		std::lock_guard<std::mutex> lock(CompileLock);
+		auto start = std::chrono::high_resolution_clock::now();
+
+		std::string source	= Directory + "/" + file.Source;
+		std::string output	= Directory + "/" + file.Output;
+		// Built next to the real output, which is only replaced by a good build
+		std::string staging	= output + ".reload";
+		std::string log		= Directory + "/shader_log.txt";
+
+		std::string command = "\"" + GetCompilerPath() + "\" -V \"" + source + "\" -o \"" + staging + "\" > \"" + log + "\" 2>&1";
+#if defined(_WIN32)
+		// cmd.exe strips the outer pair of quotes
+		command = "\"" + command + "\"";
+#endif
+
+		std::vector<char> code;
+		if (std::system(command.c_str()) != 0 || !ReadBinaryFile(staging, code))
+		{
+			std::vector<char> errors;
+			ReadBinaryFile(log, errors);
+			std::cerr << "Shader reload: " << file.Source << " failed, keeping the last good version" << std::endl;
+			std::cerr.write(errors.data(), errors.size());
+			std::cerr << std::endl;
+			std::remove(staging.c_str());
+			return;
+		}
+
+		std::remove(output.c_str());
+		std::rename(staging.c_str(), output.c_str());
+
+		float elapsedMs = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - start).count();
+		std::cout << "Shader reload: " << file.Source << " compiled in " << elapsedMs << " ms" << std::endl;
+
+		std::lock_guard<std::mutex> reloadedLock(ReloadedLock);
+		for (auto& reloaded : Reloaded)
+		{
+			if (reloaded.Output == file.Output)
+			{
+				reloaded.Code.swap(code);
+				return;
+			}
+		}
+		Reloaded.push_back({ file.Output, code });
+	}
+}
+//-----------------------------------------------------------------------------
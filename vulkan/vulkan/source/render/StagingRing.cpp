@@ -0,0 +1,114 @@
+//-----------------------------------------------------------------------------
+#include "render/StagingRing.h"
+#include <algorithm>
+#include <stdexcept>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+	//-----------------------------------------------------------------------------
+	StagingRing::StagingRing(VkDevice device, MemoryTypeFinder findMemoryType, const StagingRingDesc& desc)
+		: Device(device)
+		, Size(desc.BytesPerFrame * std::max(desc.FramesInFlight, 1u))
+		, Head(0)
+		, Tail(0)
+		, FrameEnds(std::max(desc.FramesInFlight, 1u), 0)
+		, Reservations(0)
+		, Failures(0)
+	{
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType		= VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size			= Size;
+		bufferInfo.usage		= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferInfo.sharingMode	= VK_SHARING_MODE_EXCLUSIVE;
+		if (vkCreateBuffer(Device, &bufferInfo, nullptr, &Buffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create staging ring buffer!");
+		}
+
+		VkMemoryRequirements memRequirements;
+		vkGetBufferMemoryRequirements(Device, Buffer, &memRequirements);
+
+		VkMemoryAllocateInfo allocInfo	= {};
+		allocInfo.sType					= VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize		= memRequirements.size;
+		// Coherent, so writers never flush
+		allocInfo.memoryTypeIndex		= findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		MemoryTypeIndex					= allocInfo.memoryTypeIndex;
+		if (vkAllocateMemory(Device, &allocInfo, nullptr, &Memory) != VK_SUCCESS)
+		{
+			vkDestroyBuffer(Device, Buffer, nullptr);
+			throw std::runtime_error("failed to allocate staging ring memory!");
+		}
+		vkBindBufferMemory(Device, Buffer, Memory, 0);
+
+		void* mapped;
+		vkMapMemory(Device, Memory, 0, VK_WHOLE_SIZE, 0, &mapped);
+		Mapped = static_cast<uint8_t*>(mapped);
+	}
+	//-----------------------------------------------------------------------------
+	StagingRing::~StagingRing()
+	{
+		vkDestroyBuffer(Device, Buffer, nullptr);
+		// Unmapped along with it
+		vkFreeMemory(Device, Memory, nullptr);
+	}
+	//-----------------------------------------------------------------------------
+	const bool StagingRing::Reserve(VkDeviceSize size, VkDeviceSize alignment, BufferRange& range)
+	{
+		alignment = std::max<VkDeviceSize>(alignment, 1);
+		if (size == 0 || size > Size)
+		{
+			Failures.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		uint64_t head = Head.load(std::memory_order_relaxed);
+		uint64_t position;
+		do
+		{
+			// Aligned within the buffer, Size need not be a multiple of alignment
+			uint64_t lap	= head - head % Size;
+			uint64_t offset	= AlignUp(head % Size, alignment);
+			// Skips the rest of the lap, the gap is recycled with the range
+			position = offset + size > Size ? lap + Size : lap + offset;
+			if (position + size - Tail.load(std::memory_order_acquire) > Size)
+			{
+				Failures.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+		}
+		while (!Head.compare_exchange_weak(head, position + size, std::memory_order_relaxed));
+		Reservations.fetch_add(1, std::memory_order_relaxed);
+
+		range.Buffer	= Buffer;
+		range.Offset	= position % Size;
+		range.Size		= size;
+		range.Mapped	= Mapped + range.Offset;
+		return true;
+	}
+	//-----------------------------------------------------------------------------
+	void StagingRing::BeginFrame(uint32_t frameSlot)
+	{
+		// Whatever was reserved up to now went out with the frame that just ended
+		FrameEnds[FrameSlot]	= Head.load(std::memory_order_relaxed);
+		FrameSlot				= frameSlot % FrameEnds.size();
+		Tail.store(std::max(Tail.load(std::memory_order_relaxed), FrameEnds[FrameSlot]), std::memory_order_release);
+	}
+	//-----------------------------------------------------------------------------
+	const StagingRingStats StagingRing::GetStats() const
+	{
+		StagingRingStats stats;
+		stats.Size			= Size;
+		// Tail first, it never passes Head
+		uint64_t tail		= Tail.load(std::memory_order_acquire);
+		stats.UsedBytes		= Head.load(std::memory_order_acquire) - tail;
+		stats.Reservations	= Reservations.load(std::memory_order_relaxed);
+		stats.Failures		= Failures.load(std::memory_order_relaxed);
+		return stats;
+	}
+}
+//-----------------------------------------------------------------------------
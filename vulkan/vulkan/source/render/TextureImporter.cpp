@@ -0,0 +1,90 @@
+//-----------------------------------------------------------------------------
+#include "render/TextureImporter.h"
+#include "render/Ktx2File.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	static float GetMilliseconds(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+	//-----------------------------------------------------------------------------
+	std::vector<RgbaImage> BuildMipChain(core::JobSystem& jobs, const RgbaImage& base)
+	{
+		std::vector<RgbaImage> chain(1, base);
+		while (chain.back().Width > 1 || chain.back().Height > 1)
+		{
+			const RgbaImage& source = chain.back();
+			RgbaImage level;
+			level.Width		= std::max(source.Width / 2, 1u);
+			level.Height	= std::max(source.Height / 2, 1u);
+			level.Texels.resize(static_cast<size_t>(level.Width) * level.Height * 4);
+
+			jobs.ParallelFor(0, level.Height, std::max(16384u / level.Width, 1u), [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t y = begin; y < end; y++)
+				{
+					// Odd sizes drop the last row / column, a 1 texel side repeats itself
+					uint32_t y0 = std::min(y * 2, source.Height - 1);
+					uint32_t y1 = std::min(y * 2 + 1, source.Height - 1);
+					for (uint32_t x = 0; x < level.Width; x++)
+					{
+						uint32_t x0 = std::min(x * 2, source.Width - 1);
+						uint32_t x1 = std::min(x * 2 + 1, source.Width - 1);
+						for (uint32_t c = 0; c < 4; c++)
+						{
+							uint32_t sum = source.Texels[(static_cast<size_t>(y0) * source.Width + x0) * 4 + c]
+										+ source.Texels[(static_cast<size_t>(y0) * source.Width + x1) * 4 + c]
+										+ source.Texels[(static_cast<size_t>(y1) * source.Width + x0) * 4 + c]
+										+ source.Texels[(static_cast<size_t>(y1) * source.Width + x1) * 4 + c];
+							level.Texels[(static_cast<size_t>(y) * level.Width + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+						}
+					}
+				}
+			});
+			chain.push_back(std::move(level));
+		}
+		return chain;
+	}
+	//-----------------------------------------------------------------------------
+	const TextureImportStats ImportTexture(core::JobSystem& jobs, const std::string& input, const std::string& output, BlockEncoding encoding)
+	{
+		Ktx2File file(input);
+		bool srgb = file.GetFormat() == VK_FORMAT_R8G8B8A8_SRGB;
+		if (file.GetFormat() != VK_FORMAT_R8G8B8A8_UNORM && !srgb)
+		{
+			throw std::runtime_error(input + " is not RGBA8, nothing to import!");
+		}
+
+		RgbaImage base;
+		base.Width	= file.GetLevel(0).Width;
+		base.Height	= file.GetLevel(0).Height;
+		std::vector<char> texels = file.ReadLevel(0);
+		base.Texels.assign(texels.begin(), texels.end());
+
+		TextureImportStats stats;
+		stats.SourceBytes = base.Texels.size();
+
+		auto start = std::chrono::high_resolution_clock::now();
+		std::vector<RgbaImage> chain = BuildMipChain(jobs, base);
+		stats.MipMilliseconds = GetMilliseconds(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		std::vector<std::vector<char>> levels;
+		for (const auto& level : chain)
+		{
+			levels.push_back(EncodeImage(jobs, level.Texels.data(), level.Width, level.Height, encoding));
+			stats.EncodedBytes += levels.back().size();
+		}
+		stats.EncodeMilliseconds = GetMilliseconds(start);
+		stats.Levels = static_cast<uint32_t>(levels.size());
+
+		Ktx2File::Write(output, GetEncodedFormat(encoding, srgb), base.Width, base.Height, levels);
+		return stats;
+	}
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,524 @@
+//-----------------------------------------------------------------------------
+#include "render/TextureStreamer.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	// vkCmdCopyBufferToImage wants offsets aligned to the block size, 16 covers every BCn format
+	static const VkDeviceSize StagingAlignment = 16;
+	//-----------------------------------------------------------------------------
+	static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+	//-----------------------------------------------------------------------------
+	static VkImageMemoryBarrier MakeBarrier(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccess, VkAccessFlags dstAccess)
+	{
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType							= VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout						= oldLayout;
+		barrier.newLayout						= newLayout;
+		barrier.srcAccessMask					= srcAccess;
+		barrier.dstAccessMask					= dstAccess;
+		barrier.srcQueueFamilyIndex				= VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex				= VK_QUEUE_FAMILY_IGNORED;
+		barrier.image							= image;
+		barrier.subresourceRange.aspectMask		= VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel	= 0;
+		barrier.subresourceRange.levelCount		= VK_REMAINING_MIP_LEVELS;
+		barrier.subresourceRange.baseArrayLayer	= 0;
+		barrier.subresourceRange.layerCount		= 1;
+		return barrier;
+	}
+	//-----------------------------------------------------------------------------
+	TextureStreamer::TextureStreamer(VkDevice device, core::JobSystem& jobs, MemoryTypeFinder findMemoryType, const TextureStreamerDesc& desc)
+		: Device(device)
+		, Jobs(jobs)
+		, FindMemoryType(findMemoryType)
+		, Desc(desc)
+		, Retired(std::max(desc.FramesInFlight, 1u))
+	{
+		VkSamplerCreateInfo samplerInfo = {};
+		samplerInfo.sType			= VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter		= VK_FILTER_LINEAR;
+		samplerInfo.minFilter		= VK_FILTER_LINEAR;
+		samplerInfo.mipmapMode		= VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.addressModeU	= VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.addressModeV	= VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.addressModeW	= VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.minLod			= 0.0f;
+		// Views only cover the resident levels, the sampler does not need to clamp
+		samplerInfo.maxLod			= VK_LOD_CLAMP_NONE;
+		samplerInfo.borderColor		= VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+
+		if (vkCreateSampler(Device, &samplerInfo, nullptr, &Sampler) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create texture streaming sampler!");
+		}
+	}
+	//-----------------------------------------------------------------------------
+	TextureStreamer::~TextureStreamer()
+	{
+		Jobs.Wait(InFlight);
+
+		for (auto& frame : Retired)
+		{
+			for (const auto& resource : frame)
+			{
+				Destroy(resource);
+			}
+		}
+		for (const auto& texture : Textures)
+		{
+			RetiredResource resource;
+			resource.Image	= texture->Image;
+			resource.View	= texture->View;
+			resource.Memory	= texture->Memory;
+			Destroy(resource);
+		}
+		vkDestroySampler(Device, Sampler, nullptr);
+	}
+	//-----------------------------------------------------------------------------
+	TextureHandle TextureStreamer::Load(const std::string& path)
+	{
+		std::unique_ptr<Texture> texture(new Texture(path));
+		if (!Ktx2File::IsBlockCompressed(texture->File.GetFormat()))
+		{
+			throw std::runtime_error(path + " is not block compressed, it can't be streamed!");
+		}
+		uint32_t levelCount = texture->File.GetLevelCount();
+
+		texture->TailLevel = levelCount - 1;
+		for (uint32_t level = 0; level < levelCount; level++)
+		{
+			const Ktx2Level& info = texture->File.GetLevel(level);
+			if (std::max(info.Width, info.Height) <= Desc.TailSize)
+			{
+				texture->TailLevel = level;
+				break;
+			}
+		}
+		texture->ResidentLevel	= levelCount;
+		texture->WantedLevel	= levelCount;
+
+		Textures.push_back(std::move(texture));
+		StartLoad(*Textures.back(), Textures.back()->TailLevel);
+		Stats.Textures = static_cast<uint32_t>(Textures.size());
+		return static_cast<TextureHandle>(Textures.size() - 1);
+	}
+	//-----------------------------------------------------------------------------
+	void TextureStreamer::Touch(TextureHandle handle, uint32_t wantedLevel)
+	{
+		Texture& texture = *Textures.at(handle);
+		wantedLevel = std::min(wantedLevel, texture.File.GetLevelCount() - 1);
+		// Several users in one frame: the finest request wins
+		texture.WantedLevel		= texture.LastUsedFrame == Frame ? std::min(texture.WantedLevel, wantedLevel) : wantedLevel;
+		texture.LastUsedFrame	= Frame;
+	}
+	//-----------------------------------------------------------------------------
+	void TextureStreamer::BeginFrame(uint32_t frameSlot)
+	{
+		FrameSlot = frameSlot % Retired.size();
+		// The fence of this slot signaled, and its command buffer waited on the
+		// shader reads of the frames before it before touching a retired image
+		for (const auto& resource : Retired[FrameSlot])
+		{
+			Destroy(resource);
+		}
+		Retired[FrameSlot].clear();
+		Frame++;
+	}
+	//-----------------------------------------------------------------------------
+	void TextureStreamer::Update(VkCommandBuffer commandBuffer)
+	{
+		Stats.UploadedBytes = 0;
+
+		// Most recently used first, they get the upload bandwidth and the budget
+		std::vector<Texture*> order;
+		for (const auto& texture : Textures)
+		{
+			order.push_back(texture.get());
+		}
+		std::stable_sort(order.begin(), order.end(), [](const Texture* a, const Texture* b) { return a->LastUsedFrame > b->LastUsedFrame; });
+
+		// Levels read since the last frame
+		for (Texture* texture : order)
+		{
+			if (!texture->Loading || !texture->LoadReady.load(std::memory_order_acquire))
+			{
+				continue;
+			}
+			if (texture->LoadFailed)
+			{
+				std::cerr << "Texture streaming: failed to read " << texture->File.GetPath() << ", it stays at level " << texture->ResidentLevel << std::endl;
+				texture->StreamingFailed = true;
+			}
+			else
+			{
+				// Without its tail a texture has nothing to show, those skip both limits
+				bool isTail = texture->ResidentLevel == texture->File.GetLevelCount();
+				VkDeviceSize uploadBytes = GetLevelBytes(*texture, texture->LoadFirstLevel) - GetLevelBytes(*texture, texture->ResidentLevel);
+				if (!isTail && Stats.UploadedBytes > 0 && Stats.UploadedBytes + uploadBytes > Desc.UploadBytesPerFrame)
+				{
+					// Stays ready for the next frame
+					continue;
+				}
+
+				bool fits = MakeRoom(commandBuffer, uploadBytes, texture->LastUsedFrame, texture);
+				uint32_t previousLevel = texture->ResidentLevel;
+				if ((fits || isTail) && Rebuild(commandBuffer, *texture, texture->LoadFirstLevel, texture->LoadData))
+				{
+					Stats.LevelsStreamed += previousLevel - texture->LoadFirstLevel;
+					Stats.UploadedBytes += uploadBytes;
+				}
+			}
+			texture->LoadData.clear();
+			texture->LoadData.shrink_to_fit();
+			texture->Loading = false;
+		}
+
+		// Next level for the textures used this frame that want more, as long
+		// as evicting older ones can make room for it
+		VkDeviceSize requestedBytes = 0;
+		for (Texture* texture : order)
+		{
+			if (texture->Loading || texture->StreamingFailed || texture->LastUsedFrame != Frame ||
+				texture->ResidentLevel == texture->File.GetLevelCount() || texture->WantedLevel >= texture->ResidentLevel)
+			{
+				continue;
+			}
+
+			uint32_t level = texture->ResidentLevel - 1;
+			VkDeviceSize bytes = texture->File.GetLevel(level).ByteLength;
+			if (requestedBytes > 0 && requestedBytes + bytes > Desc.UploadBytesPerFrame)
+			{
+				break;
+			}
+
+			VkDeviceSize evictable = 0;
+			for (const auto& other : Textures)
+			{
+				if (IsEvictable(*other, texture->LastUsedFrame, texture))
+				{
+					evictable += GetLevelBytes(*other, other->ResidentLevel) - GetLevelBytes(*other, other->TailLevel);
+				}
+			}
+			if (Stats.ResidentBytes + bytes > Desc.BudgetBytes + evictable)
+			{
+				continue;
+			}
+
+			StartLoad(*texture, level);
+			requestedBytes += bytes;
+		}
+
+		// The budget may have shrunk, or tails pushed past it
+		MakeRoom(commandBuffer, 0, Frame, nullptr);
+
+		Stats.PendingLoads = 0;
+		for (const auto& texture : Textures)
+		{
+			Stats.PendingLoads += texture->Loading ? 1 : 0;
+		}
+	}
+	//-----------------------------------------------------------------------------
+	VkImageView TextureStreamer::GetView(TextureHandle texture) const
+	{
+		return Textures.at(texture)->View;
+	}
+	//-----------------------------------------------------------------------------
+	const uint32_t TextureStreamer::GetResidentLevel(TextureHandle texture) const
+	{
+		return Textures.at(texture)->ResidentLevel;
+	}
+	//-----------------------------------------------------------------------------
+	void TextureStreamer::StartLoad(Texture& texture, uint32_t firstLevel)
+	{
+		texture.Loading			= true;
+		texture.LoadFirstLevel	= firstLevel;
+		texture.LoadFailed		= false;
+		texture.LoadReady.store(false, std::memory_order_relaxed);
+		texture.LoadData.assign(texture.ResidentLevel - firstLevel, std::vector<char>());
+
+		Texture* target = &texture;
+		Jobs.Run([target]()
+		{
+			try
+			{
+				for (uint32_t i = 0; i < target->LoadData.size(); i++)
+				{
+					target->LoadData[i] = target->File.ReadLevel(target->LoadFirstLevel + i);
+				}
+			}
+			catch (const std::exception&)
+			{
+				target->LoadFailed = true;
+			}
+			target->LoadReady.store(true, std::memory_order_release);
+		}, &InFlight);
+	}
+	//-----------------------------------------------------------------------------
+	const bool TextureStreamer::Rebuild(VkCommandBuffer commandBuffer, Texture& texture, uint32_t firstLevel, const std::vector<std::vector<char>>& upload)
+	{
+		const Ktx2File& file		= texture.File;
+		uint32_t levelCount			= file.GetLevelCount();
+		uint32_t copyFirstLevel		= firstLevel + static_cast<uint32_t>(upload.size());
+		const Ktx2Level& topLevel	= file.GetLevel(firstLevel);
+
+		VkImageCreateInfo imageInfo = {};
+		imageInfo.sType			= VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType		= VK_IMAGE_TYPE_2D;
+		imageInfo.format		= file.GetFormat();
+		imageInfo.extent		= { topLevel.Width, topLevel.Height, 1 };
+		imageInfo.mipLevels		= levelCount - firstLevel;
+		imageInfo.arrayLayers	= 1;
+		imageInfo.samples		= VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling		= VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage			= VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.sharingMode	= VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout	= VK_IMAGE_LAYOUT_UNDEFINED;
+
+		RetiredResource created;
+		if (vkCreateImage(Device, &imageInfo, nullptr, &created.Image) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create streamed texture image!");
+		}
+
+		VkMemoryRequirements memRequirements;
+		vkGetImageMemoryRequirements(Device, created.Image, &memRequirements);
+
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType				= VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize	= memRequirements.size;
+		allocInfo.memoryTypeIndex	= FindMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		// Running out of device memory is not fatal here, the texture keeps what it has
+		if (vkAllocateMemory(Device, &allocInfo, nullptr, &created.Memory) != VK_SUCCESS)
+		{
+			Destroy(created);
+			return false;
+		}
+		vkBindImageMemory(Device, created.Image, created.Memory, 0);
+
+		VkImageViewCreateInfo viewInfo = {};
+		viewInfo.sType								= VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image								= created.Image;
+		viewInfo.viewType							= VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format								= file.GetFormat();
+		viewInfo.subresourceRange.aspectMask		= VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel		= 0;
+		viewInfo.subresourceRange.levelCount		= imageInfo.mipLevels;
+		viewInfo.subresourceRange.baseArrayLayer	= 0;
+		viewInfo.subresourceRange.layerCount		= 1;
+
+		if (vkCreateImageView(Device, &viewInfo, nullptr, &created.View) != VK_SUCCESS)
+		{
+			Destroy(created);
+			throw std::runtime_error("failed to create streamed texture image view!");
+		}
+
+		// The staging buffer goes in first, nothing is recorded if it fails
+		RetiredResource staging;
+		VkBuffer stagingBuffer		= VK_NULL_HANDLE;
+		VkDeviceSize stagingOffset	= 0;
+		VkDeviceSize stagingSize	= 0;
+		char* mapped				= nullptr;
+		for (const auto& level : upload)
+		{
+			stagingSize = AlignUp(stagingSize, StagingAlignment) + level.size();
+		}
+
+		BufferRange range;
+		if (!upload.empty() && Desc.Staging != nullptr && Desc.Staging->Reserve(stagingSize, StagingAlignment, range))
+		{
+			stagingBuffer	= range.Buffer;
+			stagingOffset	= range.Offset;
+			mapped			= static_cast<char*>(range.Mapped);
+		}
+		else if (!upload.empty())
+		{
+			VkBufferCreateInfo bufferInfo = {};
+			bufferInfo.sType		= VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferInfo.size			= stagingSize;
+			bufferInfo.usage		= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+			bufferInfo.sharingMode	= VK_SHARING_MODE_EXCLUSIVE;
+			if (vkCreateBuffer(Device, &bufferInfo, nullptr, &staging.Buffer) != VK_SUCCESS)
+			{
+				Destroy(created);
+				throw std::runtime_error("failed to create texture staging buffer!");
+			}
+
+			VkMemoryRequirements stagingRequirements;
+			vkGetBufferMemoryRequirements(Device, staging.Buffer, &stagingRequirements);
+			allocInfo.allocationSize	= stagingRequirements.size;
+			allocInfo.memoryTypeIndex	= FindMemoryType(stagingRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			if (vkAllocateMemory(Device, &allocInfo, nullptr, &staging.Memory) != VK_SUCCESS)
+			{
+				Destroy(staging);
+				Destroy(created);
+				return false;
+			}
+			vkBindBufferMemory(Device, staging.Buffer, staging.Memory, 0);
+			vkMapMemory(Device, staging.Memory, 0, stagingSize, 0, reinterpret_cast<void**>(&mapped));
+			stagingBuffer = staging.Buffer;
+		}
+
+		std::vector<VkBufferImageCopy> uploadRegions;
+		if (!upload.empty())
+		{
+			VkDeviceSize offset = 0;
+			for (uint32_t i = 0; i < upload.size(); i++)
+			{
+				offset = AlignUp(offset, StagingAlignment);
+				memcpy(mapped + offset, upload[i].data(), upload[i].size());
+
+				const Ktx2Level& level = file.GetLevel(firstLevel + i);
+				VkBufferImageCopy region = {};
+				region.bufferOffset						= stagingOffset + offset;
+				region.imageSubresource.aspectMask		= VK_IMAGE_ASPECT_COLOR_BIT;
+				region.imageSubresource.mipLevel		= i;
+				region.imageSubresource.baseArrayLayer	= 0;
+				region.imageSubresource.layerCount		= 1;
+				region.imageExtent						= { level.Width, level.Height, 1 };
+				uploadRegions.push_back(region);
+
+				offset += upload[i].size();
+			}
+			if (staging.Memory != VK_NULL_HANDLE)
+			{
+				vkUnmapMemory(Device, staging.Memory);
+			}
+		}
+
+		std::vector<VkImageMemoryBarrier> barriers;
+		barriers.push_back(MakeBarrier(created.Image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT));
+		if (texture.Image != VK_NULL_HANDLE)
+		{
+			barriers.push_back(MakeBarrier(texture.Image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_READ_BIT));
+		}
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+							0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+		if (!uploadRegions.empty())
+		{
+			vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, created.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+								static_cast<uint32_t>(uploadRegions.size()), uploadRegions.data());
+		}
+
+		if (texture.Image != VK_NULL_HANDLE)
+		{
+			// Same level, different mip index: both images end at the last level of the file
+			std::vector<VkImageCopy> copyRegions;
+			for (uint32_t level = std::max(copyFirstLevel, texture.ResidentLevel); level < levelCount; level++)
+			{
+				const Ktx2Level& info = file.GetLevel(level);
+				VkImageCopy region = {};
+				region.srcSubresource.aspectMask	= VK_IMAGE_ASPECT_COLOR_BIT;
+				region.srcSubresource.mipLevel		= level - texture.ResidentLevel;
+				region.srcSubresource.layerCount	= 1;
+				region.dstSubresource.aspectMask	= VK_IMAGE_ASPECT_COLOR_BIT;
+				region.dstSubresource.mipLevel		= level - firstLevel;
+				region.dstSubresource.layerCount	= 1;
+				region.extent						= { info.Width, info.Height, 1 };
+				copyRegions.push_back(region);
+			}
+			vkCmdCopyImage(commandBuffer, texture.Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, created.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+						static_cast<uint32_t>(copyRegions.size()), copyRegions.data());
+		}
+
+		VkImageMemoryBarrier toShader = MakeBarrier(created.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+							0, nullptr, 0, nullptr, 1, &toShader);
+
+		if (staging.Buffer != VK_NULL_HANDLE)
+		{
+			Retire(staging);
+		}
+		if (texture.Image != VK_NULL_HANDLE)
+		{
+			RetiredResource previous;
+			previous.Image	= texture.Image;
+			previous.View	= texture.View;
+			previous.Memory	= texture.Memory;
+			Retire(previous);
+		}
+
+		// Retired memory is counted as freed right away, it only lingers for the frames in flight
+		Stats.ResidentBytes		= Stats.ResidentBytes - texture.Bytes + memRequirements.size;
+		texture.Image			= created.Image;
+		texture.View			= created.View;
+		texture.Memory			= created.Memory;
+		texture.Bytes			= memRequirements.size;
+		texture.ResidentLevel	= firstLevel;
+		return true;
+	}
+	//-----------------------------------------------------------------------------
+	const bool TextureStreamer::MakeRoom(VkCommandBuffer commandBuffer, VkDeviceSize bytes, uint64_t newerThan, const Texture* keep)
+	{
+		while (Stats.ResidentBytes + bytes > Desc.BudgetBytes)
+		{
+			Texture* victim = nullptr;
+			for (const auto& texture : Textures)
+			{
+				if (IsEvictable(*texture, newerThan, keep) && (victim == nullptr || texture->LastUsedFrame < victim->LastUsedFrame))
+				{
+					victim = texture.get();
+				}
+			}
+			if (victim == nullptr)
+			{
+				return false;
+			}
+
+			// As many of its finest levels as it takes, in a single rebuild
+			uint32_t firstLevel	= victim->ResidentLevel;
+			VkDeviceSize freed	= 0;
+			while (firstLevel < victim->TailLevel && Stats.ResidentBytes + bytes > Desc.BudgetBytes + freed)
+			{
+				freed += victim->File.GetLevel(firstLevel).ByteLength;
+				firstLevel++;
+			}
+
+			uint32_t previousLevel = victim->ResidentLevel;
+			if (!Rebuild(commandBuffer, *victim, firstLevel, std::vector<std::vector<char>>()))
+			{
+				return false;
+			}
+			Stats.LevelsEvicted += firstLevel - previousLevel;
+		}
+		return true;
+	}
+	//-----------------------------------------------------------------------------
+	const bool TextureStreamer::IsEvictable(const Texture& texture, uint64_t newerThan, const Texture* keep) const
+	{
+		// A texture waiting for its next level would no longer be contiguous with it
+		return &texture != keep && !texture.Loading && texture.LastUsedFrame < newerThan && texture.ResidentLevel < texture.TailLevel;
+	}
+	//-----------------------------------------------------------------------------
+	const VkDeviceSize TextureStreamer::GetLevelBytes(const Texture& texture, uint32_t firstLevel) const
+	{
+		VkDeviceSize bytes = 0;
+		for (uint32_t level = firstLevel; level < texture.File.GetLevelCount(); level++)
+		{
+			bytes += texture.File.GetLevel(level).ByteLength;
+		}
+		return bytes;
+	}
+	//-----------------------------------------------------------------------------
+	void TextureStreamer::Retire(const RetiredResource& resource)
+	{
+		Retired[FrameSlot].push_back(resource);
+	}
+	//-----------------------------------------------------------------------------
+	void TextureStreamer::Destroy(const RetiredResource& resource) const
+	{
+		vkDestroyImageView(Device, resource.View, nullptr);
+		vkDestroyImage(Device, resource.Image, nullptr);
+		vkDestroyBuffer(Device, resource.Buffer, nullptr);
+		vkFreeMemory(Device, resource.Memory, nullptr);
+	}
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,163 @@
+//-----------------------------------------------------------------------------
+#include "render/TimelineSync.h"
+#include "render/DeviceFeatures.h"
+#include <stdexcept>
+//-----------------------------------------------------------------------------
+namespace render
+{
+	const bool TimelineSync::IsSupported(VkPhysicalDevice physicalDevice, uint32_t instanceApiVersion, bool& needsExtension)
+	{
+		// Same structure for the extension and for 1.2 core
+		VkPhysicalDeviceTimelineSemaphoreFeaturesKHR supported = {};
+		supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+		if (!QueryPromotedFeatures(physicalDevice, instanceApiVersion, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME, &supported, needsExtension))
+		{
+			return false;
+		}
+		return supported.timelineSemaphore == VK_TRUE;
+	}
+	//-----------------------------------------------------------------------------
+	TimelineSync::TimelineSync(VkDevice device)
+		: Device(device)
+	{
+		// KHR names are there when the extension is enabled, core names on 1.2
+		WaitSemaphores = reinterpret_cast<PFN_vkWaitSemaphoresKHR>(vkGetDeviceProcAddr(Device, "vkWaitSemaphoresKHR"));
+		if (WaitSemaphores == nullptr)
+		{
+			WaitSemaphores = reinterpret_cast<PFN_vkWaitSemaphoresKHR>(vkGetDeviceProcAddr(Device, "vkWaitSemaphores"));
+		}
+		GetSemaphoreCounterValue = reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(vkGetDeviceProcAddr(Device, "vkGetSemaphoreCounterValueKHR"));
+		if (GetSemaphoreCounterValue == nullptr)
+		{
+			GetSemaphoreCounterValue = reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(vkGetDeviceProcAddr(Device, "vkGetSemaphoreCounterValue"));
+		}
+		if (WaitSemaphores == nullptr || GetSemaphoreCounterValue == nullptr)
+		{
+			throw std::runtime_error("timeline semaphore entry points are missing!");
+		}
+
+		VkSemaphoreTypeCreateInfoKHR typeInfo = {};
+		typeInfo.sType			= VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+		typeInfo.semaphoreType	= VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+		typeInfo.initialValue	= 0;
+
+		VkSemaphoreCreateInfo semaphoreInfo = {};
+		semaphoreInfo.sType	= VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext	= &typeInfo;
+
+		for (uint32_t i = 0; i < static_cast<uint32_t>(QueueTimeline::Count); i++)
+		{
+			Values[i] = 0;
+			Semaphores[i] = VK_NULL_HANDLE;
+		}
+		for (uint32_t i = 0; i < static_cast<uint32_t>(QueueTimeline::Count); i++)
+		{
+			if (vkCreateSemaphore(Device, &semaphoreInfo, nullptr, &Semaphores[i]) != VK_SUCCESS)
+			{
+				for (uint32_t j = 0; j < i; j++)
+				{
+					vkDestroySemaphore(Device, Semaphores[j], nullptr);
+				}
+				throw std::runtime_error("failed to create timeline semaphore!");
+			}
+		}
+	}
+	//-----------------------------------------------------------------------------
+	TimelineSync::~TimelineSync()
+	{
+		for (VkSemaphore semaphore : Semaphores)
+		{
+			vkDestroySemaphore(Device, semaphore, nullptr);
+		}
+	}
+	//-----------------------------------------------------------------------------
+	const uint64_t TimelineSync::Advance(QueueTimeline queue)
+	{
+		return Values[static_cast<uint32_t>(queue)].fetch_add(1, std::memory_order_relaxed) + 1;
+	}
+	//-----------------------------------------------------------------------------
+	const uint64_t TimelineSync::GetLastValue(QueueTimeline queue) const
+	{
+		return Values[static_cast<uint32_t>(queue)].load(std::memory_order_relaxed);
+	}
+	//-----------------------------------------------------------------------------
+	const uint64_t TimelineSync::GetCompletedValue(QueueTimeline queue) const
+	{
+		uint64_t value = 0;
+		GetSemaphoreCounterValue(Device, GetSemaphore(queue), &value);
+		return value;
+	}
+	//-----------------------------------------------------------------------------
+	const bool TimelineSync::Wait(QueueTimeline queue, uint64_t value, uint64_t timeout) const
+	{
+		if (value == 0)
+		{
+			return true;
+		}
+
+		VkSemaphore semaphore = GetSemaphore(queue);
+		VkSemaphoreWaitInfoKHR waitInfo = {};
+		waitInfo.sType			= VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+		waitInfo.semaphoreCount	= 1;
+		waitInfo.pSemaphores	= &semaphore;
+		waitInfo.pValues		= &value;
+
+		VkResult result = WaitSemaphores(Device, &waitInfo, timeout);
+		if (result != VK_SUCCESS && result != VK_TIMEOUT)
+		{
+			throw std::runtime_error("failed to wait for timeline semaphore!");
+		}
+		return result == VK_SUCCESS;
+	}
+	//-----------------------------------------------------------------------------
+	void TimelineSubmit::WaitBinary(VkSemaphore semaphore, VkPipelineStageFlags stage)
+	{
+		WaitSemaphores.push_back(semaphore);
+		WaitValues.push_back(0);
+		WaitStages.push_back(stage);
+	}
+	//-----------------------------------------------------------------------------
+	void TimelineSubmit::WaitTimeline(const TimelineSync& sync, QueueTimeline queue, uint64_t value, VkPipelineStageFlags stage)
+	{
+		WaitSemaphores.push_back(sync.GetSemaphore(queue));
+		WaitValues.push_back(value);
+		WaitStages.push_back(stage);
+	}
+	//-----------------------------------------------------------------------------
+	void TimelineSubmit::WaitSemaphore(VkSemaphore semaphore, uint64_t value, VkPipelineStageFlags stage)
+	{
+		WaitSemaphores.push_back(semaphore);
+		WaitValues.push_back(value);
+		WaitStages.push_back(stage);
+	}
+	//-----------------------------------------------------------------------------
+	void TimelineSubmit::SignalBinary(VkSemaphore semaphore)
+	{
+		SignalSemaphores.push_back(semaphore);
+		SignalValues.push_back(0);
+	}
+	//-----------------------------------------------------------------------------
+	void TimelineSubmit::SignalTimeline(const TimelineSync& sync, QueueTimeline queue, uint64_t value)
+	{
+		SignalSemaphores.push_back(sync.GetSemaphore(queue));
+		SignalValues.push_back(value);
+	}
+	//-----------------------------------------------------------------------------
+	void TimelineSubmit::Apply(VkSubmitInfo& submitInfo)
+	{
+		Values.sType						= VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+		Values.pNext						= submitInfo.pNext;
+		Values.waitSemaphoreValueCount		= static_cast<uint32_t>(WaitValues.size());
+		Values.pWaitSemaphoreValues			= WaitValues.data();
+		Values.signalSemaphoreValueCount	= static_cast<uint32_t>(SignalValues.size());
+		Values.pSignalSemaphoreValues		= SignalValues.data();
+
+		submitInfo.pNext					= &Values;
+		submitInfo.waitSemaphoreCount		= static_cast<uint32_t>(WaitSemaphores.size());
+		submitInfo.pWaitSemaphores			= WaitSemaphores.data();
+		submitInfo.pWaitDstStageMask		= WaitStages.data();
+		submitInfo.signalSemaphoreCount		= static_cast<uint32_t>(SignalSemaphores.size());
+		submitInfo.pSignalSemaphores		= SignalSemaphores.data();
+	}
+}
+//-----------------------------------------------------------------------------